@@ -0,0 +1,34 @@
+#pragma once
+#include "imgui.h"
+#include <vector>
+
+namespace SC {
+    /**
+     A deep copy of ImDrawData. ImGui reuses its draw lists on the next NewFrame, so a frame that is rendered
+     on another thread, or later, has to own its vertices, indices and commands.
+     */
+    struct DrawDataSnapshot {
+        ImDrawData data;
+        std::vector<ImDrawList*> lists;
+
+        DrawDataSnapshot() = default;
+        DrawDataSnapshot(const DrawDataSnapshot&) = delete;
+        DrawDataSnapshot& operator=(const DrawDataSnapshot&) = delete;
+        ~DrawDataSnapshot() { clear(); }
+
+        void copy(const ImDrawData *source) {
+            clear();
+            if (!source) return;
+            data = *source;
+            for (int i = 0; i < source->CmdListsCount; ++i)
+                lists.push_back(source->CmdLists[i]->CloneOutput());
+            data.CmdLists = lists.empty() ? nullptr : lists.data();
+        }
+        void clear() {
+            for (ImDrawList *list : lists) IM_DELETE(list);
+            lists.clear();
+            data = ImDrawData();
+        }
+        bool valid() const { return data.Valid; }
+    };
+}
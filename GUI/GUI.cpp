@@ -1,16 +1,21 @@
 #include <stdexcept>
 #include "GUI.h"
+#include "GUIWindow.h"
 #include <iostream>
+#include <thread>
 
 using namespace SC;
 
 GUI_base *GUI_base::ptrInstance;
-GUI_base::GUI_base():window_(nullptr){
+bool GUI_base::bHeadless_ = false;
+std::mutex GUI_base::backendMutex_;
+GUI_base::GUI_base():window_(nullptr), imguiContext_(nullptr), bRenderThread_(false), bRendering_(false){
     ptrInstance=this;
     init();
 }
 GUI_base::~GUI_base(){
     // Cleanup
+    windows_.clear(); // stops their render threads, uses the shared font atlas
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -45,6 +50,7 @@ void GUI_base::init() {
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);  // 3.2+ only
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);            // 3.0+ only
 #endif
+    if (bHeadless_) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 }
 
 void GUI_base::initWindow(const std::string& name, int width, int height) {
@@ -58,6 +64,8 @@ void GUI_base::initWindow(const std::string& name, int width, int height) {
     }
 
     glfwMakeContextCurrent(window_->window);
+    if (bHeadless_) glfwSwapInterval(0);
+    glfwSetWindowUserPointer(window_->window, this);
     glfwSetKeyCallback(window_->window, key_callback);
     glfwSetMouseButtonCallback(window_->window, mouse_button_callback);
     glfwSetCursorPosCallback(window_->window, mouse_callback);
@@ -95,7 +103,7 @@ void GUI_base::initWindow(const std::string& name, int width, int height) {
 
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
-    ImGui::CreateContext();
+    imguiContext_ = ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO(); (void)io;
 //    io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
     //io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
@@ -120,27 +128,124 @@ void GUI_base::initWindow(const std::string& name, int width, int height) {
 
 
 void GUI_base::run() {
+    if (bRenderThread_) {
+        runThreaded();
+        return;
+    }
+    while(!glfwWindowShouldClose(window_->window))
+        renderFrame();
+}
+
+void GUI_base::renderFrame() {
+    glfwPollEvents();
+    ImGui_ImplOpenGL3_NewFrame();
+    ImGui_ImplGlfw_NewFrame();
+    ImGui::NewFrame();
+
+    drawUI();
+
+    ImGui::Render();
+
+    int display_w, display_h;
+    glfwGetFramebufferSize(window_->window, &display_w, &display_h);
+    glViewport(0, 0, display_w, display_h);
+    glClearColor(0.6f, 0.6f, 0.6f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    drawGL();
+
+    renderDrawData(ImGui::GetDrawData());
+    glfwSwapBuffers(window_->window);
+
+    for (auto it = windows_.begin(); it != windows_.end();) {
+        if ((*it)->shouldClose()) {
+            it = windows_.erase(it);
+            continue;
+        }
+        (*it)->frame();
+        ++it;
+    }
+}
+
+void GUI_base::runThreaded() {
+    // the device objects of the ImGui renderer are created here, the render thread only uses them
+    ImGui_ImplOpenGL3_NewFrame();
+    glfwMakeContextCurrent(nullptr);
+    bRendering_ = true;
+    std::thread renderThread(&GUI_base::renderLoop, this);
+
     while(!glfwWindowShouldClose(window_->window)) {
+        // Callbacks only record input, so events are handled outside the lock. Until the render thread took the
+        // last UI frame, wait for input instead of building frames nobody draws.
+        if (frames_.pending()) {
+            glfwWaitEventsTimeout(0.001);
+            continue;
+        }
         glfwPollEvents();
-        ImGui_ImplOpenGL3_NewFrame();
+
+        std::lock_guard<std::mutex> lock(stateMutex_);
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
         drawUI();
 
         ImGui::Render();
+        Frame &frame = frames_.back();
+        frame.ui.copy(ImGui::GetDrawData());
+        glfwGetFramebufferSize(window_->window, &frame.width, &frame.height);
+        frames_.publish();
+
+        for (auto it = windows_.begin(); it != windows_.end();) {
+            if ((*it)->shouldClose()) {
+                it = windows_.erase(it);
+                continue;
+            }
+            (*it)->frame();
+            ++it;
+        }
+    }
+
+    bRendering_ = false;
+    renderThread.join();
+    glfwMakeContextCurrent(window_->window);
+}
 
-        int display_w, display_h;
-        glfwGetFramebufferSize(window_->window, &display_w, &display_h);
-        glViewport(0, 0, display_w, display_h);
+void GUI_base::renderLoop() {
+    glfwMakeContextCurrent(window_->window);
+    while (bRendering_) {
+        // the newest UI frame if there is one, otherwise the scene is redrawn under the previous UI
+        frames_.update();
+        const Frame &frame = frames_.front();
+        if (frame.width <= 0 || frame.height <= 0) { // nothing built yet, or minimized
+            std::this_thread::yield();
+            continue;
+        }
+        glViewport(0, 0, frame.width, frame.height);
         glClearColor(0.6f, 0.6f, 0.6f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        drawGL();
-
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        {
+            std::lock_guard<std::mutex> lock(stateMutex_);
+            drawGL();
+        }
+        // non-threaded secondary windows draw their UI from the main thread through the same backend objects
+        if (frame.ui.valid()) renderDrawData(const_cast<ImDrawData *>(&frame.ui.data));
         glfwSwapBuffers(window_->window);
     }
+    glfwMakeContextCurrent(nullptr);
+}
+
+GUIWindow *GUI_base::addWindow(const std::string &name, int width, int height, bool bOwnThread) {
+    if (!window_ || !imguiContext_)
+        throw std::runtime_error("Call initWindow before adding windows.\n");
+    ImGui::SetCurrentContext(imguiContext_);
+    windows_.emplace_back(new GUIWindow(name, width, height, window_->window, ImGui::GetIO().Fonts, bOwnThread));
+    return windows_.back().get();
+}
+
+void GUI_base::renderDrawData(ImDrawData *data) {
+    std::lock_guard<std::mutex> lock(backendMutex_);
+    ImGui_ImplOpenGL3_RenderDrawData(data);
+    glFlush(); // the draws are queued before another context respecifies the shared buffers
 }
 
 void GUI_base::drawGL() {}
@@ -167,7 +272,8 @@ void GUI_base::key_callback_impl(GLFWwindow* window, int key, int scancode, int
 }
 
 void GUI_base::framebuffer_size_callback_impl(GLFWwindow* window, int width, int height){
-    glViewport(0, 0, width, height);
+    if (!bRenderThread_) // otherwise the render thread sets it from the frame size
+        glViewport(0, 0, width, height);
 }
 
 inline void GUI_base::scroll_callback_impl(GLFWwindow* window, double xoffset, double yoffset){
@@ -19,9 +19,17 @@ using namespace gl;
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
+#include "DrawDataSnapshot.h"
+#include "TripleBuffer.h"
+
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <utility>
+#include <memory>
+#include <vector>
 namespace SC{
+    class GUIWindow;
 //    #define GUIInstance GUI::getInstance()
     enum DisplayMode {RGB, DEPTH};
 
@@ -31,9 +39,11 @@ namespace SC{
         int runtimeWidth{}, runtimeHeight{};
 //        float nearPlane=0.4, farPlane=500.f;
         std::string name_;
-        GLFWWindowContainer(std::string name, int width, int height, float nearPlane=0.4, float farPlane=500.f):
+        /// share: a window whose GL objects the new context shares, or nullptr
+        GLFWWindowContainer(std::string name, int width, int height, float nearPlane=0.4, float farPlane=500.f,
+                            GLFWwindow* share=nullptr):
         name_(std::move(name)), width(width),height(height){
-            window = glfwCreateWindow(width,height,name_.c_str(),nullptr,nullptr);
+            window = glfwCreateWindow(width,height,name_.c_str(),nullptr,share);
         }
         ~GLFWWindowContainer(){
             glfwDestroyWindow(window);
@@ -52,31 +62,70 @@ namespace SC{
 
         void run();
 
+        /**
+         Create the windows hidden and swap without waiting for vsync, e.g. for benchmarks that drive the frames
+         themselves with renderFrame(). Call before constructing the GUI.
+         */
+        static void setHeadless(bool option) { bHeadless_ = option; }
+        static bool isHeadless() { return bHeadless_; }
+
+        /**
+         Render on a dedicated thread that owns the GL context. The main thread then only processes GLFW events
+         and builds the UI, handing each UI frame over through a lock-free triple buffer; the render thread draws
+         drawGL() and the newest UI frame and waits for vsync without holding up input. drawUI() and drawGL()
+         never run at the same time (see stateMutex_), but event callbacks do run concurrently with drawGL().
+         The UI itself is drawn through renderDrawData, serialised with the windows drawn on the main thread.
+         Call before run().
+         */
+        void setRenderThread(bool option) { bRenderThread_ = option; }
+        bool isRenderThread() const { return bRenderThread_; }
+
+        /**
+         Open another window that shares this window's GL objects and has its own ImGui context, e.g. an RGB
+         or depth view. With bOwnThread it draws on its own render thread. Closed windows are removed in run().
+         Call after initWindow.
+         */
+        GUIWindow *addWindow(const std::string &name, int width, int height, bool bOwnThread = false);
+        const std::vector<std::unique_ptr<GUIWindow>> &windows() const { return windows_; }
+
+        /**
+         Draw ImGui draw data into the current context with the OpenGL3 backend. The backend keeps one VBO, EBO
+         and program for the whole process, shared by all windows, so every window and thread must draw its UI
+         through here: the calls are serialised and each is flushed before the next context refills the buffers.
+         */
+        static void renderDrawData(ImDrawData *data);
+
         /// Draw ImGUI related
         virtual void drawUI();
         /// Draw OpenGL related
         virtual void drawGL();
 
     protected:
+        /// The GUI_base a window belongs to. Falls back to the last created instance.
+        static GUI_base& instanceOf(GLFWwindow* window)
+        {
+            auto *instance = static_cast<GUI_base*>(glfwGetWindowUserPointer(window));
+            return instance ? *instance : *ptrInstance;
+        }
         // Call Back Functions
         static void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods){
-            getInstance().key_callback_impl(window, key, scancode, action, mods);
+            instanceOf(window).key_callback_impl(window, key, scancode, action, mods);
         }
         virtual void key_callback_impl(GLFWwindow* window, int key, int scancode, int action, int mods);
         static void mouse_button_callback(GLFWwindow* window, int button, int action, int mods){
-            getInstance().mouse_button_callback_impl(window, button, action, mods);
+            instanceOf(window).mouse_button_callback_impl(window, button, action, mods);
         }
         virtual void mouse_button_callback_impl(GLFWwindow* window, int button, int action, int mods);
         static void mouse_callback(GLFWwindow* window, double xpos, double ypos){
-            getInstance().mouse_callback_impl(window, xpos, ypos);
+            instanceOf(window).mouse_callback_impl(window, xpos, ypos);
         }
         virtual void mouse_callback_impl(GLFWwindow* window, double xpos, double ypos);
         static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset){
-            getInstance().scroll_callback_impl(window, xoffset, yoffset);
+            instanceOf(window).scroll_callback_impl(window, xoffset, yoffset);
         }
         virtual void scroll_callback_impl(GLFWwindow* window, double xoffset, double yoffset);
         static void framebuffer_size_callback(GLFWwindow* window, int width, int height){
-            getInstance().framebuffer_size_callback_impl(window, width, height);
+            instanceOf(window).framebuffer_size_callback_impl(window, width, height);
         }
         virtual void framebuffer_size_callback_impl(GLFWwindow* window, int width, int height);
         static void error_callback(int error, const char* description){
@@ -84,11 +133,32 @@ namespace SC{
         }
         virtual void error_callback_impl(int error, const char* description);
 
+        /// One iteration of run(): events, UI, drawGL() and the swap. Not for the render thread mode.
+        void renderFrame();
+
         static GUI_base *ptrInstance;
+        static bool bHeadless_;
+        static std::mutex backendMutex_; // see renderDrawData
         GLFWWindowContainer *window_;
+        ImGuiContext *imguiContext_;
+        std::vector<std::unique_ptr<GUIWindow>> windows_;
+
+        /// Held by the main thread while it builds the UI and by the render thread during drawGL().
+        std::mutex stateMutex_;
+        bool bRenderThread_;
     private:
         std::string glsl_version;
 
+        // render thread mode: UI frames from the main thread, the newest one is drawn
+        struct Frame {
+            DrawDataSnapshot ui;
+            int width = 0, height = 0; // framebuffer
+        };
+        TripleBuffer<Frame> frames_;
+        std::atomic<bool> bRendering_;
+
         void init();
+        void runThreaded();
+        void renderLoop();
     };
 }
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include <cfloat>
+#include "GUIWindow.h"
+
+using namespace SC;
+
+GUIWindow::GUIWindow(const std::string &name, int width, int height, GLFWwindow *share, ImFontAtlas *fonts,
+                     bool bOwnThread)
+        : imgui_(nullptr), time_(0), wheel_(0), wheelH_(0), mods_(0), bOwnThread_(bOwnThread), bPending_(false),
+          bRunning_(false), fpsTime_(0), fpsCount_(0), renderFPS_(0), dropped_(0) {
+    std::fill(mouseJustPressed_, mouseJustPressed_ + 3, false);
+    std::fill(keysDown_, keysDown_ + 512, false);
+    GLFWwindow *previous = glfwGetCurrentContext();
+
+    // created with the hints GUI_base set up, sharing the objects of the main context
+    container_.reset(new GLFWWindowContainer(name, width, height, 0.4f, 500.f, share));
+    if (!container_->window)
+        throw std::runtime_error("Failed to create GLFW window \"" + name + "\"");
+    glfwSetWindowUserPointer(container_->window, this);
+    glfwSetKeyCallback(container_->window, key_callback);
+    glfwSetCharCallback(container_->window, char_callback);
+    glfwSetMouseButtonCallback(container_->window, mouse_button_callback);
+    glfwSetScrollCallback(container_->window, scroll_callback);
+    glfwGetFramebufferSize(container_->window, &container_->runtimeWidth, &container_->runtimeHeight);
+
+    glfwMakeContextCurrent(container_->window);
+    glfwSwapInterval(bOwnThread_ ? 1 : 0);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glfwMakeContextCurrent(previous);
+
+    // own ImGui context with the font atlas (and so the font texture) of the main window
+    ImGuiContext *previousContext = ImGui::GetCurrentContext();
+    imgui_ = ImGui::CreateContext(fonts);
+    ImGui::SetCurrentContext(imgui_);
+    ImGui::StyleColorsDark();
+    ImGuiIO &io = ImGui::GetIO();
+    io.KeyMap[ImGuiKey_Tab] = GLFW_KEY_TAB;
+    io.KeyMap[ImGuiKey_LeftArrow] = GLFW_KEY_LEFT;
+    io.KeyMap[ImGuiKey_RightArrow] = GLFW_KEY_RIGHT;
+    io.KeyMap[ImGuiKey_UpArrow] = GLFW_KEY_UP;
+    io.KeyMap[ImGuiKey_DownArrow] = GLFW_KEY_DOWN;
+    io.KeyMap[ImGuiKey_PageUp] = GLFW_KEY_PAGE_UP;
+    io.KeyMap[ImGuiKey_PageDown] = GLFW_KEY_PAGE_DOWN;
+    io.KeyMap[ImGuiKey_Home] = GLFW_KEY_HOME;
+    io.KeyMap[ImGuiKey_End] = GLFW_KEY_END;
+    io.KeyMap[ImGuiKey_Insert] = GLFW_KEY_INSERT;
+    io.KeyMap[ImGuiKey_Delete] = GLFW_KEY_DELETE;
+    io.KeyMap[ImGuiKey_Backspace] = GLFW_KEY_BACKSPACE;
+    io.KeyMap[ImGuiKey_Space] = GLFW_KEY_SPACE;
+    io.KeyMap[ImGuiKey_Enter] = GLFW_KEY_ENTER;
+    io.KeyMap[ImGuiKey_Escape] = GLFW_KEY_ESCAPE;
+    io.KeyMap[ImGuiKey_A] = GLFW_KEY_A;
+    io.KeyMap[ImGuiKey_C] = GLFW_KEY_C;
+    io.KeyMap[ImGuiKey_V] = GLFW_KEY_V;
+    io.KeyMap[ImGuiKey_X] = GLFW_KEY_X;
+    io.KeyMap[ImGuiKey_Y] = GLFW_KEY_Y;
+    io.KeyMap[ImGuiKey_Z] = GLFW_KEY_Z;
+    ImGui::SetCurrentContext(previousContext);
+
+    if (bOwnThread_) {
+        built_.reset(new Frame());
+        pending_.reset(new Frame());
+        rendering_.reset(new Frame());
+        bRunning_ = true;
+        thread_ = std::thread(&GUIWindow::renderLoop, this);
+    }
+}
+
+GUIWindow::~GUIWindow() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            bRunning_ = false;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+    // the snapshots hold draw lists of this context
+    built_.reset();
+    pending_.reset();
+    rendering_.reset();
+    ImGuiContext *previousContext = ImGui::GetCurrentContext();
+    ImGui::DestroyContext(imgui_);
+    if (previousContext != imgui_) ImGui::SetCurrentContext(previousContext);
+}
+
+void GUIWindow::frame() {
+    int width, height;
+    glfwGetFramebufferSize(container_->window, &width, &height);
+    container_->runtimeWidth = width;
+    container_->runtimeHeight = height;
+
+    ImGuiContext *previousContext = ImGui::GetCurrentContext();
+    ImGui::SetCurrentContext(imgui_);
+    buildUI(width, height);
+
+    if (bOwnThread_) {
+        built_->ui.copy(ImGui::GetDrawData());
+        built_->width = width;
+        built_->height = height;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (bPending_) dropped_++;
+            std::swap(built_, pending_);
+            bPending_ = true;
+        }
+        cv_.notify_one();
+    } else {
+        GLFWwindow *previous = glfwGetCurrentContext();
+        glfwMakeContextCurrent(container_->window);
+        render(ImGui::GetDrawData(), width, height);
+        glfwSwapBuffers(container_->window);
+        glfwMakeContextCurrent(previous);
+        updateFPS();
+    }
+    ImGui::SetCurrentContext(previousContext);
+}
+
+void GUIWindow::buildUI(int width, int height) {
+    // what ImGui_ImplGlfw does for the main window, which it keeps in globals
+    ImGuiIO &io = ImGui::GetIO();
+    GLFWwindow *window = container_->window;
+    int windowWidth, windowHeight;
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+    io.DisplaySize = ImVec2(float(windowWidth), float(windowHeight));
+    if (windowWidth > 0 && windowHeight > 0)
+        io.DisplayFramebufferScale = ImVec2(float(width) / windowWidth, float(height) / windowHeight);
+    const double now = glfwGetTime();
+    io.DeltaTime = time_ > 0 ? std::max(float(now - time_), 1e-5f) : 1.f / 60.f;
+    time_ = now;
+
+    if (glfwGetWindowAttrib(window, GLFW_FOCUSED)) {
+        double x, y;
+        glfwGetCursorPos(window, &x, &y);
+        io.MousePos = ImVec2(float(x), float(y));
+    } else {
+        io.MousePos = ImVec2(-FLT_MAX, -FLT_MAX);
+    }
+    for (int i = 0; i < 3; ++i) {
+        // a click shorter than a frame still counts
+        io.MouseDown[i] = mouseJustPressed_[i] || glfwGetMouseButton(window, i) == GLFW_PRESS;
+        mouseJustPressed_[i] = false;
+    }
+    io.MouseWheel += wheel_;
+    io.MouseWheelH += wheelH_;
+    wheel_ = wheelH_ = 0;
+    std::copy(keysDown_, keysDown_ + 512, io.KeysDown);
+    io.KeyShift = (mods_ & GLFW_MOD_SHIFT) != 0;
+    io.KeyCtrl = (mods_ & GLFW_MOD_CONTROL) != 0;
+    io.KeyAlt = (mods_ & GLFW_MOD_ALT) != 0;
+    io.KeySuper = (mods_ & GLFW_MOD_SUPER) != 0;
+    for (unsigned int c : chars_) io.AddInputCharacter(c);
+    chars_.clear();
+
+    ImGui::NewFrame();
+    drawUI();
+    ImGui::Render();
+}
+
+void GUIWindow::render(const ImDrawData *ui, int width, int height) {
+    glViewport(0, 0, width, height);
+    glClearColor(0.6f, 0.6f, 0.6f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    drawGL();
+    if (ui && ui->Valid) GUI_base::renderDrawData(const_cast<ImDrawData *>(ui)); // serialised with the other windows
+}
+
+void GUIWindow::renderLoop() {
+    glfwMakeContextCurrent(container_->window);
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return bPending_ || !bRunning_; });
+            if (!bRunning_) break;
+            std::swap(pending_, rendering_);
+            bPending_ = false;
+        }
+        if (rendering_->width <= 0 || rendering_->height <= 0) continue; // minimized
+        render(&rendering_->ui.data, rendering_->width, rendering_->height);
+        glfwSwapBuffers(container_->window);
+        updateFPS();
+    }
+    glfwMakeContextCurrent(nullptr);
+}
+
+void GUIWindow::updateFPS() {
+    const double now = glfwGetTime();
+    if (fpsTime_ == 0) fpsTime_ = now;
+    if (++fpsCount_, now - fpsTime_ >= 0.5) {
+        renderFPS_ = fpsCount_ / (now - fpsTime_);
+        fpsTime_ = now;
+        fpsCount_ = 0;
+    }
+}
+
+void GUIWindow::key_callback(GLFWwindow *window, int key, int scancode, int action, int mods) {
+    GUIWindow *self = from(window);
+    if (key >= 0 && key < 512) {
+        if (action == GLFW_PRESS) self->keysDown_[key] = true;
+        if (action == GLFW_RELEASE) self->keysDown_[key] = false;
+    }
+    self->mods_ = mods;
+}
+
+void GUIWindow::char_callback(GLFWwindow *window, unsigned int c) {
+    from(window)->chars_.push_back(c);
+}
+
+void GUIWindow::mouse_button_callback(GLFWwindow *window, int button, int action, int mods) {
+    if (action == GLFW_PRESS && button >= 0 && button < 3) from(window)->mouseJustPressed_[button] = true;
+}
+
+void GUIWindow::scroll_callback(GLFWwindow *window, double xoffset, double yoffset) {
+    GUIWindow *self = from(window);
+    self->wheelH_ += float(xoffset);
+    self->wheel_ += float(yoffset);
+}
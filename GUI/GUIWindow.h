@@ -0,0 +1,95 @@
+#pragma once
+#include "GUI.h"
+#include "DrawDataSnapshot.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SC {
+    /**
+     An additional window next to the GUI_base main window, e.g. an RGB or depth view of the same session.
+
+     The GL context is shared with the main window: textures, buffers, shaders and renderbuffers created in one
+     are usable in the other, container objects (VAOs, FBOs) are not. Each window has its own ImGui context that
+     shares the font atlas of the main one.
+
+     The UI is always built on the main thread, since GLFW input and ImGui's current context are not thread
+     safe. Drawing happens either on the main thread right after the main window (swap interval 0, so only the
+     main window waits for vsync), or, with bOwnThread, on a render thread of this window that owns its context
+     and renders the latest UI snapshot, so a slow view never stalls the others. Textures updated in another
+     context need a glFlush (or a fence) there before this window can see the new content.
+     */
+    class GUIWindow {
+    public:
+        /// Main thread. Use GUI_base::addWindow.
+        GUIWindow(const std::string &name, int width, int height, GLFWwindow *share, ImFontAtlas *fonts,
+                  bool bOwnThread = false);
+        virtual ~GUIWindow();
+
+        /// ImGui of this window. Main thread, with this window's ImGui context current.
+        void setDrawUI(std::function<void()> func) { drawUI_ = std::move(func); }
+        /// GL content of this window, drawn before the UI with this window's GL context current. On the render
+        /// thread if the window has one.
+        void setDrawGL(std::function<void()> func) { drawGL_ = std::move(func); }
+
+        /// Main thread, once per main loop iteration. Leaves the main window's contexts current.
+        void frame();
+
+        bool shouldClose() const { return glfwWindowShouldClose(container_->window); }
+        bool isThreaded() const { return bOwnThread_; }
+        GLFWWindowContainer *container() { return container_.get(); }
+        /// Frames drawn per second, measured where the drawing happens.
+        double renderFPS() const { return renderFPS_.load(); }
+        /// UI frames the render thread skipped because a newer one arrived first.
+        size_t droppedFrames() const { return dropped_.load(); }
+
+    protected:
+        virtual void drawUI() { if (drawUI_) drawUI_(); }
+        virtual void drawGL() { if (drawGL_) drawGL_(); }
+
+    private:
+        std::unique_ptr<GLFWWindowContainer> container_;
+        ImGuiContext *imgui_;
+        std::function<void()> drawUI_, drawGL_;
+        double time_;
+
+        // input collected by the callbacks (main thread) for the next UI frame
+        bool mouseJustPressed_[3];
+        float wheel_, wheelH_;
+        std::vector<unsigned int> chars_;
+        bool keysDown_[512];
+        int mods_;
+
+        // render thread: built -> pending -> rendering, swapped under the mutex so neither side waits long
+        struct Frame {
+            DrawDataSnapshot ui;
+            int width = 0, height = 0; // framebuffer
+        };
+        bool bOwnThread_;
+        std::thread thread_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::unique_ptr<Frame> built_, pending_, rendering_;
+        bool bPending_, bRunning_;
+        double fpsTime_;  // touched only where the drawing happens
+        int fpsCount_;
+        std::atomic<double> renderFPS_;
+        std::atomic<size_t> dropped_;
+
+        void buildUI(int width, int height);
+        void render(const ImDrawData *ui, int width, int height);
+        void renderLoop();
+        void updateFPS();
+
+        static GUIWindow *from(GLFWwindow *window) { return static_cast<GUIWindow *>(glfwGetWindowUserPointer(window)); }
+        static void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
+        static void char_callback(GLFWwindow *window, unsigned int c);
+        static void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
+        static void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace SC {
+    /**
+     Lock-free hand-over of the newest value from one producer thread to one consumer thread. The producer
+     writes into back() and publishes it; the consumer picks up the newest published value with update() and
+     reads front(). Neither side ever waits: the three slots are exchanged through one atomic index, and a value
+     the consumer did not pick up in time is overwritten by the next one.
+     */
+    template <typename T>
+    class TripleBuffer {
+    public:
+        TripleBuffer() : back_(0), middle_(1), front_(2) {}
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        /// Producer.
+        T &back() { return slots_[back_]; }
+        void publish() { back_ = middle_.exchange(back_ | kFresh, std::memory_order_acq_rel) & kIndex; }
+        /// Producer. True while the last published value has not been picked up.
+        bool pending() const { return (middle_.load(std::memory_order_acquire) & kFresh) != 0; }
+
+        /// Consumer. Switch front() to the newest published value; false if there is none since the last call.
+        bool update() {
+            if (!pending()) return false;
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndex;
+            return true;
+        }
+        const T &front() const { return slots_[front_]; }
+        T &front() { return slots_[front_]; }
+
+    private:
+        static const uint8_t kIndex = 0x3, kFresh = 0x4;
+        T slots_[3];
+        uint8_t back_;                // producer only
+        std::atomic<uint8_t> middle_; // slot index, kFresh when published and not yet taken
+        uint8_t front_;               // consumer only
+    };
+}
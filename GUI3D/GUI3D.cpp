@@ -1,4 +1,5 @@
 #include "GUI3D.h"
+#include <glm/gtc/quaternion.hpp>
 using namespace SC;
 
 GUI3D::GUI3D(const std::string &name, int width, int height){
@@ -6,7 +7,34 @@ GUI3D::GUI3D(const std::string &name, int width, int height){
     fps_ = new FPSManager();
     bShowFPS = bShowGrid = false;
     bPlotTrajectory = true;
+    bPicking = false;
+    rgbdDisplayMode_ = RGB;
+    bShowRGBDStream = bShowRGBDCloud = true;
+    bRGBDWindows = false;
+    rgbdMinDepth = 0.2f;
+    rgbdMaxDepth = 5.f;
+    rgbdPointSize = 1.f;
+    rgbdPose_ = glm::scale(glm::mat4(1.f), glm::vec3(1.f, -1.f, 1.f)); // image y points down
+    renderScale_ = 1.f;
+    internalWidth_ = internalHeight_ = 0;
+    bSceneInWindow = bSceneHovered = false;
+    bShowRenderUI = true;
+    sceneRect_ = glm::vec4(0, 0, width, height);
+    dynamicResolution_.setTargetFPS(fps_->getTargetFPS());
+    bDynamicResolution = false;
+    bShowShadowUI = true;
+    bShowLightingUI = true;
+    bOIT = false;
+    rgbdCloudOpacity = 1.f;
     bShowCameraUI=true;//todo: not here
+    mainViewRect_ = glm::vec4(0, 0, 1, 1);
+    activeView_ = -1;
+    sceneDrawCount_ = 0;
+    uploadBudget_ = 4 << 20;
+    maxStreamedPoints_ = 1 << 21;
+    streamedPointSize_ = 2.f;
+    bRecording_ = false;
+    recordingStart_ = 0;
 
     camPose = glm::vec3(0.0f, 0.f,  -4.5f);
     camUp = glm::vec3(0.f, 1.f, 0.f);
@@ -30,6 +58,10 @@ GUI3D::~GUI3D(){
         glDeleteBuffers(1, &vbo.second);
     for (auto fbo : glFrameBuffers)
         glDeleteFramebuffers(1, &fbo.second);
+    for (auto &trajectory : trajectories_) {
+        glDeleteVertexArrays(1, &trajectory.second.vao);
+        glDeleteBuffers(1, &trajectory.second.vbo);
+    }
     delete fps_;
 }
 
@@ -45,25 +77,390 @@ int GUI3D::init(){
 
 void GUI3D::drawUI() {
     GUI_base::drawUI();
+    sceneUI();
+    renderUI();
+    shadowUI();
+    lightingUI();
     cameraUI();
+    pickingUI();
+    rgbdStreamUI();
 
     glCam->drawUI();
-    mouseControl();
+    if(!playback_)
+        mouseControl();
 }
 
 void GUI3D::drawGL(){
+    processPlayback();
     processInput(window_->window);
-    basicProcess();
+    processIngest();
+
+    // GPU time of an earlier frame's scene pass drives the internal resolution
+    float gpuMs;
+    if(sceneTimer_->poll(gpuMs) && bDynamicResolution)
+        renderScale_ = dynamicResolution_.update(gpuMs, glfwGetTime());
+
+    updateSceneTarget();
+    sceneTimer_->begin();
+    sceneTarget_->bind();
+    glClearColor(0.6f, 0.6f, 0.6f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    renderScene();
+    sceneTarget_->unbind();
+    sceneTimer_->end();
+    if(!bSceneInWindow)
+        compositeScene();
+    drawOverlay();
+
+    if(bPicking && bSceneHovered)
+        pickingPass(glCam->projection_control_->projection_matrix());
+}
+
+void GUI3D::renderScene(){
+    collectViews();
+
+    // one traversal for all views: world bounds, frustum tests and the sort by shader are shared
+    sceneGraph_.update();
+    cullItems_.resize(sceneObjects_.size());
+    for(size_t i = 0; i < sceneObjects_.size(); ++i) {
+        SceneObject &object = sceneObjects_[i];
+        if(object.node != SC::SceneGraph::kNone)
+            object.transform = glm::make_mat4(sceneGraph_.world(object.node));
+        cullItems_[i] = SC::CullItem::fromBounds(&object.boundsMin[0], &object.boundsMax[0], &object.transform[0][0],
+                                                 object.shaderKey);
+    }
+    std::vector<glm::mat4> viewProjections;
+    for(const auto &view : frameViews_) viewProjections.push_back(view.projection * view.view);
+    culler_.setViews(&viewProjections[0][0][0], static_cast<int>(viewProjections.size()));
+    culler_.cull(cullItems_.data(), static_cast<int>(cullItems_.size()));
+
+    // per frame: shadow cascades follow the main camera, the stream is uploaded once
+    if(shadows_) {
+        const FrameView &main = frameViews_[0];
+        shadows_->update(main.view, main.projection, glCam->projection_control_->near_plane(),
+                         glCam->projection_control_->far_plane());
+        glUtil::Shader *shader = glShaders["ShadowLighting"];
+        shader->use();
+        shadows_->bind(shader, 4);
+    }
+    if(rgbdStream_)
+        updateRGBDStream();
+
+    sceneDrawCount_ = 0;
+    for(int i = 0; i < static_cast<int>(frameViews_.size()); ++i) {
+        applyView(i);
+        drawSceneObjects(i);
+        basicProcess();
+        drawIngested();
+        if(rgbdStream_)
+            processRGBDStream(currentView_.projection);
+    }
+
+    if(bOIT) {
+        oit_->resize(sceneTarget_->width(), sceneTarget_->height());
+        oit_->begin(sceneTarget_->getDepthTexture());
+        for(int i = 0; i < static_cast<int>(frameViews_.size()); ++i) {
+            // the clusters were built in the opaque pass; nothing transparent is lit by them
+            applyView(i, false);
+            transparentPass(currentView_.projection);
+        }
+        oit_->end();
+        oit_->composite();
+    }
+    glViewport(0, 0, sceneTarget_->width(), sceneTarget_->height());
+    currentView_ = frameViews_[0];
+}
+
+void GUI3D::collectViews(){
+    const int width = sceneTarget_->width(), height = sceneTarget_->height();
+    auto viewport = [&](const glm::vec4 &rect) {
+        return glm::ivec4(static_cast<int>(rect.x * width), static_cast<int>(rect.y * height),
+                          std::max(1, static_cast<int>(rect.z * width)), std::max(1, static_cast<int>(rect.w * height)));
+    };
+    frameViews_.resize(numViews());
+    FrameView &main = frameViews_[0];
+    main.viewport = viewport(mainViewRect_);
+    glCam->setSize(main.viewport.z, main.viewport.w);
+    main.view = glCam->camera_control_->GetViewMatrix();
+    main.projection = glCam->projection_control_->projection_matrix();
+    main.position = glCam->camera_control_->Position;
+    for(size_t i = 0; i < views_.size(); ++i) {
+        FrameView &frameView = frameViews_[i + 1];
+        frameView.viewport = viewport(views_[i].rect);
+        views_[i].projection->setSize(frameView.viewport.z, frameView.viewport.w);
+        frameView.view = views_[i].camera->GetViewMatrix();
+        frameView.projection = views_[i].projection->projection_matrix();
+        frameView.position = views_[i].camera->Position;
+    }
+    currentView_ = main;
+}
+
+void GUI3D::applyView(int i, bool bLights){
+    currentView_ = frameViews_[i];
+    const glm::ivec4 &viewport = currentView_.viewport;
+    glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+    if(shadows_) {
+        glUtil::Shader *shader = glShaders["ShadowLighting"];
+        shader->use();
+        shader->set("projection", currentView_.projection);
+        shader->set("view", currentView_.view);
+        shader->set("viewPos", currentView_.position);
+    }
+    if(clusteredLights_ && bLights) {
+        // the froxel grid is per view; the viewport must be set before bind
+        const SC::ProjectionControl &projection = i == 0 ? *glCam->projection_control_ : *views_[i - 1].projection;
+        clusteredLights_->update(currentView_.view, currentView_.projection, projection.near_plane(),
+                                 projection.far_plane(), projection.isOrthographic());
+        glUtil::Shader *shader = glShaders["ClusteredLighting"];
+        shader->use();
+        shader->set("projection", currentView_.projection);
+        shader->set("view", currentView_.view);
+        shader->set("viewPos", currentView_.position);
+        clusteredLights_->bind(shader, 9); // after the shadow maps
+    }
+}
+
+void GUI3D::drawSceneObjects(int view){
+    // the list is sorted by shader: set the view uniforms once per shader and view
+    glUtil::Shader *current = nullptr;
+    for(uint32_t index : culler_.visible(view)) {
+        SceneObject &object = sceneObjects_[index];
+        if(object.shader != current) {
+            current = object.shader;
+            current->use();
+            current->set("view", currentView_.view);
+            current->set("projection", currentView_.projection);
+        }
+        current->set("model", object.transform);
+        object.object->setShader(current);
+        object.object->Draw();
+        sceneDrawCount_++;
+    }
+}
+
+int GUI3D::addSceneObject(const std::string &name, const std::string &shaderName, const glm::vec3 &boundsMin,
+                          const glm::vec3 &boundsMax, const glm::mat4 &transform){
+    if(glObjests.find(name) == glObjests.end())
+        throw std::runtime_error("Scene object \"" + name + "\" is not in glObjests.");
+    if(glShaders.find(shaderName) == glShaders.end())
+        throw std::runtime_error("Shader \"" + shaderName + "\" is not in glShaders.");
+    SceneObject object;
+    object.name = name;
+    object.object = glObjests[name];
+    object.shader = glShaders[shaderName];
+    object.shaderKey = object.shader->ID;
+    object.boundsMin = boundsMin;
+    object.boundsMax = boundsMax;
+    object.transform = transform;
+    sceneObjects_.push_back(object);
+    return static_cast<int>(sceneObjects_.size()) - 1;
+}
+
+int GUI3D::addView(const glm::vec4 &rect, std::unique_ptr<SC::CameraControlBase> camera,
+                   std::unique_ptr<SC::ProjectionControl> projection){
+    if(numViews() >= SC::MultiViewCuller::kMaxViews)
+        throw std::runtime_error("Too many views.");
+    SceneView view;
+    view.rect = rect;
+    view.camera = std::move(camera);
+    view.projection = std::move(projection);
+    views_.push_back(std::move(view));
+    return numViews() - 1;
+}
+
+void GUI3D::enableQuadView(float extent){
+    clearViews();
+    setMainViewRect(glm::vec4(0.5f, 0.5f, 0.5f, 0.5f));
+    // yaw/pitch as in CameraControl: yaw 90 looks along +z, pitch -89.9 looks down
+    struct Axis { glm::vec4 rect; glm::vec3 position; float yaw, pitch; };
+    const Axis axes[3] = {
+            {glm::vec4(0.f, 0.5f, 0.5f, 0.5f), glm::vec3(0.f, extent, 0.f), 90.f, -89.9f}, // top
+            {glm::vec4(0.f, 0.f, 0.5f, 0.5f), glm::vec3(0.f, 0.f, -extent), 90.f, 0.f},   // front
+            {glm::vec4(0.5f, 0.f, 0.5f, 0.5f), glm::vec3(-extent, 0.f, 0.f), 0.f, 0.f},   // side
+    };
+    for(const auto &axis : axes) {
+        std::unique_ptr<SC::ProjectionControl> projection(new SC::ProjectionControl(1, 1));
+        projection->setOrthographic(extent);
+        addView(axis.rect, std::unique_ptr<SC::CameraControlBase>(
+                        new SC::CameraControl(axis.position, glm::vec3(0.f, 1.f, 0.f), axis.yaw, axis.pitch)),
+                std::move(projection));
+    }
+}
+
+void GUI3D::clearViews(){
+    views_.clear();
+    mainViewRect_ = glm::vec4(0, 0, 1, 1);
+    activeView_ = -1;
+}
+
+int GUI3D::viewAt(float x, float y) const{
+    if(sceneRect_.z <= 0 || sceneRect_.w <= 0) return -1;
+    // window coordinates have a top-left origin, view rects a bottom-left one
+    const float u = (x - sceneRect_.x) / sceneRect_.z, v = 1.f - (y - sceneRect_.y) / sceneRect_.w;
+    auto inside = [u, v](const glm::vec4 &rect) {
+        return u >= rect.x && u < rect.x + rect.z && v >= rect.y && v < rect.y + rect.w;
+    };
+    for(size_t i = views_.size(); i-- > 0;)
+        if(inside(views_[i].rect)) return static_cast<int>(i) + 1;
+    return inside(mainViewRect_) ? 0 : -1;
+}
+
+void GUI3D::transparentPass(const glm::mat4 &projection){
+    if (bShowGrid) {
+        glDisable(GL_DEPTH_TEST); // the grid is an overlay
+        drawGrid(glShaders["gridOIT"], projection);
+        glEnable(GL_DEPTH_TEST);
+    }
+    if (rgbdStream_ && bShowRGBDCloud && rgbdCloudOpacity < 1.f)
+        rgbdStream_->drawPointCloud(projection, currentView_.view, rgbdPose_, rgbdPointSize, rgbdCloudOpacity);
+}
+
+glUtil::ShadowMaps *GUI3D::enableShadows(int cascadeSize, int numCascades, int cubeSize){
+    const std::string shaderPath = std::string(GUI_FOLDER_PATH) + "Shaders/";
+    shadows_.reset(new glUtil::ShadowMaps(shaderPath, cascadeSize, numCascades, cubeSize));
+    if(glShaders.find("ShadowLighting") == glShaders.end()) {
+        glShaders["ShadowLighting"] = new glUtil::Shader(shaderPath + "shadowLighting.vs", shaderPath + "shadowLighting.fs");
+        glShaders["ShadowLighting"]->use();
+        glShaders["ShadowLighting"]->set("model", glm::mat4(1.f));
+        glShaders["ShadowLighting"]->set("objectColor", glm::vec3(0.8f));
+    }
+    return shadows_.get();
+}
+
+int GUI3D::addShadowCaster(const std::string &name, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax,
+                           const glm::mat4 &transform, bool bStatic){
+    if(!shadows_)
+        throw std::runtime_error("Call enableShadows() before adding shadow casters.");
+    if(glObjests.find(name) == glObjests.end())
+        throw std::runtime_error("Shadow caster \"" + name + "\" is not in glObjests.");
+    return shadows_->addCaster(glObjests[name], boundsMin, boundsMax, transform, bStatic);
+}
+
+glUtil::ClusteredLights *GUI3D::enableClusteredLights(int tilesX, int tilesY, int depthSlices){
+    const std::string shaderPath = std::string(GUI_FOLDER_PATH) + "Shaders/";
+    clusteredLights_.reset(new glUtil::ClusteredLights(tilesX, tilesY, depthSlices));
+    if(glShaders.find("ClusteredLighting") == glShaders.end()) {
+        glUtil::Shader *shader = new glUtil::Shader(shaderPath + "clusteredLighting.vs", shaderPath + "clusteredLighting.fs");
+        shader->use();
+        shader->set("model", glm::mat4(1.f));
+        shader->setTexture("material.texture", 0);
+        shader->set("material.shininess", 32.f);
+        shader->set("dirLight.direction", glm::vec3(-0.2f, -1.0f, -0.3f));
+        shader->set("dirLight.ambient", glm::vec3(0.05f));
+        shader->set("dirLight.diffuse", glm::vec3(0.2f));
+        shader->set("dirLight.specular", glm::vec3(0.1f));
+        glShaders["ClusteredLighting"] = shader;
+    }
+    return clusteredLights_.get();
+}
+
+void GUI3D::drawOverlay(){
+    /// Draw Text
+    if (bShowFPS) {
+        glDisable(GL_DEPTH_TEST);
+        RenderText(glVertexArrays["textVAO"], glBuffers["textVBO"], glShaders["Text"],
+                   "FPS: " + std::to_string((int) std::floor(fps_->getFPS())), 10.f, 10.f, 0.5f, glm::vec3(0.5f, 0.8f, 0.2f));
+        glEnable(GL_DEPTH_TEST);
+    }
+}
+
+void GUI3D::updateSceneTarget(){
+    // The scene viewport in framebuffer pixels. On Retina the framebuffer is larger than the window.
+    // Taken from the UI frame, as GLFW window queries belong to the main thread (see setRenderThread).
+    const float pixelRatio = ImGui::GetIO().DisplayFramebufferScale.x > 0 ? ImGui::GetIO().DisplayFramebufferScale.x : 1.f;
+    int width = internalWidth_, height = internalHeight_;
+    if (width <= 0 || height <= 0) {
+        width = static_cast<int>(sceneRect_.z * pixelRatio * renderScale_);
+        height = static_cast<int>(sceneRect_.w * pixelRatio * renderScale_);
+    }
+    sceneTarget_->resize(width, height);
+    glCam->setSize(sceneTarget_->width(), sceneTarget_->height());
+}
+
+void GUI3D::compositeScene(){
+    GLboolean bDepthTest = glIsEnabled(GL_DEPTH_TEST), bBlend = glIsEnabled(GL_BLEND);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_BLEND);
+    glShaders["Screen"]->use();
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, sceneTarget_->getColorTexture());
+    glBindVertexArray(glVertexArrays["quadVAO"]);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    if (bDepthTest) glEnable(GL_DEPTH_TEST);
+    if (bBlend) glEnable(GL_BLEND);
 }
 
 void GUI3D::processInput(GLFWwindow* window) {
-    for(const auto &func : registeredFunctions_){
-        if (glfwGetKey(func.window_->window, func.key_) == GLFW_PRESS && bKeyProcessFinished[func.key_]){
-            bKeyProcessFinished[func.key_] = !bKeyProcessFinished[func.key_];
-            func.no_id();
+    // keys typed into an ImGui text field do not trigger bindings
+    const bool bKeyboardCaptured = ImGui::GetIO().WantCaptureKeyboard;
+    auto handler = [this](const SC::InputEvent &event) {
+        if(bRecording_ && event.source == window_->window) {
+            SC::InputEvent recorded = event;
+            recorded.time -= recordingStart_;
+            recording_.addEvent(recorded);
         }
-        if (glfwGetKey(func.window_->window, func.key_) == GLFW_RELEASE) bKeyProcessFinished[func.key_] = true;
+        onInputEvent(event);
+    };
+    // during a replay live input would make the run differ from the recording; this is the queue's consumer.
+    // Only Control+P gets through, so the replay can still be stopped from the keyboard.
+    if(playback_)
+        inputQueue_.discard([&](const SC::InputEvent &event) {
+            if(event.type == SC::InputEvent::Key && event.code == GLFW_KEY_P && (event.mods & GLFW_MOD_CONTROL))
+                keyBindings_.dispatch(event, !bKeyboardCaptured);
+        });
+    else
+        inputQueue_.process(keyBindings_, handler, bKeyboardCaptured);
+    for(const SC::InputEvent &event : playbackEvents_) {
+        if(event.type == SC::InputEvent::Key) keyBindings_.dispatch(event, !bKeyboardCaptured);
+        handler(event);
     }
+    playbackEvents_.clear();
+}
+
+void GUI3D::key_callback_impl(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    GUI_base::key_callback_impl(window, key, scancode, action, mods);
+    SC::InputEvent event;
+    event.type = SC::InputEvent::Key;
+    event.code = key;
+    event.action = action;
+    event.mods = mods;
+    event.time = glfwGetTime();
+    event.source = window;
+    inputQueue_.record(event);
+}
+
+void GUI3D::mouse_button_callback_impl(GLFWwindow* window, int button, int action, int mods) {
+    SC::InputEvent event;
+    event.type = SC::InputEvent::MouseButton;
+    event.code = button;
+    event.action = action;
+    event.mods = mods;
+    glfwGetCursorPos(window, &event.x, &event.y);
+    event.time = glfwGetTime();
+    event.source = window;
+    inputQueue_.record(event);
+}
+
+void GUI3D::mouse_callback_impl(GLFWwindow* window, double xpos, double ypos) {
+    SC::InputEvent event;
+    event.type = SC::InputEvent::CursorPos;
+    event.x = xpos;
+    event.y = ypos;
+    event.time = glfwGetTime();
+    event.source = window;
+    inputQueue_.record(event);
+}
+
+void GUI3D::scroll_callback_impl(GLFWwindow* window, double xoffset, double yoffset) {
+    SC::InputEvent event;
+    event.type = SC::InputEvent::Scroll;
+    event.x = xoffset;
+    event.y = yoffset;
+    event.time = glfwGetTime();
+    event.source = window;
+    inputQueue_.record(event);
 }
 
 void GUI3D::basicInputRegistration(){
@@ -79,6 +476,34 @@ void GUI3D::basicInputRegistration(){
                         });
     /// X Show FPS
     registerKeyFunciton(window_, GLFW_KEY_X, [&]() { bShowFPS = !bShowFPS; });
+    /// P Picking
+    registerKeyFunciton(window_, GLFW_KEY_P, [&]() { bPicking = !bPicking; }, "toggle picking");
+    /// Control+R, Control+P: record and replay (or stop replaying) the camera and input
+    registerKeyChord(window_, GLFW_KEY_R, GLFW_MOD_CONTROL, [&]() {
+        try {
+            if(!bRecording_) {
+                startRecording();
+                printf("Recording\n");
+            } else {
+                stopRecording("camera_recording.bin");
+                printf("Saved %zu frames to camera_recording.bin\n", recording_.frames().size());
+            }
+        } catch (const std::runtime_error &e) {
+            fprintf(stderr, "%s\n", e.what());
+        }
+    }, "record camera and input");
+    registerKeyChord(window_, GLFW_KEY_P, GLFW_MOD_CONTROL, [&]() {
+        if(isPlaying()) {
+            stopPlayback();
+            printf("Replay stopped\n");
+            return;
+        }
+        try {
+            playRecording("camera_recording.bin");
+        } catch (const std::runtime_error &e) {
+            fprintf(stderr, "%s\n", e.what());
+        }
+    }, "replay camera_recording.bin / stop");
 }
 
 void GUI3D::buildScreen(){
@@ -121,21 +546,12 @@ void GUI3D::buildScreen(){
         glEnableVertexAttribArray(1);
         glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) (2 * sizeof(float)));
 
-        // create a color attachment texture
-        unsigned int &textureColorbuffer = glBuffers["textureColorbuffer"];
-        glGenTextures(1, &textureColorbuffer);
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, window_->runtimeWidth, window_->runtimeHeight, 0, GL_RGB,
-                     GL_UNSIGNED_BYTE, NULL);
+        glBindVertexArray(0);
 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        // For Alpha texture
-        GLenum format = GL_RGBA;
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, format == GL_RGBA ? GL_CLAMP_TO_EDGE
-                                                                            : GL_REPEAT); // for this tutorial: use GL_CLAMP_TO_EDGE to prevent semi-transparent borders. Due to interpolation it takes texels from next repeat
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-//            glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_DECAL);
+        // offscreen target of the 3D scene (color + depth), resized to its viewport every frame
+        sceneTarget_.reset(new glUtil::RenderTarget(window_->runtimeWidth, window_->runtimeHeight));
+        sceneTimer_.reset(new glUtil::GpuTimer());
+        oit_.reset(new glUtil::WeightedBlendedOIT(shaderPath, window_->runtimeWidth, window_->runtimeHeight));
     }
 }
 void GUI3D::buildCamera(){
@@ -206,6 +622,7 @@ void GUI3D::buildGrid(){
     /// Grid
     {
         glShaders["grid"] = new glUtil::Shader(shaderPath + "grid.vs",shaderPath + "grid.fs");
+        glShaders["gridOIT"] = new glUtil::Shader(shaderPath + "grid.vs",shaderPath + "oitGrid.fs");
         glObjests["Plane"] = (glUtil::Model_base *) new glUtil::Mesh(glUtil::ShapeVertices::plane);
     }
 }
@@ -295,110 +712,369 @@ void GUI3D::buildFreeType(){
 }
 
 void GUI3D::basicProcess() {
-    auto projection = glCam->projection_control_->projection_matrix();
+    const glm::mat4 &projection = currentView_.projection;
 
     /// GRID
-    if (bShowGrid) {
+    if (bShowGrid && !bOIT) {
         glDisable(GL_DEPTH_TEST);
-        glUtil::Mesh *Plane = (glUtil::Mesh *) glObjests["Plane"];
-        //                glUtil::Shader *shader = glShaders["Plain"];
-//            glUtil::Shader *shader = glShaders["Lamp"];
-        glUtil::Shader *shader = glShaders["grid"];
-        Plane->setShader(shader);
-        shader->use();
-        glm::mat4 model = glm::mat4(1.f);
-        //                model = glm::translate(model, glm::vec3(0, 0, 0));
-        model = glm::scale(model, glm::vec3(20.f));// radius (meter)
-        shader->set("view", glCam->camera_control_->GetViewMatrix());
-        shader->set("projection", projection);
-        shader->set("model", model);
-        shader->set("color", glm::vec4(0, 0, 0, 0.8));
-        shader->set("thickness", 0.01);
-        Plane->Draw();
-
-
-        model = glm::rotate(model, glm::radians(90.f), glm::vec3(1.f, 0.f, 0));
-        shader->set("model", model);
-        Plane->Draw();
-
-        model = glm::rotate(model, glm::radians(90.f), glm::vec3(0.f, 0.f, 1.0));
-        shader->set("model", model);
-        Plane->Draw();
-        glEnable(GL_DEPTH_TEST);
-    }
-    /// Draw Text
-    if (bShowFPS) {
-        glDisable(GL_DEPTH_TEST);
-        RenderText(glVertexArrays["textVAO"], glBuffers["textVBO"], glShaders["Text"],
-                   "FPS: " + std::to_string((int) std::floor(fps_->getFPS())), 10.f, 10.f, 0.5f, glm::vec3(0.5f, 0.8f, 0.2f));
+        drawGrid(glShaders["grid"], projection);
         glEnable(GL_DEPTH_TEST);
     }
+}
+
+void GUI3D::drawGrid(glUtil::Shader *shader, const glm::mat4 &projection) {
+    glUtil::Mesh *Plane = (glUtil::Mesh *) glObjests["Plane"];
+    Plane->setShader(shader);
+    shader->use();
+    glm::mat4 model = glm::mat4(1.f);
+    //                model = glm::translate(model, glm::vec3(0, 0, 0));
+    model = glm::scale(model, glm::vec3(20.f));// radius (meter)
+    shader->set("view", currentView_.view);
+    shader->set("projection", projection);
+    shader->set("model", model);
+    shader->set("color", glm::vec4(0, 0, 0, 0.8));
+    shader->set("thickness", 0.01);
+    Plane->Draw();
 
-    if(bPlotTrajectory) {
 
-    }
+    model = glm::rotate(model, glm::radians(90.f), glm::vec3(1.f, 0.f, 0));
+    shader->set("model", model);
+    Plane->Draw();
+
+    model = glm::rotate(model, glm::radians(90.f), glm::vec3(0.f, 0.f, 1.0));
+    shader->set("model", model);
+    Plane->Draw();
 }
 
 
 void GUI3D::mouseControl(){
-    ImGuiIO& io = ImGui::GetIO();
-    if(!io.WantCaptureMouse) {
-        // let the main canvas handle the mouse input
-        glCam->mouse_control();
+    if(views_.empty()) {
+        if(bSceneHovered) {
+            // let the main canvas handle the mouse input
+            glCam->mouse_control();
+        }
+        return;
+    }
+    // a drag keeps driving the view it started in
+    bool bAnyDown = false;
+    for (int i = 0; i < 3; ++i) bAnyDown |= ImGui::IsMouseDown(i) || ImGui::IsMouseReleased(i);
+    if (!bAnyDown || activeView_ < 0) {
+        const ImVec2 mouse = ImGui::GetMousePos();
+        activeView_ = bSceneHovered ? viewAt(mouse.x, mouse.y) : -1;
     }
+    if (activeView_ == 0)
+        glCam->mouse_control();
+    else if (activeView_ > 0)
+        glUtil::Camera::mouse_control(*views_[activeView_ - 1].camera);
 }
 
 void GUI3D::plot_trajectory(const glm::mat4 *projection){
-    const std::string name = "Trajectory";
-    glUtil::Shader *shader = glShaders[name];
-    glm::mat4 modelMat = glm::mat4(1.f);
+    static const glm::vec4 colors[] = {glm::vec4(1, 0.5f, 0, 1), glm::vec4(0, 0.6f, 1, 1), glm::vec4(1, 0, 0.8f, 1),
+                                       glm::vec4(1, 1, 0, 1)};
+    glUtil::Shader *shader = glShaders["Camera"];
     shader->use();
-//        shader->set("lightColor", lightColor);
-    shader->set("lightPos", glCam->camera_control_->Position /*glm::vec3(0,2,0)*/);
-    shader->set("model", modelMat);
+    shader->set("model", glm::mat4(1.f));
+    shader->set("view", currentView_.view);
     shader->set("projection", *projection);
-    shader->set("view", glCam->camera_control_->GetViewMatrix());
-
-    glBindVertexArray(glVertexArrays[name]);
-    glBindBuffer(GL_ARRAY_BUFFER, glBuffers[name]);
-    glBufferSubData(GL_ARRAY_BUFFER, 0,
-                    trajectories_.size() * 3 * sizeof(GLfloat), trajectories_.data());
-    glDrawArrays(GL_LINE_STRIP, 0, trajectories_.size());
+    for (auto &entry : trajectories_) {
+        Trajectory &trajectory = entry.second;
+        if (trajectory.points.size() < 2) continue;
+        // append only the new points; grow the buffer by doubling like the vector
+        if (trajectory.capacity < trajectory.points.size()) {
+            if (!trajectory.vao) {
+                glGenVertexArrays(1, &trajectory.vao);
+                glGenBuffers(1, &trajectory.vbo);
+            }
+            trajectory.capacity = trajectory.points.capacity();
+            trajectory.uploaded = 0;
+            glBindVertexArray(trajectory.vao);
+            glBindBuffer(GL_ARRAY_BUFFER, trajectory.vbo);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * trajectory.capacity, NULL, GL_DYNAMIC_DRAW);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), 0);
+        }
+        glBindVertexArray(trajectory.vao);
+        if (trajectory.uploaded < trajectory.points.size()) {
+            glBindBuffer(GL_ARRAY_BUFFER, trajectory.vbo);
+            glBufferSubData(GL_ARRAY_BUFFER, sizeof(glm::vec3) * trajectory.uploaded,
+                            sizeof(glm::vec3) * (trajectory.points.size() - trajectory.uploaded),
+                            &trajectory.points[trajectory.uploaded]);
+            trajectory.uploaded = trajectory.points.size();
+        }
+        const size_t numColors = sizeof(colors) / sizeof(colors[0]);
+        shader->set("color", colors[static_cast<size_t>(entry.first) % numColors]);
+        glDrawArrays(GL_LINE_STRIP, 0, static_cast<GLsizei>(trajectory.points.size()));
+    }
+    glBindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void GUI3D::add_trajectory(float x, float y, float z, float interval){
-    std::string name = "Trajectory";
-    if (trajectories_.empty()) {
-        trajectories_.reserve(2<<8);
-        trajectories_.emplace_back(x, y, z);
-    } else {
-        const auto &prev = trajectories_.back();
-        glm::vec3 curr(x,y,z);
-        if (glm::distance(curr, prev) > interval) {
-            trajectories_.push_back(std::move(curr));
-            if(trajectories_.capacity() - trajectories_.size() < 8) {
-                trajectories_.reserve(trajectories_.capacity()*2);
-
-                if (glVertexArrays.find(name) != glVertexArrays.end()) {
-                    glDeleteVertexArrays(1, &glVertexArrays.at(name));
-                    glDeleteBuffers(1, &glBuffers.at(name));
-                }
-
-                glGenVertexArrays(1, &glVertexArrays[name]);
-                glGenBuffers(1, &glBuffers[name]);
-                glBindVertexArray(glVertexArrays[name]);
-                glBindBuffer(GL_ARRAY_BUFFER, glBuffers[name]);
-                glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * trajectories_.capacity()*3, NULL, GL_DYNAMIC_DRAW);
-                glEnableVertexAttribArray(0);
-                glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
-                glBindBuffer(GL_ARRAY_BUFFER, 0);
-                glBindVertexArray(0);
+void GUI3D::enableRGBDStream(int width, int height, float fx, float fy, float cx, float cy, float depthScale){
+    const std::string shaderPath = std::string(GUI_FOLDER_PATH) + "Shaders/";
+    rgbdStream_.reset(new glUtil::RGBDStream(width, height, shaderPath, depthScale));
+    rgbdStream_->setIntrinsics(fx, fy, cx, cy);
+}
+
+void GUI3D::submitRGBDFrame(glUtil::RGBDFrame frame){
+    if (rgbdStream_) {
+        rgbdStream_->submit(std::move(frame));
+    } else if (frame.release) {
+        frame.release();
+    }
+}
+
+void GUI3D::openRGBDWindows(bool bOwnThread){
+    if (!rgbdStream_)
+        throw std::runtime_error("Call enableRGBDStream() before openRGBDWindows().");
+    // the image fills the window; GL textures start at the bottom row
+    auto fullWindowImage = [](const char *name, unsigned int texture) {
+        ImGui::SetNextWindowPos(ImVec2(0, 0));
+        ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
+        ImGui::Begin(name, nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
+                                    ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoBackground);
+        ImGui::Image((ImTextureID)(intptr_t)texture, ImGui::GetContentRegionAvail());
+        ImGui::End();
+    };
+    const int width = rgbdStream_->width(), height = rgbdStream_->height();
+    addWindow("RGB", width, height, bOwnThread)->setDrawUI([this, fullWindowImage]() {
+        fullWindowImage("RGB", rgbdStream_->getColorTexture());
+    });
+    addWindow("Depth", width, height, bOwnThread)->setDrawUI([this, fullWindowImage]() {
+        fullWindowImage("Depth", rgbdStream_->getDepthColormapTexture());
+    });
+    bRGBDWindows = true;
+}
+
+void GUI3D::updateRGBDStream(){
+    rgbdStream_->upload();
+    if ((bShowRGBDStream && rgbdDisplayMode_ == DEPTH) || bRGBDWindows)
+        rgbdStream_->colorizeDepth(rgbdMinDepth, rgbdMaxDepth);
+}
+
+void GUI3D::processRGBDStream(const glm::mat4 &projection){
+    if (bShowRGBDCloud && !(bOIT && rgbdCloudOpacity < 1.f)) // translucent clouds go to transparentPass
+        rgbdStream_->drawPointCloud(projection, currentView_.view, rgbdPose_, rgbdPointSize);
+}
+
+void GUI3D::processIngest(){
+    static_assert(sizeof(glUtil::Vertex) == 14 * sizeof(float), "MeshMessage::vertices assumes a packed Vertex");
+    SC::DataIngest::Sinks sinks;
+    sinks.pose = [this](const SC::PoseSample &pose) {
+        add_trajectory(pose.position[0], pose.position[1], pose.position[2], 0.002f, pose.trajectory);
+        if (pose.keyframeId < 0) return;
+        const glm::quat q(pose.orientation[3], pose.orientation[0], pose.orientation[1], pose.orientation[2]);
+        glm::mat4 &keyframe = keyframes_[pose.keyframeId];
+        keyframe = glm::mat4_cast(q);
+        keyframe[3] = glm::vec4(pose.position[0], pose.position[1], pose.position[2], 1.f);
+    };
+    sinks.points = [this](const float *positions, const uint32_t *colors, size_t count) {
+        if (!streamedPoints_) {
+            const std::string shaderPath = std::string(GUI_FOLDER_PATH) + "Shaders/";
+            streamedPoints_.reset(new glUtil::StreamedPoints(maxStreamedPoints_, shaderPath));
+        }
+        streamedPoints_->append(positions, colors, count);
+    };
+    sinks.mesh = [this](SC::MeshMessage &message) {
+        const size_t numVertices = message.vertices.size() / 14;
+        if (numVertices == 0) return;
+        const auto *vertices = reinterpret_cast<const glUtil::Vertex *>(message.vertices.data());
+        auto *mesh = new glUtil::Mesh(vertices, numVertices, message.indices.data(), message.indices.size(), {});
+        glm::vec3 boundsMin(vertices[0].Position), boundsMax(vertices[0].Position);
+        for (size_t i = 1; i < numVertices; ++i) {
+            boundsMin = glm::min(boundsMin, vertices[i].Position);
+            boundsMax = glm::max(boundsMax, vertices[i].Position);
+        }
+
+        glUtil::Model_base *&slot = glObjests[message.name];
+        glUtil::Model_base *previous = slot;
+        slot = mesh;
+        bool bRegistered = false;
+        for (auto &object : sceneObjects_)
+            if (previous && object.object == previous) {
+                object.object = mesh;
+                object.boundsMin = boundsMin;
+                object.boundsMax = boundsMax;
+                bRegistered = true;
             }
+        if (shadows_)
+            shadows_->replaceModel(previous, mesh, boundsMin, boundsMax); // the casters hold raw pointers too
+        delete previous;
+        if (!bRegistered && !message.shader.empty())
+            addSceneObject(message.name, message.shader, boundsMin, boundsMax);
+    };
+    ingest_.drain(sinks, uploadBudget_);
+}
+
+void GUI3D::startRecording(){
+    recording_.clear();
+    recordingStart_ = glfwGetTime();
+    bRecording_ = true;
+}
+
+void GUI3D::stopRecording(const std::string &path){
+    bRecording_ = false;
+    recording_.save(path);
+}
+
+size_t GUI3D::playRecording(const std::string &path, double timestep){
+    playback_.reset(new SC::Playback(SC::InputRecording::load(path), timestep));
+    return playback_->numFrames();
+}
+
+size_t GUI3D::playCameraPath(const SC::CameraPath &path, double timestep){
+    playback_.reset(new SC::Playback(path, timestep));
+    return playback_->numFrames();
+}
+
+SC::CameraPose GUI3D::getCameraPose() const{
+    glm::vec3 eye;
+    glm::quat orientation;
+    glCam->camera_control_->getPose(eye, orientation);
+    SC::CameraPose pose;
+    for(int k = 0; k < 3; ++k) pose.position[k] = eye[k];
+    pose.orientation[0] = orientation.x;
+    pose.orientation[1] = orientation.y;
+    pose.orientation[2] = orientation.z;
+    pose.orientation[3] = orientation.w;
+    return pose;
+}
+
+void GUI3D::setCameraPose(const SC::CameraPose &pose){
+    const glm::quat orientation(pose.orientation[3], pose.orientation[0], pose.orientation[1], pose.orientation[2]);
+    glCam->camera_control_->setPose(glm::make_vec3(pose.position), orientation);
+}
+
+void GUI3D::processPlayback(){
+    // the pose drawn this frame, after mouseControl in drawUI; processInput adds this frame's events
+    if(bRecording_)
+        recording_.addFrame(glfwGetTime() - recordingStart_, getCameraPose());
+    if(!playback_) return;
+
+    // the events are dispatched by processInput; the input queue has a single producer, the GLFW callbacks
+    playbackEvents_.clear();
+    SC::CameraPose pose;
+    if(!playback_->step(pose, playbackEvents_)) {
+        playback_.reset();
+        return;
+    }
+    setCameraPose(pose);
+    for(SC::InputEvent &event : playbackEvents_)
+        event.source = window_->window;
+}
+
+void GUI3D::drawIngested(){
+    if (bPlotTrajectory && !trajectories_.empty())
+        plot_trajectory(&currentView_.projection);
+    if (!keyframes_.empty()) {
+        glUtil::Shader *shader = glShaders["Camera"];
+        shader->use();
+        shader->set("view", currentView_.view);
+        shader->set("projection", currentView_.projection);
+        shader->set("color", glm::vec4(0, 1, 0, 1)); // the trajectories change it
+        glBindVertexArray(glVertexArrays["Camera"]);
+        for (const auto &keyframe : keyframes_) {
+            shader->set("model", glm::scale(keyframe.second, glm::vec3(0.1f)));
+            glDrawElements(GL_LINES, 28, GL_UNSIGNED_INT, 0); // the lines of buildCamera
+        }
+        glBindVertexArray(0);
+    }
+    if (streamedPoints_)
+        streamedPoints_->draw(currentView_.projection, currentView_.view, streamedPointSize_);
+}
+
+void GUI3D::pickingPass(const glm::mat4 &projection){
+    if(sceneRect_.z <= 0 || sceneRect_.w <= 0) return; // minimized or collapsed
+    // Same resolution and projection as the scene target
+    if(!picking_) picking_.reset(new glUtil::PickingBuffer(sceneTarget_->width(), sceneTarget_->height()));
+    picking_->resize(sceneTarget_->width(), sceneTarget_->height());
+    picking_->poll(pickResult_);
+
+    glUtil::Shader *shader = picking_->shader();
+    picking_->begin();
+    // the main view only, at its place in the scene target so the cursor maps to the same pixel
+    const glm::ivec4 &viewport = frameViews_.empty() ? glm::ivec4(0, 0, picking_->width(), picking_->height())
+                                                     : frameViews_[0].viewport;
+    glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+    const glm::mat4 view = frameViews_.empty() ? glCam->camera_control_->GetViewMatrix() : frameViews_[0].view;
+    shader->set("view", view);
+    shader->set("projection", projection);
+
+    // what the main view drew this frame, with the same transforms. The id is the scene object id + 1 so
+    // results that arrive a frame or two later still map to the right object.
+    for (uint32_t index : culler_.visible(0)) {
+        SceneObject &object = sceneObjects_[index];
+        shader->set("objectID", static_cast<uint>(index + 1));
+        shader->set("model", object.transform);
+        object.object->DrawWith(shader);
+    }
+    // the point index within a draw is gl_PrimitiveID; a line strip segment starts at the point of its index
+    shader->set("model", glm::mat4(1.f));
+    if (streamedPoints_) {
+        shader->set("objectID", kPickStreamedPoints);
+        streamedPoints_->drawWith(shader, streamedPointSize_);
+    }
+    if (bPlotTrajectory) {
+        for (const auto &entry : trajectories_) {
+            const Trajectory &trajectory = entry.second;
+            if (entry.first < 0 || entry.first >= int(kPickRGBDCloud - kPickTrajectories) || trajectory.uploaded < 2)
+                continue;
+            shader->set("objectID", kPickTrajectories + static_cast<uint>(entry.first));
+            glBindVertexArray(trajectory.vao);
+            glDrawArrays(GL_LINE_STRIP, 0, static_cast<GLsizei>(trajectory.uploaded));
         }
+        glBindVertexArray(0);
+    }
+    if (rgbdStream_ && bShowRGBDCloud)
+        rgbdStream_->drawPointCloudIds(projection, view, rgbdPose_, rgbdPointSize, kPickRGBDCloud);
+
+    // Cursor is in window coordinates with a top-left origin. Map it into the scene viewport.
+    const double xpos = ImGui::GetIO().MousePos.x, ypos = ImGui::GetIO().MousePos.y;
+    const double u = (xpos - sceneRect_.x) / sceneRect_.z, v = (ypos - sceneRect_.y) / sceneRect_.w;
+    picking_->end(int(u * picking_->width()), int((1.0 - v) * picking_->height()));
+}
+
+GUI3D::PickedItem GUI3D::getPickedItem() const {
+    PickedItem item;
+    const unsigned int objectId = pickResult_.objectId;
+    if (!pickResult_.valid()) return item;
+    item.index = pickResult_.primitiveId;
+    if (objectId == kPickStreamedPoints) {
+        item.kind = PickedItem::StreamedPoint;
+    } else if (objectId == kPickRGBDCloud) {
+        item.kind = PickedItem::RGBDPoint;
+    } else if (objectId >= kPickTrajectories) {
+        item.kind = PickedItem::TrajectoryPoint;
+        item.id = static_cast<int>(objectId - kPickTrajectories);
+    } else if (objectId <= sceneObjects_.size()) {
+        item.kind = PickedItem::SceneObject;
+        item.id = static_cast<int>(objectId) - 1;
+    }
+    return item;
+}
+
+int GUI3D::getPickedSceneObject() const {
+    const PickedItem item = getPickedItem();
+    return item.kind == PickedItem::SceneObject ? item.id : -1;
+}
+
+std::string GUI3D::getPickedName() const {
+    const PickedItem item = getPickedItem();
+    switch (item.kind) {
+        case PickedItem::SceneObject: return sceneObjects_[item.id].name;
+        case PickedItem::StreamedPoint: return "Streamed points";
+        case PickedItem::RGBDPoint: return "RGB-D cloud";
+        case PickedItem::TrajectoryPoint: return "Trajectory " + std::to_string(item.id);
+        default: return "";
     }
 }
 
+void GUI3D::add_trajectory(float x, float y, float z, float interval, int trajectory){
+    std::vector<glm::vec3> &points = trajectories_[trajectory].points;
+    const glm::vec3 curr(x, y, z);
+    if (points.empty() || glm::distance(curr, points.back()) > interval)
+        points.push_back(curr); // uploaded by plot_trajectory
+}
+
 void GUI3D::RenderText(GLuint VAO, GLuint VBO, glUtil::Shader *shader, std::string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color) {
 
 // Activate corresponding render state
@@ -447,10 +1123,126 @@ void GUI3D::RenderText(GLuint VAO, GLuint VBO, glUtil::Shader *shader, std::stri
 }
 
 void GUI3D::showRegisteredKeyFunction(){
-    for(auto func:registeredFunctions_)
-        printf("window[%s], key[%d], function[%p], description[%s]\n", func.window_->name_.c_str(), func.key_, &func.no_id, func.description.c_str());
+    for(const auto &binding : keyBindings_.bindings())
+        printf("window[%s], key[%d], mods[%d], function[%p], description[%s]\n", window_->name_.c_str(), binding.key,
+               binding.mods, &binding.action, binding.description.c_str());
+}
+
+
+void GUI3D::pickingUI() {
+    if(!bPicking) return;
+    ImGui::Begin("Picking", &bPicking, ImGuiWindowFlags_AlwaysAutoResize);
+    if (pickResult_.valid()) {
+        ImGui::Text("Object: %s", getPickedName().c_str());
+        ImGui::Text("Instance: %u", pickResult_.instanceId);
+        ImGui::Text("Primitive: %u", pickResult_.primitiveId);
+    } else {
+        ImGui::Text("Object: -");
+    }
+    ImGui::End();
+}
+
+void GUI3D::rgbdStreamUI() {
+    if(!rgbdStream_ || !bShowRGBDStream) return;
+    ImGui::Begin("RGB-D Stream", &bShowRGBDStream);
+    const char* modes[] = { "RGB", "DEPTH" };
+    int mode = rgbdDisplayMode_;
+    if (ImGui::Combo("Mode", &mode, modes, IM_ARRAYSIZE(modes)))
+        rgbdDisplayMode_ = static_cast<DisplayMode>(mode);
+    if (rgbdDisplayMode_ == DEPTH) {
+        ImGui::DragFloat("Min depth", &rgbdMinDepth, 0.01f, 0.f, rgbdMaxDepth);
+        ImGui::DragFloat("Max depth", &rgbdMaxDepth, 0.01f, rgbdMinDepth, 100.f);
+    }
+    ImGui::Checkbox("Point cloud", &bShowRGBDCloud);
+    ImGui::SameLine();
+    ImGui::DragFloat("Point size", &rgbdPointSize, 0.1f, 1.f, 10.f);
+    if (bOIT) ImGui::SliderFloat("Point opacity", &rgbdCloudOpacity, 0.05f, 1.f);
+    const auto &stats = rgbdStream_->statistics();
+    ImGui::Text("frames %lu, dropped %lu, latency %.2f ms", stats.uploaded, stats.dropped, stats.latencyMs);
+
+    // Keep the aspect ratio of the stream
+    ImVec2 avail = ImGui::GetContentRegionAvail();
+    const float aspect = float(rgbdStream_->height()) / float(rgbdStream_->width());
+    ImVec2 size(avail.x, avail.x * aspect);
+    if (size.y > avail.y && avail.y > 0) size = ImVec2(avail.y / aspect, avail.y);
+    unsigned int texture = rgbdDisplayMode_ == RGB ? rgbdStream_->getColorTexture()
+                                                   : rgbdStream_->getDepthColormapTexture();
+    ImGui::Image((ImTextureID)(intptr_t)texture, size);
+    ImGui::End();
 }
 
+void GUI3D::sceneUI() {
+    if(!bSceneInWindow) {
+        int window_w, window_h;
+        glfwGetWindowSize(window_->window, &window_w, &window_h);
+        sceneRect_ = glm::vec4(0, 0, window_w, window_h);
+        bSceneHovered = !ImGui::GetIO().WantCaptureMouse;
+        return;
+    }
+    ImGui::Begin("Scene", &bSceneInWindow, ImGuiWindowFlags_NoScrollbar);
+    ImVec2 pos = ImGui::GetCursorScreenPos();
+    ImVec2 size = ImGui::GetContentRegionAvail();
+    // GL textures start at the bottom row
+    ImGui::Image((ImTextureID)(intptr_t)sceneTarget_->getColorTexture(), size, ImVec2(0, 1), ImVec2(1, 0));
+    bSceneHovered = ImGui::IsItemHovered();
+    sceneRect_ = glm::vec4(pos.x, pos.y, size.x, size.y);
+    ImGui::End();
+}
+
+void GUI3D::renderUI() {
+    if(!bShowRenderUI) return;
+    ImGui::Begin("Render", &bShowRenderUI, ImGuiWindowFlags_AlwaysAutoResize);
+    ImGui::Checkbox("Dynamic resolution", &bDynamicResolution);
+    if (bDynamicResolution) {
+        float minScale = dynamicResolution_.minScale(), maxScale = dynamicResolution_.maxScale();
+        bool bChanged = ImGui::SliderFloat("Min scale", &minScale, 0.25f, 1.f);
+        bChanged |= ImGui::SliderFloat("Max scale", &maxScale, 0.25f, 2.f);
+        if (bChanged) dynamicResolution_.setBounds(minScale, maxScale);
+        ImGui::Text("Scale: %.2f", renderScale_);
+    } else {
+        ImGui::SliderFloat("Render scale", &renderScale_, 0.25f, 2.f);
+    }
+    ImGui::Checkbox("Scene in window", &bSceneInWindow);
+    ImGui::Checkbox("Order-independent transparency", &bOIT);
+    ImGui::Text("Internal resolution: %d x %d", sceneTarget_->width(), sceneTarget_->height());
+    ImGui::Text("Scene GPU: %.2f ms / budget %.2f ms", dynamicResolution_.gpuMs(), dynamicResolution_.budgetMs());
+    if (dynamicResolution_.overBudget())
+        ImGui::TextColored(ImVec4(1.f, 0.3f, 0.3f, 1.f), "Over budget at the minimum scale");
+
+    const auto &history = dynamicResolution_.history();
+    if (!history.empty()) {
+        std::vector<float> scales;
+        scales.reserve(history.size());
+        for (const auto &sample : history) scales.push_back(sample.scale);
+        ImGui::PlotLines("Scale history", scales.data(), static_cast<int>(scales.size()), 0, nullptr,
+                         dynamicResolution_.minScale(), dynamicResolution_.maxScale(), ImVec2(0, 60));
+        if (ImGui::Button("Save history"))
+            dynamicResolution_.saveHistory("render_scale_history.csv");
+    }
+    ImGui::End();
+}
+
+void GUI3D::shadowUI() {
+    if(!shadows_ || !bShowShadowUI) return;
+    const auto &stats = shadows_->statistics();
+    ImGui::Begin("Shadows", &bShowShadowUI, ImGuiWindowFlags_AlwaysAutoResize);
+    ImGui::Text("Shadow GPU: %.3f ms", stats.gpuMs);
+    ImGui::Text("Regions re-rendered: %d static, %d final", stats.staticRendered, stats.dynamicRendered);
+    if(ImGui::Button("Invalidate cache"))
+        shadows_->invalidate();
+    ImGui::End();
+}
+
+void GUI3D::lightingUI() {
+    if(!clusteredLights_ || !bShowLightingUI) return;
+    const auto &stats = clusteredLights_->statistics();
+    ImGui::Begin("Clustered lights", &bShowLightingUI, ImGuiWindowFlags_AlwaysAutoResize);
+    ImGui::Text("Lights: %d", stats.numLights);
+    ImGui::Text("Max lights per cluster: %d", stats.maxPerCluster);
+    ImGui::Text("Light indices: %zu", stats.numIndices);
+    ImGui::Text("Binning + upload: %.3f ms", stats.cpuMs);
+    ImGui::End();
+}
 
 void GUI3D::cameraUI() {
     if(!bShowCameraUI) return;
@@ -1,10 +1,25 @@
 #include <functional>
 #include "../GUI/GUI.h"
+#include "../GUI/GUIWindow.h"
 #include "glShader.hpp"
 #include "glCamera.hpp"
 #include "projection_control.hpp"
 #include "glMesh.hpp"
 #include "glUtils.hpp"
+#include "glPicking.hpp"
+#include "glRGBDStream.hpp"
+#include "glRenderTarget.hpp"
+#include "glGpuTimer.hpp"
+#include "dynamic_resolution.hpp"
+#include "glShadow.hpp"
+#include "glClusteredLights.hpp"
+#include "glOIT.hpp"
+#include "input_events.hpp"
+#include "view_culling.hpp"
+#include "data_ingest.hpp"
+#include "glStreamedPoints.hpp"
+#include "scene_graph.hpp"
+#include "camera_path.hpp"
 #include <map>
 #include "camera_control.h"
 
@@ -70,6 +85,7 @@ namespace SC{
 
 //    double getFPS(){return fps_;}
         double& getFPS(){return fps_;}
+        double getTargetFPS() const {return targetFPS_;}
     private:
         double fps_time_pre_, fps_time_, targetFPS_, fps_;
         double maxPeriod_, lasttime_;
@@ -77,15 +93,6 @@ namespace SC{
         double diff_;
 
     };
-    struct task_element_t {
-        GLFWWindowContainer* window_;
-        int key_;
-        const std::function< void() > no_id;
-        std::string description;
-        explicit task_element_t(GLFWWindowContainer* window, int key, std::function< void() >  f, std::string description) :
-                window_(window), key_(key), no_id(std::move(f)), description(std::move(description)) { }
-    };
-
     class GUI3D : public GUI_base{
     public:
         explicit GUI3D(const std::string &name, int width, int height);
@@ -95,10 +102,19 @@ namespace SC{
         virtual void drawGL();
 
 
-        /// Adding new key callback
+        /// Adding new key callback. Fires on press, whatever modifiers are held.
         template <typename Task> void registerKeyFunciton(GLFWWindowContainer* window, int key, Task func, const std::string &description = ""){
-            registeredFunctions_.emplace_back(window,key,static_cast<std::function< void() >>(func), description);
+            keyBindings_.bind(key, SC::KeyBindings::kAnyMods, static_cast<std::function< void() >>(func), description,
+                              false, window->window);
+        }
+        /// Key callback with exactly these modifiers held (GLFW_MOD_*), e.g. GLFW_KEY_S + GLFW_MOD_CONTROL.
+        /// With bRepeat it fires again on the key repeat while held.
+        template <typename Task> void registerKeyChord(GLFWWindowContainer* window, int key, int mods, Task func,
+                                                       const std::string &description = "", bool bRepeat = false){
+            keyBindings_.bind(key, mods, static_cast<std::function< void() >>(func), description, bRepeat,
+                              window->window);
         }
+        bool isKeyDown(int key) const {return keyBindings_.isDown(key);}
 
         void showRegisteredKeyFunction();
 
@@ -111,6 +127,129 @@ namespace SC{
 
         bool setPlotTracjectory(bool option) {bPlotTrajectory = option;}
 
+        /// Render an object-ID buffer every frame and read back the region under the cursor asynchronously.
+        void setPicking(bool option) {bPicking = option;}
+        /// The latest picking result. Lags the cursor by one or two frames.
+        const glUtil::PickResult& getPickResult() const {return pickResult_;}
+        /// What the picking result points at.
+        struct PickedItem {
+            enum Kind {None, SceneObject, StreamedPoint, RGBDPoint, TrajectoryPoint};
+            Kind kind = None;
+            int id = -1;            // scene object or trajectory id
+            unsigned int index = 0; // streamed point slot, RGB-D pixel y * width + x, or first point of the segment
+        };
+        PickedItem getPickedItem() const;
+        /// The scene object (see addSceneObject) that belongs to the picking result, -1 if none.
+        int getPickedSceneObject() const;
+        /// The glObjests name of the picked scene object, or the point cloud or trajectory; empty if none.
+        std::string getPickedName() const;
+
+        /// Show an RGB-D stream as color/depth view and live point cloud. GL thread, once.
+        void enableRGBDStream(int width, int height, float fx, float fy, float cx, float cy, float depthScale = 0.001f);
+        /// Thread-safe. Hand a producer-owned frame to the viewer. See glUtil::RGBDFrame.
+        void submitRGBDFrame(glUtil::RGBDFrame frame);
+        /// Show the color and the colorized depth of the stream in two extra windows (see GUI_base::addWindow).
+        /// The textures are shared with the main context. After enableRGBDStream.
+        void openRGBDWindows(bool bOwnThread = false);
+
+        /// Internal resolution of the 3D scene relative to its viewport. Below 1 renders fewer pixels and upscales.
+        void setRenderScale(float scale) {renderScale_ = scale;}
+        float getRenderScale() const {return renderScale_;}
+        /// Fixed internal resolution of the 3D scene. 0 follows the viewport size times the render scale.
+        void setInternalResolution(int width, int height) {internalWidth_ = width; internalHeight_ = height;}
+        /// Show the 3D scene inside an ImGui window instead of filling the main window.
+        void setSceneInWindow(bool option) {bSceneInWindow = option;}
+        /// Scale the internal resolution between the bounds so the measured GPU time of the scene holds the
+        /// target FPS. UI and text are not affected.
+        void setDynamicResolution(bool option, float minScale = 0.5f, float maxScale = 1.f) {
+            bDynamicResolution = option;
+            dynamicResolution_.setBounds(minScale, maxScale);
+        }
+        const SC::DynamicResolution &getDynamicResolution() const {return dynamicResolution_;}
+
+        /// Create the cached shadow maps and the "ShadowLighting" shader that receives them.
+        glUtil::ShadowMaps *enableShadows(int cascadeSize = 2048, int numCascades = 3, int cubeSize = 512);
+        glUtil::ShadowMaps *getShadowMaps() {return shadows_.get();}
+        /// Register glObjests[name] as a shadow caster. Returns the caster id for ShadowMaps::setCasterTransform.
+        int addShadowCaster(const std::string &name, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax,
+                            const glm::mat4 &transform = glm::mat4(1.f), bool bStatic = true);
+
+        /// Create the clustered point lights and the "ClusteredLighting" shader. Add lights with
+        /// getClusteredLights()->lights().push_back(...).
+        glUtil::ClusteredLights *enableClusteredLights(int tilesX = 16, int tilesY = 9, int depthSlices = 24);
+        glUtil::ClusteredLights *getClusteredLights() {return clusteredLights_.get();}
+
+        /// Draw transparent geometry (grid, translucent point cloud, transparentPass()) with weighted blended
+        /// order-independent transparency instead of unsorted alpha blending.
+        void setOIT(bool option) {bOIT = option;}
+
+        /**
+         Split the scene into several viewports that each have their own camera and projection, e.g. top, side and
+         perspective views of the same map. The scene objects are culled for all views in one traversal and drawn
+         from the shared, sorted draw lists; only the view uniforms change between views.
+
+         @param rect (x, y, width, height) in fractions of the scene, bottom-left origin.
+         @return The view index. The main camera (glCam) is view 0 and fills the scene until setMainViewRect.
+         */
+        int addView(const glm::vec4 &rect, std::unique_ptr<SC::CameraControlBase> camera,
+                    std::unique_ptr<SC::ProjectionControl> projection);
+        void setMainViewRect(const glm::vec4 &rect) {mainViewRect_ = rect;}
+        /// Perspective main camera top right, orthographic top, front and side views in the other quadrants.
+        /// @param extent World units across the orthographic views.
+        void enableQuadView(float extent = 20.f);
+        /// Back to the main camera only.
+        void clearViews();
+        int numViews() const {return 1 + static_cast<int>(views_.size());}
+
+        /**
+         Draw glObjests[name] in every view whose frustum its bounds intersect, with the shader glShaders[shaderName].
+         The shader gets "model", "view" and "projection". Objects are drawn grouped by shader.
+         @return The id for setSceneObjectTransform.
+         */
+        int addSceneObject(const std::string &name, const std::string &shaderName, const glm::vec3 &boundsMin,
+                           const glm::vec3 &boundsMax, const glm::mat4 &transform = glm::mat4(1.f));
+        void setSceneObjectTransform(int id, const glm::mat4 &transform) {sceneObjects_.at(id).transform = transform;}
+        /// Take the transform of scene object id from a sceneGraph() node from now on, kNone to detach.
+        void attachSceneObject(int id, SC::SceneGraph::NodeId node) {sceneObjects_.at(id).node = node;}
+        /// Node hierarchy for scene object transforms, e.g. keyframes with the meshes observed from them. Updated
+        /// once per frame before culling; only the subtrees of changed nodes are recomputed.
+        SC::SceneGraph &sceneGraph() {return sceneGraph_;}
+        /// Draws of scene objects in the last frame, summed over the views.
+        size_t sceneDrawCount() const {return sceneDrawCount_;}
+
+        /**
+         Thread-safe entry for producer threads: poses extend their trajectory (keyframes are drawn as cameras),
+         point batches grow a streamed point cloud and meshes replace glObjests[name]. Drained on the GL thread
+         at the start of every frame, up to the upload budget.
+         */
+        SC::DataIngest &ingest() {return ingest_;}
+        /// Bytes of points and meshes uploaded per frame at most. The rest waits for the next frames.
+        void setUploadBudget(size_t bytes) {uploadBudget_ = bytes;}
+        /// Points kept by the streamed point cloud before the oldest are overwritten. Before the first batch.
+        void setMaxStreamedPoints(size_t count) {maxStreamedPoints_ = count;}
+
+        /**
+         Record the main camera pose and the input events of every frame, with timestamps, until stopRecording
+         writes them to path (see SC::InputRecording). Control+R toggles a recording to camera_recording.bin.
+         */
+        void startRecording();
+        void stopRecording(const std::string &path);
+        bool isRecording() const {return bRecording_;}
+        /**
+         Replay a recording frame-locked: every frame advances the replay by exactly timestep seconds, whatever the
+         frame rate, and shows the camera pose of that time and dispatches the input events recorded until then.
+         Live input is ignored meanwhile. Control+P replays camera_recording.bin.
+         @return The number of frames the replay takes.
+         */
+        size_t playRecording(const std::string &path, double timestep = 1.0 / 60.0);
+        /// Fly the main camera along path, frame-locked like playRecording.
+        size_t playCameraPath(const SC::CameraPath &path, double timestep = 1.0 / 60.0);
+        void stopPlayback() {playback_.reset();}
+        bool isPlaying() const {return playback_ != nullptr;}
+        /// The main camera as camera to world, e.g. to add keyframes to a SC::CameraPath.
+        SC::CameraPose getCameraPose() const;
+        void setCameraPose(const SC::CameraPose &pose);
+
 //        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
     protected:
         std::map<std::string, unsigned int> glBuffers, glVertexArrays, glFrameBuffers, glTextures;
@@ -118,32 +257,106 @@ namespace SC{
         std::map<std::string, glUtil::Model_base*> glObjests;
 //        std::map<std::string, glUtil::Model*> glModels;
         std::map<GLchar, Character> Characters;
-        std::map<int, bool> bKeyProcessFinished;
         FPSManager *fps_;
         bool bShowGrid, bShowFPS;
         bool bPlotTrajectory;
+        bool bPicking;
+        std::unique_ptr<glUtil::PickingBuffer> picking_;
+        glUtil::PickResult pickResult_;
+        // object ids in the picking buffer: scene object id + 1 below kPickTrajectories, then trajectory id +
+        // kPickTrajectories, and one id per point cloud at the top
+        static const unsigned int kPickTrajectories = 0xC0000000u, kPickRGBDCloud = 0xFFFFFFFDu,
+                                  kPickStreamedPoints = 0xFFFFFFFEu;
+        std::unique_ptr<glUtil::RGBDStream> rgbdStream_;
+        DisplayMode rgbdDisplayMode_;
+        bool bShowRGBDStream, bShowRGBDCloud;
+        float rgbdMinDepth, rgbdMaxDepth, rgbdPointSize;
+        bool bRGBDWindows; // the depth window needs the colormap every frame
+        glm::mat4 rgbdPose_; // camera to world of the streamed point cloud
+        std::unique_ptr<glUtil::RenderTarget> sceneTarget_;
+        float renderScale_;
+        int internalWidth_, internalHeight_;
+        bool bSceneInWindow, bSceneHovered, bShowRenderUI;
+        glm::vec4 sceneRect_; // the scene viewport in window coordinates (x, y, width, height), top-left origin
+        std::unique_ptr<glUtil::GpuTimer> sceneTimer_;
+        SC::DynamicResolution dynamicResolution_;
+        bool bDynamicResolution;
+        std::unique_ptr<glUtil::ShadowMaps> shadows_;
+        bool bShowShadowUI;
+        std::unique_ptr<glUtil::ClusteredLights> clusteredLights_;
+        bool bShowLightingUI;
+        std::unique_ptr<glUtil::WeightedBlendedOIT> oit_;
+        bool bOIT;
+        float rgbdCloudOpacity;
 
-        struct task_element_t {
-            GLFWWindowContainer* window_;
-            int key_;
-            const std::function< void() > no_id;
-            std::string description;
-            explicit task_element_t(GLFWWindowContainer* window, int key, std::function< void() >  f, std::string description) :
-                    window_(window), key_(key), no_id(std::move(f)), description(std::move(description)) { }
+        SC::KeyBindings keyBindings_;
+        SC::InputQueue inputQueue_; // filled by the GLFW callbacks, drained once per frame in processInput
+        struct Trajectory {
+            std::vector<glm::vec3> points;
+            unsigned int vao = 0, vbo = 0;
+            size_t capacity = 0, uploaded = 0; // points the buffer holds and points already in it
         };
-        std::vector<task_element_t> registeredFunctions_;
-        std::vector<glm::vec3> trajectories_;
+        std::map<int, Trajectory> trajectories_; // PoseSample::trajectory -> line strip
+        SC::DataIngest ingest_;
+        size_t uploadBudget_, maxStreamedPoints_;
+        std::unique_ptr<glUtil::StreamedPoints> streamedPoints_;
+        std::map<int, glm::mat4> keyframes_; // id -> camera to world
+        float streamedPointSize_;
+        SC::InputRecording recording_;
+        bool bRecording_;
+        double recordingStart_;
+        std::unique_ptr<SC::Playback> playback_;
+        std::vector<SC::InputEvent> playbackEvents_; // replayed this frame, dispatched after the live queue
 
         void RenderText(GLuint VAO, GLuint VBO, glUtil::Shader *shader, std::string text, GLfloat x, GLfloat y, GLfloat scale, glm::vec3 color);
         virtual void processInput(GLFWwindow* window);
+        /// Every recorded input event, in order, after the key bindings ran. E.g. for custom mouse handling.
+        virtual void onInputEvent(const SC::InputEvent &event) {}
+        void key_callback_impl(GLFWwindow* window, int key, int scancode, int action, int mods) override;
+        void mouse_button_callback_impl(GLFWwindow* window, int button, int action, int mods) override;
+        void mouse_callback_impl(GLFWwindow* window, double xpos, double ypos) override;
+        void scroll_callback_impl(GLFWwindow* window, double xoffset, double yoffset) override;
         virtual void basicInputRegistration();
         virtual void basicProcess();
+        /// Everything drawn into the offscreen scene target.
+        virtual void renderScene();
+        /// Transparent geometry, drawn between WeightedBlendedOIT::begin/end when OIT is on.
+        virtual void transparentPass(const glm::mat4 &projection);
+        void drawGrid(glUtil::Shader *shader, const glm::mat4 &projection);
+        /// Draw the scene target to the window with the screen quad.
+        void compositeScene();
+        /// Resize the scene target to its viewport and keep the projection aspect in sync.
+        void updateSceneTarget();
+        /// Drawn on the window framebuffer at native resolution after the scene is composited.
+        virtual void drawOverlay();
+        /// Every trajectory as a line strip in the current view. Uploads the points added since the last call.
         virtual void plot_trajectory(const glm::mat4 *projection);
-        virtual void add_trajectory(float x, float y, float z, float interval = 0.002);
+        /// Extend trajectory with the point if it is more than interval away from the last one.
+        virtual void add_trajectory(float x, float y, float z, float interval = 0.002, int trajectory = 0);
+        /// Draw the scene objects visible in the main view, the streamed points, the trajectories and the RGB-D
+        /// cloud into the picking buffer, each with its id range. Override to add custom draw paths.
+        virtual void pickingPass(const glm::mat4 &projection);
+        /// Upload the latest frame and colorize the depth, once per frame.
+        void updateRGBDStream();
+        /// Draw the point cloud into the current view.
+        virtual void processRGBDStream(const glm::mat4 &projection);
+        /// Hand the data queued in ingest() to GL, once per frame.
+        virtual void processIngest();
+        /// Trajectories, keyframes and streamed points in the current view.
+        virtual void drawIngested();
+        /// Record this frame, or apply the camera pose of the replay and collect its input events for processInput.
+        void processPlayback();
         void mouseControl();
+        /// Matrices and pixel viewports of all views for this frame.
+        void collectViews();
+        /// Make view i current: viewport, currentView_ and the view uniforms of the lighting shaders.
+        /// @param bLights also rebuild and bind the light clusters of the view; once per view and frame is enough.
+        void applyView(int i, bool bLights = true);
+        /// The scene objects visible in view i, from the shared culling result.
+        virtual void drawSceneObjects(int view);
+        /// Index of the view containing the window position, -1 if none.
+        int viewAt(float x, float y) const;
 
-//        virtual void scroll_callback_impl(GLFWwindow* window, double xoffset, double yoffset);
-//        virtual void mouse_callback_impl(GLFWwindow *window, double xpos, double ypos);
 
         void buildScreen();
         void buildCamera();
@@ -153,8 +366,44 @@ namespace SC{
 
         bool bShowCameraUI;
         void cameraUI();
+        void pickingUI();
+        void rgbdStreamUI();
+        void sceneUI();
+        void renderUI();
+        void shadowUI();
+        void lightingUI();
 
         std::unique_ptr<glUtil::Camera> glCam;
+        struct SceneView {
+            glm::vec4 rect;
+            std::unique_ptr<SC::CameraControlBase> camera;
+            std::unique_ptr<SC::ProjectionControl> projection;
+        };
+        std::vector<SceneView> views_;       // besides the main camera
+        glm::vec4 mainViewRect_;
+        int activeView_;                     // the view the mouse drives, -1 none
+        // per frame: view 0 is the main camera
+        struct FrameView {
+            glm::mat4 view, projection;
+            glm::vec3 position;
+            glm::ivec4 viewport;             // pixels in the scene target
+        };
+        std::vector<FrameView> frameViews_;
+        FrameView currentView_;              // the view being drawn
+        struct SceneObject {
+            std::string name;                // in glObjests
+            glUtil::Model_base *object;
+            glUtil::Shader *shader;
+            uint32_t shaderKey;
+            glm::vec3 boundsMin, boundsMax;
+            glm::mat4 transform;
+            SC::SceneGraph::NodeId node = SC::SceneGraph::kNone; // the transform follows this node if set
+        };
+        std::vector<SceneObject> sceneObjects_;
+        SC::SceneGraph sceneGraph_;
+        std::vector<SC::CullItem> cullItems_;
+        SC::MultiViewCuller culler_;
+        size_t sceneDrawCount_;
         glm::vec3 camPose, camUp;
         float yaw, pitch, fov, fovMax, camSpeed;
     private:
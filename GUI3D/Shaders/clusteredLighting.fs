@@ -0,0 +1,82 @@
+#version 330 core
+out vec4 FragColor;
+
+struct Material {
+    sampler2D texture;
+    float shininess;
+};
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoords;
+in float ViewDepth;
+
+uniform vec3 viewPos;
+uniform DirLight dirLight;
+uniform Material material;
+
+// Clustered point lights, see glClusteredLights.hpp
+uniform samplerBuffer lightData;      // two texels per light: position + radius, color + intensity
+uniform usamplerBuffer clusterRanges; // per cluster: offset into lightIndices, light count
+uniform usamplerBuffer lightIndices;
+uniform ivec3 clusterGrid;            // tiles x, tiles y, depth slices
+uniform vec2 viewportOrigin;         // lower left of the viewport, for split-screen views
+uniform vec2 viewportSize;
+uniform float clusterNear;
+uniform float clusterSliceScale;      // slices / log(far / near), or slices / (far - near) when linear
+uniform bool clusterLinear;           // orthographic view: linear depth slices
+
+vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir, vec3 albedo)
+{
+    vec3 lightDir = normalize(-light.direction);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    return (light.ambient + light.diffuse * diff + light.specular * spec) * albedo;
+}
+
+vec3 CalcPointLight(int index, vec3 normal, vec3 viewDir, vec3 albedo)
+{
+    vec4 positionRadius = texelFetch(lightData, 2 * index);
+    vec4 colorIntensity = texelFetch(lightData, 2 * index + 1);
+    vec3 toLight = positionRadius.xyz - FragPos;
+    float distance = length(toLight);
+    if (distance >= positionRadius.w) return vec3(0.0);
+
+    vec3 lightDir = toLight / distance;
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    // inverse square, windowed to reach zero at the radius
+    float window = clamp(1.0 - pow(distance / positionRadius.w, 4.0), 0.0, 1.0);
+    float attenuation = window * window / (distance * distance + 1.0);
+    return colorIntensity.rgb * colorIntensity.a * attenuation * (diff + spec) * albedo;
+}
+
+void main()
+{
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 albedo = vec3(texture(material.texture, TexCoords));
+    vec3 result = CalcDirLight(dirLight, norm, viewDir, albedo);
+
+    float slice = clusterLinear ? (ViewDepth - clusterNear) * clusterSliceScale
+                                : log(max(ViewDepth, clusterNear) / clusterNear) * clusterSliceScale;
+    ivec3 cluster = ivec3((gl_FragCoord.xy - viewportOrigin) / viewportSize * vec2(clusterGrid.xy), int(floor(slice)));
+    cluster = clamp(cluster, ivec3(0), clusterGrid - 1);
+    int clusterIndex = (cluster.z * clusterGrid.y + cluster.y) * clusterGrid.x + cluster.x;
+    uvec2 range = texelFetch(clusterRanges, clusterIndex).rg;
+    for (uint i = 0u; i < range.y; ++i) {
+        int light = int(texelFetch(lightIndices, int(range.x + i)).r);
+        result += CalcPointLight(light, norm, viewDir, albedo);
+    }
+    FragColor = vec4(result, 1.0);
+}
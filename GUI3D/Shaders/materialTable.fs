@@ -0,0 +1,46 @@
+#version 330 core
+out vec4 FragColor;
+
+#define MAX_MATERIALS 341 // replaced with glUtil::MaterialBuffer::capacity() by createShader
+
+struct Material {
+    vec4 ambient;
+    vec4 diffuse;
+    vec4 specular; // w: shininess
+};
+
+layout (std140) uniform MaterialBlock {
+    Material materials[MAX_MATERIALS];
+};
+
+struct DirLight {
+    vec3 direction;
+
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+in vec3 FragPos;
+in vec3 Normal;
+flat in int MaterialIndex;
+
+uniform vec3 viewPos;
+uniform DirLight dirLight;
+
+void main()
+{
+    Material material = materials[MaterialIndex];
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 lightDir = normalize(-dirLight.direction);
+
+    vec3 ambient = dirLight.ambient * material.ambient.rgb;
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 diffuse = dirLight.diffuse * (diff * material.diffuse.rgb);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.specular.w);
+    vec3 specular = dirLight.specular * (spec * material.specular.rgb);
+
+    FragColor = vec4(ambient + diffuse + specular, 1.0);
+}
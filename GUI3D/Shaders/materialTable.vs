@@ -0,0 +1,25 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+// 2-4 are Mesh's texture coordinates, tangent and bitangent
+layout (location = 5) in int aMaterialIndex; // per instance; MaterialBuffer::select sets 0 for other draws
+layout (location = 6) in mat4 aInstanceModel; // per instance, 6-9, used when instanced is true
+
+out vec3 FragPos;
+out vec3 Normal;
+flat out int MaterialIndex;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform bool instanced;
+uniform int materialIndex; // added to the per-instance index
+
+void main()
+{
+    mat4 world = instanced ? aInstanceModel : model;
+    FragPos = vec3(world * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(world))) * aNormal;
+    MaterialIndex = materialIndex + aMaterialIndex;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
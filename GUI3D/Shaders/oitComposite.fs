@@ -0,0 +1,16 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D accumTexture;  // rgb: sum of weighted premultiplied color, a: revealage
+uniform sampler2D weightTexture; // r: sum of weighted alpha
+
+void main()
+{
+    vec4 accum = texture(accumTexture, TexCoords);
+    float revealage = accum.a;
+    if (revealage >= 1.0) discard; // nothing transparent here
+    float weight = texture(weightTexture, TexCoords).r;
+    FragColor = vec4(accum.rgb / max(weight, 1e-5), revealage);
+}
@@ -0,0 +1,37 @@
+#version 330 core
+layout (location = 0) out vec4 accum;
+layout (location = 1) out vec4 weight;
+
+// Weighted blended OIT output, see glOIT.hpp. Nearer and more opaque fragments get larger weights.
+void writeOIT(vec4 color)
+{
+    float w = clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+    accum = vec4(color.rgb * color.a * w, color.a);
+    weight = vec4(color.a * w, 0.0, 0.0, 0.0);
+}
+
+in vec3 FragPos;
+
+uniform vec4 color;
+uniform float thickness;
+
+void main()
+{
+    vec4 result;
+    if (abs(FragPos.y) < thickness && abs(FragPos.z) < thickness) {
+      result = vec4(1,0,0,1); // x-axis
+    } else if (abs(FragPos.x) < thickness && abs(FragPos.z) < thickness) {
+      result = vec4(0,1,0,1); // y-axis
+    } else if (abs(FragPos.y) < thickness && abs(FragPos.x) < thickness) {
+      result = vec4(0,0,1,1); // z -axis
+    } else
+    if ((abs(FragPos.x - round(FragPos.x)) < thickness && abs(FragPos.y - round(FragPos.y)) < thickness) ||
+        (abs(FragPos.x - round(FragPos.x)) < thickness && abs(FragPos.z - round(FragPos.z)) < thickness) ||
+        (abs(FragPos.z - round(FragPos.z)) < thickness && abs(FragPos.y - round(FragPos.y)) < thickness))
+        {
+        result = color;
+    } else {
+        discard;
+    }
+    writeOIT(result);
+}
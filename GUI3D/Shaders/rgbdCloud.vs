@@ -0,0 +1,29 @@
+// Unproject a raw 16-bit depth image into a point cloud. No vertex attributes: one point per pixel via gl_VertexID.
+#version 330 core
+
+uniform usampler2D depthTexture;
+uniform sampler2D colorTexture;
+uniform float depthScale; // raw unit to meter
+uniform vec4 intrinsics;  // fx, fy, cx, cy
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 Color;
+
+void main()
+{
+    ivec2 size = textureSize(depthTexture, 0);
+    ivec2 pixel = ivec2(gl_VertexID % size.x, gl_VertexID / size.x);
+    uint raw = texelFetch(depthTexture, pixel, 0).r;
+    Color = texelFetch(colorTexture, pixel, 0).rgb;
+    if (raw == 0u) {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0); // outside the clip volume
+        return;
+    }
+    float z = float(raw) * depthScale;
+    vec3 point = vec3((float(pixel.x) - intrinsics.z) * z / intrinsics.x,
+                      (float(pixel.y) - intrinsics.w) * z / intrinsics.y,
+                      z);
+    gl_Position = projection * view * model * vec4(point, 1.0);
+}
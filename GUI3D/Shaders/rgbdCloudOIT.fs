@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) out vec4 accum;
+layout (location = 1) out vec4 weight;
+
+// Weighted blended OIT output, see glOIT.hpp. Nearer and more opaque fragments get larger weights.
+void writeOIT(vec4 color)
+{
+    float w = clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+    accum = vec4(color.rgb * color.a * w, color.a);
+    weight = vec4(color.a * w, 0.0, 0.0, 0.0);
+}
+
+in vec3 Color;
+
+uniform float opacity;
+
+void main()
+{
+    writeOIT(vec4(Color, opacity));
+}
@@ -0,0 +1,12 @@
+// Picking ids of the RGB-D point cloud: the point index is the pixel, y * width + x.
+#version 330 core
+out uvec4 FragID;
+
+in vec3 Color;
+
+uniform uint objectID;
+
+void main()
+{
+    FragID = uvec4(objectID, 0u, uint(gl_PrimitiveID), 1u);
+}
@@ -0,0 +1,96 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 FragPos;
+in vec3 Normal;
+in float ViewDepth;
+
+#define MAX_CASCADES 4
+#define MAX_POINT_SHADOWS 4
+
+uniform vec3 objectColor;
+uniform vec3 viewPos;
+
+// directional light with cascaded shadow maps
+uniform vec3 lightDirection;
+uniform vec3 lightColor;
+uniform sampler2DArray cascadeShadowMap;
+uniform mat4 cascadeMatrices[MAX_CASCADES];
+uniform float cascadeSplits[MAX_CASCADES]; // far end of each cascade in view space
+uniform int numCascades;
+
+// point lights with cube shadow maps
+uniform samplerCube pointShadowMaps[MAX_POINT_SHADOWS];
+uniform vec3 pointLightPositions[MAX_POINT_SHADOWS];
+uniform vec3 pointLightColors[MAX_POINT_SHADOWS];
+uniform float pointFarPlanes[MAX_POINT_SHADOWS];
+uniform int numPointLights;
+
+float CascadeShadow(vec3 normal, vec3 lightDir)
+{
+    int cascade = numCascades - 1;
+    for (int i = 0; i < numCascades; ++i) {
+        if (ViewDepth < cascadeSplits[i]) {
+            cascade = i;
+            break;
+        }
+    }
+    vec4 lightSpace = cascadeMatrices[cascade] * vec4(FragPos, 1.0);
+    vec3 coords = lightSpace.xyz / lightSpace.w * 0.5 + 0.5;
+    if (coords.z > 1.0) return 0.0;
+
+    float bias = max(0.005 * (1.0 - dot(normal, lightDir)), 0.0005) / float(cascade + 1);
+    // 3x3 PCF
+    float shadow = 0.0;
+    vec2 texelSize = 1.0 / vec2(textureSize(cascadeShadowMap, 0).xy);
+    for (int x = -1; x <= 1; ++x)
+        for (int y = -1; y <= 1; ++y) {
+            float closest = texture(cascadeShadowMap, vec3(coords.xy + vec2(x, y) * texelSize, float(cascade))).r;
+            shadow += coords.z - bias > closest ? 1.0 : 0.0;
+        }
+    return shadow / 9.0;
+}
+
+// Sampler arrays may only be indexed with constant expressions in GLSL 330, so the map is passed in.
+float PointShadow(samplerCube shadowMap, vec3 lightPos, float farPlane)
+{
+    vec3 toFrag = FragPos - lightPos;
+    float current = length(toFrag) / farPlane;
+    if (current > 1.0) return 0.0;
+    float closest = texture(shadowMap, toFrag).r;
+    return current - 0.005 > closest ? 1.0 : 0.0;
+}
+
+vec3 Shade(vec3 normal, vec3 lightDir, vec3 color, vec3 viewDir, float shadow)
+{
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 halfwayDir = normalize(lightDir + viewDir);
+    float spec = pow(max(dot(normal, halfwayDir), 0.0), 32.0);
+    return (1.0 - shadow) * (diff + 0.2 * spec) * color;
+}
+
+vec3 PointLight(int i, samplerCube shadowMap, vec3 normal, vec3 viewDir)
+{
+    vec3 toLight = pointLightPositions[i] - FragPos;
+    float distance = length(toLight);
+    float attenuation = clamp(1.0 - distance / pointFarPlanes[i], 0.0, 1.0);
+    float shadow = PointShadow(shadowMap, pointLightPositions[i], pointFarPlanes[i]);
+    return attenuation * Shade(normal, toLight / distance, pointLightColors[i], viewDir, shadow);
+}
+
+void main()
+{
+    vec3 normal = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+    vec3 lightDir = normalize(-lightDirection);
+
+    vec3 result = 0.15 * objectColor; // ambient
+    float shadow = numCascades > 0 ? CascadeShadow(normal, lightDir) : 0.0;
+    result += Shade(normal, lightDir, lightColor, viewDir, shadow) * objectColor;
+
+    if (numPointLights > 0) result += PointLight(0, pointShadowMaps[0], normal, viewDir) * objectColor;
+    if (numPointLights > 1) result += PointLight(1, pointShadowMaps[1], normal, viewDir) * objectColor;
+    if (numPointLights > 2) result += PointLight(2, pointShadowMaps[2], normal, viewDir) * objectColor;
+    if (numPointLights > 3) result += PointLight(3, pointShadowMaps[3], normal, viewDir) * objectColor;
+    FragColor = vec4(result, 1.0);
+}
@@ -1,6 +1,15 @@
 #version 330 core
+in vec3 FragPos;
+
+// Point lights store the linear distance to the light so one cubemap covers all directions.
+uniform bool linearDepth;
+uniform vec3 lightPos;
+uniform float farPlane;
 
 void main()
-{             
-    // gl_FragDepth = gl_FragCoord.z;
+{
+    if (linearDepth)
+        gl_FragDepth = length(FragPos - lightPos) / farPlane;
+    else
+        gl_FragDepth = gl_FragCoord.z;
 }
@@ -1,10 +1,14 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 
+out vec3 FragPos;
+
 uniform mat4 lightSpaceMatrix;
 uniform mat4 model;
 
 void main()
 {
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+    vec4 worldPos = model * vec4(aPos, 1.0);
+    FragPos = worldPos.xyz;
+    gl_Position = lightSpaceMatrix * worldPos;
 }
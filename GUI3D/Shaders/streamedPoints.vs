@@ -0,0 +1,15 @@
+// Points appended by glUtil::StreamedPoints, already in world space.
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aColor;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+out vec3 Color;
+
+void main()
+{
+    Color = aColor.rgb;
+    gl_Position = projection * view * vec4(aPos, 1.0);
+}
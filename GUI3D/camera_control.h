@@ -3,6 +3,7 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include <vector>
 
@@ -21,6 +22,15 @@ namespace SC{
         }
         void show(){ bShowUI=true;}
 
+        /// Camera to world of the current view: the eye position and the orientation (the camera looks down -z).
+        void getPose(glm::vec3 &eye, glm::quat &orientation) {
+            const glm::mat4 cameraToWorld = glm::inverse(GetViewMatrix());
+            eye = glm::vec3(cameraToWorld[3]);
+            orientation = glm::quat_cast(glm::mat3(cameraToWorld));
+        }
+        /// Move the camera to a pose, e.g. from a recording or a camera path. Controls without roll drop it.
+        virtual void setPose(const glm::vec3 &eye, const glm::quat &orientation) { Position = eye; }
+
         glm::vec3 Position;
         bool bShowUI;
     protected:
@@ -168,6 +178,14 @@ namespace SC{
             updateCameraVectors();
         }
 
+        void setPose(const glm::vec3 &eye, const glm::quat &orientation) override {
+            const glm::vec3 front = orientation * glm::vec3(0.f, 0.f, -1.f);
+            Position = eye;
+            Yaw = glm::degrees(std::atan2(front.z, front.x));
+            Pitch = glm::degrees(std::asin(glm::clamp(front.y, -1.f, 1.f)));
+            updateCameraVectors();
+        }
+
         void setPosition(float x, float y, float z){
             Position.x = x;
             Position.y = y;
@@ -318,6 +336,16 @@ namespace SC{
             distance = std::max(0.1, distance);
         }
 
+        /// Keeps the distance to the target. For the default world up (0, 1, 0) of rotation().
+        void setPose(const glm::vec3 &eye, const glm::quat &orientation) override {
+            const glm::vec3 front = orientation * glm::vec3(0.f, 0.f, -1.f);
+            // rotation() * (1, 0, 0) points from the target to the eye
+            phi = std::asin(glm::clamp(front.z, -1.f, 1.f));
+            phi = std::min(M_PI_2 - 0.01, std::max(-M_PI_2 + 0.01, phi));
+            theta = std::atan2(-front.y, -front.x);
+            Position = eye + front * float(distance);
+        }
+
         glm::quat rotation() const { return glm::angleAxis<float>(theta, glm::vec3(0,0,1)) * glm::angleAxis<float>(phi, WorldUp); }
 
     private:
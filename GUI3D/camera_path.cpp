@@ -0,0 +1,224 @@
+#include "camera_path.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace SC;
+
+namespace {
+    const char kMagic[8] = {'S', 'C', 'I', 'N', 'P', 'U', 'T', '\0'};
+    const uint32_t kVersion = 1;
+
+    /// Unit quaternion between a and b along the shorter arc, x y z w.
+    void slerp(const float *a, const float *b, float t, float *out) {
+        float d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+        float end[4] = {b[0], b[1], b[2], b[3]};
+        if (d < 0) {
+            d = -d;
+            for (float &c : end) c = -c;
+        }
+        float wa = 1 - t, wb = t;
+        if (d < 0.9995f) { // otherwise nearly parallel: the normalized lerp is as good and stays finite
+            const float angle = std::acos(d), sine = std::sin(angle);
+            wa = std::sin((1 - t) * angle) / sine;
+            wb = std::sin(t * angle) / sine;
+        }
+        float length = 0;
+        for (int k = 0; k < 4; ++k) {
+            out[k] = wa * a[k] + wb * end[k];
+            length += out[k] * out[k];
+        }
+        length = std::sqrt(length);
+        for (int k = 0; k < 4; ++k) out[k] /= length;
+    }
+}
+
+void CameraPath::add(double time, const CameraPose &pose) {
+    auto it = std::lower_bound(times_.begin(), times_.end(), time);
+    const size_t index = size_t(it - times_.begin());
+    if (it != times_.end() && *it == time) {
+        poses_[index] = pose;
+        return;
+    }
+    times_.insert(it, time);
+    poses_.insert(poses_.begin() + index, pose);
+}
+
+void CameraPath::clear() {
+    times_.clear();
+    poses_.clear();
+}
+
+CameraPose CameraPath::evaluate(double time) const {
+    if (times_.empty())
+        throw std::runtime_error("CameraPath::evaluate: the path has no keyframes");
+    if (time <= times_.front()) return poses_.front();
+    if (time >= times_.back()) return poses_.back();
+
+    const size_t i = size_t(std::upper_bound(times_.begin(), times_.end(), time) - times_.begin()) - 1;
+    const size_t last = times_.size() - 1;
+    const double h = times_[i + 1] - times_[i];
+    const float s = float((time - times_[i]) / h);
+    const float s2 = s * s, s3 = s2 * s;
+    const float h00 = 2 * s3 - 3 * s2 + 1, h10 = s3 - 2 * s2 + s, h01 = -2 * s3 + 3 * s2, h11 = s3 - s2;
+
+    // tangents per second, from the neighbours; one-sided at the ends
+    auto tangent = [&](size_t k, int axis) {
+        const size_t before = k > 0 ? k - 1 : k, after = k < last ? k + 1 : k;
+        return float((poses_[after].position[axis] - poses_[before].position[axis]) /
+                     (times_[after] - times_[before]));
+    };
+    CameraPose pose;
+    for (int axis = 0; axis < 3; ++axis)
+        pose.position[axis] = h00 * poses_[i].position[axis] + h10 * float(h) * tangent(i, axis) +
+                              h01 * poses_[i + 1].position[axis] + h11 * float(h) * tangent(i + 1, axis);
+    slerp(poses_[i].orientation, poses_[i + 1].orientation, s, pose.orientation);
+    return pose;
+}
+
+void InputRecording::addFrame(double time, const CameraPose &pose) {
+    Frame frame;
+    frame.time = time;
+    frame.pose = pose;
+    frame.firstEvent = uint32_t(events_.size());
+    frame.numEvents = 0;
+    frames_.push_back(frame);
+}
+
+void InputRecording::addEvent(const InputEvent &event) {
+    if (frames_.empty()) return;
+    events_.push_back(event);
+    events_.back().source = nullptr;
+    frames_.back().numEvents++;
+}
+
+void InputRecording::clear() {
+    frames_.clear();
+    events_.clear();
+}
+
+CameraPath InputRecording::cameraPath() const {
+    CameraPath path;
+    for (const Frame &frame : frames_) path.add(frame.time, frame.pose);
+    return path;
+}
+
+void InputRecording::save(const std::string &path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("InputRecording::save: cannot open " + path);
+    auto put8 = [&](uint8_t v) { file.put(char(v)); };
+    auto put32 = [&](uint32_t v) { file.write(reinterpret_cast<const char *>(&v), 4); };
+    auto putFloat = [&](float v) { file.write(reinterpret_cast<const char *>(&v), 4); };
+    file.write(kMagic, sizeof(kMagic));
+    put32(kVersion);
+    put32(uint32_t(frames_.size()));
+    put32(uint32_t(events_.size()));
+    put32(0); // reserved
+    for (const Frame &frame : frames_) {
+        file.write(reinterpret_cast<const char *>(&frame.time), 8);
+        for (float v : frame.pose.position) putFloat(v);
+        for (float v : frame.pose.orientation) putFloat(v);
+        put32(frame.numEvents);
+        for (uint32_t e = frame.firstEvent; e < frame.firstEvent + frame.numEvents; ++e) {
+            const InputEvent &event = events_[e];
+            put8(event.type);
+            put8(uint8_t(event.action));
+            put8(uint8_t(event.mods));
+            put8(0);
+            put32(uint32_t(event.code));
+            putFloat(float(event.x));
+            putFloat(float(event.y));
+            putFloat(float(event.time - frame.time)); // small, so single precision keeps it exact enough
+        }
+    }
+    if (!file.good())
+        throw std::runtime_error("InputRecording::save: failed to write " + path);
+}
+
+InputRecording InputRecording::load(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("InputRecording::load: cannot open " + path);
+    char magic[8];
+    uint32_t header[4];
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(header), sizeof(header));
+    if (!file.good() || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0)
+        throw std::runtime_error("InputRecording::load: not a recording: " + path);
+    if (header[0] != kVersion)
+        throw std::runtime_error("InputRecording::load: unsupported version " + std::to_string(header[0]) + " in " +
+                                 path);
+
+    InputRecording recording;
+    recording.frames_.reserve(header[1]);
+    recording.events_.reserve(header[2]);
+    for (uint32_t f = 0; f < header[1] && file.good(); ++f) {
+        Frame frame;
+        uint32_t numEvents = 0;
+        file.read(reinterpret_cast<char *>(&frame.time), 8);
+        file.read(reinterpret_cast<char *>(frame.pose.position), 12);
+        file.read(reinterpret_cast<char *>(frame.pose.orientation), 16);
+        file.read(reinterpret_cast<char *>(&numEvents), 4);
+        recording.addFrame(frame.time, frame.pose);
+        for (uint32_t e = 0; e < numEvents && file.good(); ++e) {
+            uint8_t bytes[4];
+            int32_t code;
+            float values[3];
+            file.read(reinterpret_cast<char *>(bytes), 4);
+            file.read(reinterpret_cast<char *>(&code), 4);
+            file.read(reinterpret_cast<char *>(values), 12);
+            if (bytes[0] > InputEvent::Scroll)
+                throw std::runtime_error("InputRecording::load: bad event type in " + path);
+            InputEvent event;
+            event.type = InputEvent::Type(bytes[0]);
+            event.action = bytes[1];
+            event.mods = bytes[2];
+            event.code = code;
+            event.x = values[0];
+            event.y = values[1];
+            event.time = frame.time + values[2];
+            recording.addEvent(event);
+        }
+    }
+    if (!file.good() || recording.events_.size() != header[2])
+        throw std::runtime_error("InputRecording::load: truncated file " + path);
+    return recording;
+}
+
+Playback::Playback(const InputRecording &recording, double timestep)
+        : Playback(recording.cameraPath(), timestep) {
+    frames_ = recording.frames();
+    events_ = recording.events();
+}
+
+Playback::Playback(const CameraPath &path, double timestep)
+        : path_(path), timestep_(timestep), numFrames_(0), frame_(0), nextRecorded_(0) {
+    if (!(timestep > 0))
+        throw std::runtime_error("Playback: the timestep must be positive");
+    // the last step lands on or just before the end; the epsilon keeps whole multiples from losing a frame
+    if (!path_.empty())
+        numFrames_ = size_t(std::floor((path_.endTime() - path_.startTime()) / timestep_ + 1e-6)) + 1;
+}
+
+bool Playback::step(CameraPose &pose, std::vector<InputEvent> &events) {
+    if (finished()) return false;
+    // from the frame index, not accumulated, so long runs do not drift
+    const double t = path_.startTime() + double(frame_) * timestep_;
+    pose = path_.evaluate(t);
+    const bool bLast = frame_ + 1 == numFrames_;
+    while (nextRecorded_ < frames_.size() && (bLast || frames_[nextRecorded_].time <= t)) {
+        const InputRecording::Frame &recorded = frames_[nextRecorded_++];
+        events.insert(events.end(), events_.begin() + recorded.firstEvent,
+                      events_.begin() + recorded.firstEvent + recorded.numEvents);
+    }
+    frame_++;
+    return true;
+}
+
+double Playback::time() const {
+    return frame_ == 0 ? 0 : double(frame_ - 1) * timestep_;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "input_events.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SC {
+    /// Camera to world: the eye position and a unit quaternion x, y, z, w. The camera looks down its -z axis.
+    struct CameraPose {
+        float position[3] = {0, 0, 0};
+        float orientation[4] = {0, 0, 0, 1};
+    };
+
+    /**
+     A smooth fly-through from keyframes. Positions follow a cubic Hermite spline through the keyframes with
+     Catmull-Rom tangents scaled for uneven keyframe spacing; orientations are slerped along the shorter arc.
+     */
+    class CameraPath {
+    public:
+        /// Keyframes stay ordered by time. A keyframe at the time of an existing one replaces it.
+        void add(double time, const CameraPose &pose);
+        void clear();
+
+        bool empty() const { return times_.empty(); }
+        size_t size() const { return times_.size(); }
+        double startTime() const { return times_.empty() ? 0 : times_.front(); }
+        double endTime() const { return times_.empty() ? 0 : times_.back(); }
+
+        /// The pose at time, clamped to the first and last keyframe. Throws if the path is empty.
+        CameraPose evaluate(double time) const;
+
+    private:
+        std::vector<double> times_;
+        std::vector<CameraPose> poses_;
+    };
+
+    /**
+     The camera pose and the input events of every frame of a session, with timestamps in seconds from the start.
+     Stored as a compact binary file: a header, then 40 bytes per frame and 20 bytes per event.
+     */
+    class InputRecording {
+    public:
+        struct Frame {
+            double time;
+            CameraPose pose;
+            uint32_t firstEvent, numEvents; // range in events()
+        };
+
+        void addFrame(double time, const CameraPose &pose);
+        /// Belongs to the last added frame. Events before the first frame are dropped.
+        void addEvent(const InputEvent &event);
+        void clear();
+
+        const std::vector<Frame> &frames() const { return frames_; }
+        const std::vector<InputEvent> &events() const { return events_; }
+        double duration() const { return frames_.empty() ? 0 : frames_.back().time - frames_.front().time; }
+        /// Every frame as a keyframe.
+        CameraPath cameraPath() const;
+
+        /// Throw on I/O errors and on files that are not recordings.
+        void save(const std::string &path) const;
+        static InputRecording load(const std::string &path);
+
+    private:
+        std::vector<Frame> frames_;
+        std::vector<InputEvent> events_;
+    };
+
+    /**
+     Frame-locked playback: every step advances the clock by exactly one timestep, however long the frame took to
+     render, so runs show the same sequence of poses and events and are exactly reproducible. Recorded events are
+     handed out with the first step whose time reaches the frame they were recorded in.
+     */
+    class Playback {
+    public:
+        Playback(const InputRecording &recording, double timestep);
+        Playback(const CameraPath &path, double timestep);
+
+        /**
+         Advance one frame.
+         @param events The events due this frame are appended.
+         @return false once the end was reached; pose and events are then left untouched.
+         */
+        bool step(CameraPose &pose, std::vector<InputEvent> &events);
+
+        /// Steps the whole playback takes.
+        size_t numFrames() const { return numFrames_; }
+        size_t frame() const { return frame_; }
+        /// Seconds from the start of the path at the last step.
+        double time() const;
+        bool finished() const { return frame_ >= numFrames_; }
+
+    private:
+        CameraPath path_;
+        std::vector<InputRecording::Frame> frames_;
+        std::vector<InputEvent> events_;
+        double timestep_;
+        size_t numFrames_, frame_, nextRecorded_;
+    };
+}
@@ -0,0 +1,88 @@
+#include "data_ingest.hpp"
+
+#include <algorithm>
+
+using namespace SC;
+
+DataIngest::DataIngest(size_t poseCapacity, size_t batchCapacity, size_t meshCapacity)
+        : poses_(poseCapacity), batches_(batchCapacity), pool_(batchCapacity), meshes_(meshCapacity),
+          currentOffset_(0), numPoses_(0), numPoints_(0), numMeshes_(0), posesDropped_(0), batchesDropped_(0),
+          meshesDropped_(0) {}
+
+DataIngest::~DataIngest() = default;
+
+bool DataIngest::pushPose(const PoseSample &pose) {
+    if (poses_.push(pose)) return true;
+    posesDropped_++;
+    return false;
+}
+
+std::unique_ptr<PointBatch> DataIngest::acquireBatch() {
+    std::unique_ptr<PointBatch> batch;
+    if (!pool_.pop(batch) || !batch) batch.reset(new PointBatch());
+    batch->clear();
+    return batch;
+}
+
+bool DataIngest::submitBatch(std::unique_ptr<PointBatch> batch) {
+    if (!batch || batch->size() == 0) return true;
+    if (batches_.push(std::move(batch))) return true;
+    batchesDropped_++;
+    return false;
+}
+
+bool DataIngest::submitMesh(MeshMessage mesh) {
+    if (meshes_.push(std::unique_ptr<MeshMessage>(new MeshMessage(std::move(mesh))))) return true;
+    meshesDropped_++;
+    return false;
+}
+
+size_t DataIngest::drain(const Sinks &sinks, size_t budgetBytes) {
+    PoseSample pose;
+    while (poses_.pop(pose)) {
+        if (sinks.pose) sinks.pose(pose);
+        numPoses_++;
+    }
+
+    size_t bytes = 0;
+    std::unique_ptr<MeshMessage> mesh;
+    while ((bytes == 0 || bytes < budgetBytes) && meshes_.pop(mesh)) {
+        bytes += mesh->vertices.size() * sizeof(float) + mesh->indices.size() * sizeof(uint32_t);
+        if (sinks.mesh) sinks.mesh(*mesh);
+        numMeshes_++;
+    }
+
+    while (bytes == 0 || bytes < budgetBytes) {
+        if (!current_) {
+            if (!batches_.pop(current_)) break;
+            currentOffset_ = 0;
+        }
+        const size_t remaining = current_->size() - currentOffset_;
+        const size_t count = std::max<size_t>(1, std::min(remaining, (budgetBytes - std::min(bytes, budgetBytes)) / kPointBytes));
+        const size_t n = std::min(count, remaining);
+        if (sinks.points)
+            sinks.points(current_->positions.data() + currentOffset_ * 3,
+                         current_->colors.size() == current_->size() ? current_->colors.data() + currentOffset_ : nullptr, n);
+        currentOffset_ += n;
+        numPoints_ += n;
+        bytes += n * kPointBytes;
+        if (currentOffset_ == current_->size()) {
+            current_->clear();
+            pool_.push(std::move(current_)); // a full pool just frees it
+            current_.reset();
+        }
+    }
+    return bytes;
+}
+
+DataIngest::Statistics DataIngest::statistics() const {
+    Statistics stats;
+    stats.poses = numPoses_;
+    stats.points = numPoints_;
+    stats.meshes = numMeshes_;
+    stats.posesDropped = posesDropped_.load();
+    stats.batchesDropped = batchesDropped_.load();
+    stats.meshesDropped = meshesDropped_.load();
+    stats.pendingPoints = current_ ? current_->size() - currentOffset_ : 0;
+    return stats;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "mpmc_queue.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace SC {
+    /// A tracked pose. Keyframes are poses the viewer keeps and draws as camera frustums.
+    struct PoseSample {
+        int trajectory = 0;
+        float position[3] = {0, 0, 0};
+        float orientation[4] = {0, 0, 0, 1}; // quaternion x, y, z, w; camera to world
+        double time = 0;
+        int keyframeId = -1;                 // >= 0 for keyframes
+    };
+
+    /// Points to add to the live map. Taken from and returned to a pool, so steady streaming does not allocate.
+    struct PointBatch {
+        std::vector<float> positions; // x, y, z per point, world space
+        std::vector<uint32_t> colors; // RGBA8 per point (R in the lowest byte), or empty for white
+        size_t size() const { return positions.size() / 3; }
+        void clear() { positions.clear(); colors.clear(); }
+    };
+
+    /// A mesh to show as glObjests[name], replacing an older one of the same name.
+    struct MeshMessage {
+        std::string name;
+        std::string shader;            // glShaders name to draw it with as a scene object, empty to only store it
+        std::vector<float> vertices;   // 14 floats per vertex: position, normal, uv, tangent, bitangent
+        std::vector<uint32_t> indices;
+    };
+
+    /**
+     Hands data from producer threads (trackers, mappers) to the GL thread without locks. Producers push from
+     any thread and never wait: a full queue drops the message and counts it. The GL thread drains once per
+     frame; poses are cheap and always drained, points and meshes are uploaded up to a byte budget per frame
+     and the rest stays queued for the next frame, so a burst of data spreads over several frames instead of
+     stalling one.
+     */
+    class DataIngest {
+    public:
+        explicit DataIngest(size_t poseCapacity = 16384, size_t batchCapacity = 256, size_t meshCapacity = 16);
+        ~DataIngest();
+
+        /// Producers, any thread.
+        bool pushPose(const PoseSample &pose);
+        /// An empty batch, recycled from an earlier submit if one is free.
+        std::unique_ptr<PointBatch> acquireBatch();
+        bool submitBatch(std::unique_ptr<PointBatch> batch);
+        bool submitMesh(MeshMessage mesh);
+
+        /// Consumer (GL thread).
+        struct Sinks {
+            std::function<void(const PoseSample &)> pose;
+            /// A contiguous part of a batch: count points from positions (xyz) and colors (nullptr for white).
+            std::function<void(const float *positions, const uint32_t *colors, size_t count)> points;
+            std::function<void(MeshMessage &)> mesh;
+        };
+        /**
+         @param budgetBytes Points and meshes to hand to the sinks this frame. At least one mesh or one part of a
+         batch is handed over, so oversized items still progress.
+         @return Bytes of points and meshes handed over.
+         */
+        size_t drain(const Sinks &sinks, size_t budgetBytes);
+
+        struct Statistics {
+            size_t poses, points, meshes;              // handed to the sinks
+            size_t posesDropped, batchesDropped, meshesDropped;
+            size_t pendingPoints;                      // of the batch in progress
+        };
+        /// Consumer thread; the dropped counters are updated by the producers.
+        Statistics statistics() const;
+
+        /// Bytes a point occupies in the budget: position and color.
+        static const size_t kPointBytes = 16;
+
+    private:
+        MpmcQueue<PoseSample> poses_;
+        MpmcQueue<std::unique_ptr<PointBatch>> batches_, pool_;
+        MpmcQueue<std::unique_ptr<MeshMessage>> meshes_;
+        std::unique_ptr<PointBatch> current_; // batch in progress across frames
+        size_t currentOffset_;                // points of it already handed over
+        size_t numPoses_, numPoints_, numMeshes_;
+        std::atomic<size_t> posesDropped_, batchesDropped_, meshesDropped_;
+    };
+}
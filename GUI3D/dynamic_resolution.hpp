@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+namespace SC {
+    /**
+     Picks the render scale of the 3D scene from the measured GPU frame time.
+
+     The GPU time is assumed to grow with the pixel count, i.e. with scale^2. Each update moves the scale towards
+     the value that would hit the budget (target frame time times headroom), limited to a few percent per frame
+     so the image does not pump. Every change is recorded in a bounded history.
+     */
+    class DynamicResolution {
+    public:
+        struct Sample {
+            double time;     // seconds, caller's clock
+            float scale;     // render scale after the update
+            float gpuMs;     // measured GPU time that caused it
+        };
+
+        explicit DynamicResolution(double targetFPS = 60.0, float minScale = 0.5f, float maxScale = 1.f)
+        : minScale_(minScale), maxScale_(maxScale), scale_(maxScale), headroom_(0.9f), maxStep_(0.05f),
+          smoothedMs_(-1.f), bOverBudget_(false), historySize_(600) {
+            setTargetFPS(targetFPS);
+        }
+
+        void setTargetFPS(double fps) { budgetMs_ = static_cast<float>(1000.0 / std::max(1.0, fps)); }
+        void setBounds(float minScale, float maxScale) {
+            minScale_ = std::min(minScale, maxScale);
+            maxScale_ = std::max(minScale, maxScale);
+            scale_ = std::min(std::max(scale_, minScale_), maxScale_);
+        }
+        /// Fraction of the frame budget the scene may use. The rest is left for UI, text and the swap.
+        void setHeadroom(float headroom) { headroom_ = headroom; }
+
+        /// Feed one GPU frame time and get the scale to render the next frame with.
+        float update(float gpuMs, double time) {
+            smoothedMs_ = smoothedMs_ < 0 ? gpuMs : smoothedMs_ * 0.8f + gpuMs * 0.2f;
+            const float target = budgetMs_ * headroom_;
+            float ideal = scale_ * std::sqrt(target / std::max(smoothedMs_, 1e-3f));
+            ideal = std::min(std::max(ideal, scale_ - maxStep_), scale_ + maxStep_);
+            ideal = std::min(std::max(ideal, minScale_), maxScale_);
+
+            // only move on a clear miss/surplus to avoid jitter around the target
+            if (std::fabs(ideal - scale_) > 0.005f) {
+                scale_ = ideal;
+                history_.push_back({time, scale_, gpuMs});
+                if (history_.size() > historySize_) history_.pop_front();
+            }
+
+            const bool bOverBudget = scale_ <= minScale_ && smoothedMs_ > budgetMs_;
+            if (bOverBudget && !bOverBudget_)
+                std::cout << "WARNING::DYNAMIC_RESOLUTION::GPU time " << smoothedMs_ << " ms exceeds the budget of "
+                          << budgetMs_ << " ms at the minimum scale " << minScale_ << std::endl;
+            bOverBudget_ = bOverBudget;
+            return scale_;
+        }
+
+        float scale() const { return scale_; }
+        float gpuMs() const { return smoothedMs_; }
+        float budgetMs() const { return budgetMs_; }
+        float minScale() const { return minScale_; }
+        float maxScale() const { return maxScale_; }
+        /// The budget is blown even at the lowest allowed resolution.
+        bool overBudget() const { return bOverBudget_; }
+        const std::deque<Sample> &history() const { return history_; }
+
+        /// Write the scale history as CSV (time, scale, gpu_ms).
+        bool saveHistory(const std::string &path) const {
+            std::ofstream file(path);
+            if (!file.is_open()) {
+                std::cout << "ERROR::DYNAMIC_RESOLUTION::Cannot open " << path << std::endl;
+                return false;
+            }
+            file << "time,scale,gpu_ms\n";
+            for (const auto &s : history_)
+                file << s.time << "," << s.scale << "," << s.gpuMs << "\n";
+            return true;
+        }
+
+    private:
+        float budgetMs_, minScale_, maxScale_, scale_, headroom_, maxStep_, smoothedMs_;
+        bool bOverBudget_;
+        size_t historySize_;
+        std::deque<Sample> history_;
+    };
+}
@@ -0,0 +1,45 @@
+#pragma once
+// Zero-copy views between glm and Eigen. Both store float matrices column-major and vectors as packed floats,
+// so a glm::mat4 can be used as an Eigen::Matrix4f (and the other way round) and an array of glm::vec3 as the
+// columns of an Eigen::Matrix3Xf without copying. The views alias the original memory: they must not outlive it.
+
+#include <Eigen/Core>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace SC {
+    static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "glm::vec3 must be packed (no GLM_FORCE_ALIGNED)");
+    static_assert(sizeof(glm::vec4) == 4 * sizeof(float), "glm::vec4 must be packed");
+    static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "glm::mat4 must be packed");
+
+    inline Eigen::Map<Eigen::Matrix4f> asEigen(glm::mat4 &m) { return Eigen::Map<Eigen::Matrix4f>(&m[0][0]); }
+    inline Eigen::Map<const Eigen::Matrix4f> asEigen(const glm::mat4 &m) {
+        return Eigen::Map<const Eigen::Matrix4f>(&m[0][0]);
+    }
+    inline Eigen::Map<Eigen::Vector3f> asEigen(glm::vec3 &v) { return Eigen::Map<Eigen::Vector3f>(&v[0]); }
+    inline Eigen::Map<const Eigen::Vector3f> asEigen(const glm::vec3 &v) {
+        return Eigen::Map<const Eigen::Vector3f>(&v[0]);
+    }
+    /// The points as the columns of a 3 x n matrix.
+    inline Eigen::Map<Eigen::Matrix3Xf> asEigen(glm::vec3 *points, size_t n) {
+        return Eigen::Map<Eigen::Matrix3Xf>(&points[0][0], 3, Eigen::Index(n));
+    }
+    inline Eigen::Map<const Eigen::Matrix3Xf> asEigen(const glm::vec3 *points, size_t n) {
+        return Eigen::Map<const Eigen::Matrix3Xf>(&points[0][0], 3, Eigen::Index(n));
+    }
+    inline Eigen::Map<Eigen::Matrix3Xf> asEigen(std::vector<glm::vec3> &points) {
+        return asEigen(points.data(), points.size());
+    }
+
+    /// Eigen's fixed-size types are at least as aligned as glm's, so the other direction is a plain reference.
+    inline glm::mat4 &asGlm(Eigen::Matrix4f &m) { return *reinterpret_cast<glm::mat4 *>(m.data()); }
+    inline const glm::mat4 &asGlm(const Eigen::Matrix4f &m) { return *reinterpret_cast<const glm::mat4 *>(m.data()); }
+    inline glm::vec3 &asGlm(Eigen::Vector3f &v) { return *reinterpret_cast<glm::vec3 *>(v.data()); }
+    inline const glm::vec3 &asGlm(const Eigen::Vector3f &v) { return *reinterpret_cast<const glm::vec3 *>(v.data()); }
+    /// The columns of a 3 x n matrix as points.
+    inline glm::vec3 *asGlm(Eigen::Matrix3Xf &points) { return reinterpret_cast<glm::vec3 *>(points.data()); }
+    inline const glm::vec3 *asGlm(const Eigen::Matrix3Xf &points) {
+        return reinterpret_cast<const glm::vec3 *>(points.data());
+    }
+}
@@ -22,6 +22,11 @@ namespace glUtil{
         }
 
         void mouse_control() {
+            mouse_control(*camera_control_);
+        }
+
+        /// Drive any camera control with the ImGui mouse state, e.g. the camera of another viewport.
+        static void mouse_control(SC::CameraControlBase &camera_control) {
             ImGuiIO& io = ImGui::GetIO();
             auto mouse_pos = ImGui::GetMousePos();
             auto drag_delta = ImGui::GetMouseDragDelta();
@@ -30,16 +35,16 @@ namespace glUtil{
 
             for (int i = 0; i < 3; i++) {
                 if (ImGui::IsMouseClicked(i)) {
-                    camera_control_->mouse(p, i, true);
+                    camera_control.mouse(p, i, true);
                 }
                 if (ImGui::IsMouseReleased(i)) {
-                    camera_control_->mouse(p, i, false);
+                    camera_control.mouse(p, i, false);
                 }
                 if (ImGui::IsMouseDragging(i)) {
-                    camera_control_->drag(p, i);
+                    camera_control.drag(p, i);
                 }
 
-                camera_control_->scroll(glm::vec2(io.MouseWheel, io.MouseWheelH));
+                camera_control.scroll(glm::vec2(io.MouseWheel, io.MouseWheelH));
             }
         }
 
@@ -0,0 +1,92 @@
+//
+//  glClusteredLights.cpp
+//
+
+#include "glClusteredLights.hpp"
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace glUtil {
+    namespace {
+        void createBufferTexture(unsigned int &buffer, unsigned int &texture, GLenum format) {
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+            glBufferData(GL_TEXTURE_BUFFER, 16, NULL, GL_STREAM_DRAW); // never empty
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_BUFFER, texture);
+            glTexBuffer(GL_TEXTURE_BUFFER, format, buffer);
+        }
+
+        /// glBufferData with NULL orphans the old storage, so the GPU may still read last frame's lists.
+        void upload(unsigned int buffer, const void *data, size_t bytes) {
+            glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+            glBufferData(GL_TEXTURE_BUFFER, std::max(bytes, size_t(16)), NULL, GL_STREAM_DRAW);
+            if (bytes) glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, data);
+        }
+    }
+
+    ClusteredLights::ClusteredLights(int tilesX, int tilesY, int depthSlices)
+            : clusters_(tilesX, tilesY, depthSlices), bLightsDirty_(true), nearPlane_(0.1f), sliceScale_(1.f),
+              bLinearSlices_(false) {
+        createBufferTexture(lightBuffer_, lightTexture_, GL_RGBA32F);
+        createBufferTexture(rangeBuffer_, rangeTexture_, GL_RG32UI);
+        createBufferTexture(indexBuffer_, indexTexture_, GL_R32UI);
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+
+    ClusteredLights::~ClusteredLights() {
+        glDeleteTextures(1, &lightTexture_);
+        glDeleteTextures(1, &rangeTexture_);
+        glDeleteTextures(1, &indexTexture_);
+        glDeleteBuffers(1, &lightBuffer_);
+        glDeleteBuffers(1, &rangeBuffer_);
+        glDeleteBuffers(1, &indexBuffer_);
+    }
+
+    void ClusteredLights::update(const glm::mat4 &view, const glm::mat4 &projection, float nearPlane, float farPlane,
+                                 bool bOrthographic) {
+        auto start = std::chrono::steady_clock::now();
+        clusters_.build(lights_.data(), static_cast<int>(lights_.size()), glm::value_ptr(view),
+                        projection[0][0], projection[1][1], nearPlane, farPlane, bOrthographic);
+        nearPlane_ = nearPlane;
+        bLinearSlices_ = bOrthographic;
+        sliceScale_ = bOrthographic ? clusters_.depthSlices() / (farPlane - nearPlane)
+                                    : clusters_.depthSlices() / std::log(farPlane / nearPlane);
+
+        if (bLightsDirty_) {
+            upload(lightBuffer_, lights_.data(), lights_.size() * sizeof(SC::ClusterLight));
+            bLightsDirty_ = false;
+        }
+        upload(rangeBuffer_, clusters_.clusterRanges().data(), clusters_.clusterRanges().size() * sizeof(uint32_t));
+        upload(indexBuffer_, clusters_.lightIndices().data(), clusters_.lightIndices().size() * sizeof(uint32_t));
+        glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+        stats_.numLights = static_cast<int>(lights_.size());
+        stats_.maxPerCluster = clusters_.maxLightsPerCluster();
+        stats_.numIndices = clusters_.lightIndices().size();
+        stats_.cpuMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void ClusteredLights::bind(Shader *shader, int firstUnit) const {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        shader->set("viewportOrigin", static_cast<float>(viewport[0]), static_cast<float>(viewport[1]));
+        shader->set("viewportSize", static_cast<float>(viewport[2]), static_cast<float>(viewport[3]));
+        shader->set("clusterGrid", clusters_.tilesX(), clusters_.tilesY(), clusters_.depthSlices());
+        shader->set("clusterNear", nearPlane_);
+        shader->set("clusterSliceScale", sliceScale_);
+        shader->set("clusterLinear", bLinearSlices_);
+
+        const unsigned int textures[3] = {lightTexture_, rangeTexture_, indexTexture_};
+        const char *names[3] = {"lightData", "clusterRanges", "lightIndices"};
+        for (int i = 0; i < 3; ++i) {
+            glActiveTexture(GL_TEXTURE0 + firstUnit + i);
+            glBindTexture(GL_TEXTURE_BUFFER, textures[i]);
+            shader->setTexture(names[i], firstUnit + i);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+}
@@ -0,0 +1,61 @@
+//
+//  glClusteredLights.hpp
+//  Clustered forward lighting: point lights are binned on the CPU into view-space clusters (see
+//  light_clusters.hpp) and handed to the shader as texture buffers, so each fragment loops only over the
+//  lights of its own cluster.
+//
+//  Usage:
+//      lights.lights().push_back(light);           // marks the light buffer for upload
+//      lights.update(view, projection, near, far); // every frame, before drawing
+//      shader->use(); lights.bind(shader, 9);      // with Shaders/clusteredLighting.vs/.fs
+//
+
+#ifndef glClusteredLights_hpp
+#define glClusteredLights_hpp
+
+#include "glShader.hpp"
+#include "light_clusters.hpp"
+
+namespace glUtil {
+    class ClusteredLights {
+    public:
+        ClusteredLights(int tilesX = 16, int tilesY = 9, int depthSlices = 24);
+        ~ClusteredLights();
+
+        /// Mutable access marks the light buffer for re-upload.
+        std::vector<SC::ClusterLight> &lights() {
+            bLightsDirty_ = true;
+            return lights_;
+        }
+        const std::vector<SC::ClusterLight> &lights() const { return lights_; }
+
+        /// Bin the lights for this view and upload the cluster lists. Symmetric perspective or orthographic
+        /// projections, see SC::LightClusters.
+        void update(const glm::mat4 &view, const glm::mat4 &projection, float nearPlane, float farPlane,
+                    bool bOrthographic = false);
+
+        /// Set the clusteredLighting uniforms. Uses texture units firstUnit .. firstUnit + 2. Call while the
+        /// target framebuffer's viewport is set, as tiles are computed from gl_FragCoord.
+        void bind(Shader *shader, int firstUnit) const;
+
+        struct Statistics {
+            int numLights = 0;
+            int maxPerCluster = 0;
+            size_t numIndices = 0;
+            float cpuMs = 0; // binning + upload
+        };
+        const Statistics &statistics() const { return stats_; }
+
+    private:
+        SC::LightClusters clusters_;
+        std::vector<SC::ClusterLight> lights_;
+        bool bLightsDirty_;
+        float nearPlane_, sliceScale_;
+        bool bLinearSlices_; // orthographic view
+        unsigned int lightBuffer_, rangeBuffer_, indexBuffer_;
+        unsigned int lightTexture_, rangeTexture_, indexTexture_;
+        Statistics stats_;
+    };
+}
+
+#endif /* glClusteredLights_hpp */
@@ -0,0 +1,130 @@
+//
+//  glCompressedTexture.cpp
+//
+
+#include "glCompressedTexture.hpp"
+#include "glUtils.hpp"
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#ifdef WITH_STB
+#include <stb_image.h>
+#endif
+
+// EXT_texture_compression_s3tc / EXT_texture_sRGB, not part of glcorearb.h
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+namespace glUtil {
+    namespace {
+        GLenum internalFormat(const SC::CompressedImage &image) {
+            switch (image.format) {
+                case SC::BlockFormat::BC1:
+                    return image.bSRGB ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+                case SC::BlockFormat::BC3:
+                    return image.bSRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+                case SC::BlockFormat::BC5:
+                    return GL_COMPRESSED_RG_RGTC2;
+            }
+            return 0;
+        }
+
+        bool fileExists(const std::string &path) {
+            struct stat info;
+            return stat(path.c_str(), &info) == 0;
+        }
+    }
+
+    CompressedTextureCache::CompressedTextureCache(const std::string &cacheDir) : cacheDir_(cacheDir) {
+        if (!cacheDir_.empty() && cacheDir_.back() != '/') cacheDir_ += '/';
+        if (!fileExists(cacheDir_) && mkdir(cacheDir_.c_str(), 0755) != 0)
+            std::cout << "ERROR::COMPRESSEDTEXTURE::Cannot create the cache directory " << cacheDir_ << std::endl;
+    }
+
+    std::string CompressedTextureCache::cachePath(const std::string &path, SC::BlockFormat format, bool bSRGB) const {
+        return cacheDir_ + SC::CacheFileName(SC::HashTextureSource(path, format, bSRGB));
+    }
+
+    bool CompressedTextureCache::isSupported(SC::BlockFormat format) {
+        if (format == SC::BlockFormat::BC5) return true;
+        static int supported = -1;
+        if (supported < 0) {
+            supported = 0;
+            GLint count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (GLint i = 0; i < count; ++i) {
+                const char *name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+                if (name && std::strcmp(name, "GL_EXT_texture_compression_s3tc") == 0) supported = 1;
+            }
+        }
+        return supported == 1;
+    }
+
+    unsigned int CompressedTextureCache::upload(const SC::CompressedImage &image) {
+        if (!isSupported(image.format)) return 0;
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        const GLenum format = internalFormat(image);
+        for (size_t level = 0; level < image.levels.size(); ++level) {
+            const int width = std::max(1, image.width >> level), height = std::max(1, image.height >> level);
+            glCompressedTexImage2D(GL_TEXTURE_2D, GLint(level), format, width, height, 0,
+                                   GLsizei(image.levels[level].size()), image.levels[level].data());
+        }
+        // only the stored levels exist, no glGenerateMipmap
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(image.levels.size()) - 1);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                        image.levels.size() > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return textureID;
+    }
+
+    unsigned int CompressedTextureCache::load(const std::string &path, SC::BlockFormat format, bool bSRGB,
+                                              size_t *bytes) {
+        const std::string cached = cachePath(path, format, bSRGB);
+        auto count = [&](const SC::CompressedImage &image) {
+            size_t total = 0;
+            for (const auto &level : image.levels) total += level.size();
+            stats_.uploadedBytes += total;
+            if (bytes) *bytes = total;
+        };
+        if (isSupported(format)) {
+            if (fileExists(cached)) {
+                SC::CompressedImage image = SC::ReadKTX2(cached);
+                stats_.hits++;
+                count(image);
+                return upload(image);
+            }
+#ifdef WITH_STB
+            int width, height, channels;
+            unsigned char *data = stbi_load(path.c_str(), &width, &height, &channels, 4);
+            if (!data)
+                throw std::runtime_error("COMPRESSEDTEXTURE::Cannot decode " + path);
+            SC::CompressedImage image = SC::CompressImage(data, width, height, format, bSRGB);
+            stbi_image_free(data);
+            try {
+                SC::WriteKTX2(cached, image);
+            } catch (const std::runtime_error &e) {
+                std::cout << "ERROR::COMPRESSEDTEXTURE::" << e.what() << std::endl;
+            }
+            stats_.misses++;
+            count(image);
+            return upload(image);
+#endif
+        }
+        // no compressed path: decode and upload uncompressed as before
+        stats_.fallbacks++;
+        return Utils::uploadTexture(path.c_str(), bytes);
+    }
+}
@@ -0,0 +1,50 @@
+//
+//  glCompressedTexture.hpp
+//  Load textures as BCn blocks from a content-hash keyed KTX2 cache.
+//
+//  The cache holds <cacheDir>/<hash>.ktx2, where the hash covers the source file bytes and the encoding (see
+//  SC::HashTextureSource). Files are produced offline by tools/ktx2_convert, or on the first load if the
+//  library was built WITH_STB. Compressed levels, including the precomputed mips, are uploaded as they are.
+//
+//  Usage:
+//      glUtil::CompressedTextureCache cache("/path/to/cache");
+//      unsigned int texture = cache.load("albedo.png", SC::BlockFormat::BC1, true);
+//
+
+#ifndef glCompressedTexture_hpp
+#define glCompressedTexture_hpp
+
+#include "glShader.hpp"
+#include "texture_compression.hpp"
+
+namespace glUtil {
+    class CompressedTextureCache {
+    public:
+        explicit CompressedTextureCache(const std::string &cacheDir);
+
+        /// Returns a GL texture owned by the caller. On a cache miss the source is converted and stored if possible,
+        /// otherwise it is uploaded uncompressed with Utils::uploadTexture. Throws if the source cannot be read.
+        /// @param bytes set to the GPU memory of the texture if not null.
+        unsigned int load(const std::string &path, SC::BlockFormat format = SC::BlockFormat::BC1, bool bSRGB = false,
+                          size_t *bytes = nullptr);
+
+        std::string cachePath(const std::string &path, SC::BlockFormat format, bool bSRGB) const;
+
+        /// Upload all levels with glCompressedTexImage2D. Returns 0 if the format is not supported by the driver.
+        static unsigned int upload(const SC::CompressedImage &image);
+        /// S3TC (BC1/BC3) is an extension on desktop GL; RGTC (BC5) is core since 3.0.
+        static bool isSupported(SC::BlockFormat format);
+
+        struct Statistics {
+            int hits = 0, misses = 0, fallbacks = 0;
+            size_t uploadedBytes = 0; // compressed bytes sent to the GPU
+        };
+        const Statistics &statistics() const { return stats_; }
+
+    private:
+        std::string cacheDir_;
+        Statistics stats_;
+    };
+}
+
+#endif /* glCompressedTexture_hpp */
@@ -0,0 +1,154 @@
+//
+//  glGeometryArena.cpp
+//
+
+#include "glGeometryArena.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace glUtil {
+    namespace {
+        bool hasExtension(const char *extension) {
+            GLint count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (GLint i = 0; i < count; ++i) {
+                const char *name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+                if (name && std::strcmp(name, extension) == 0) return true;
+            }
+            return false;
+        }
+
+        /// Copy into a new, larger buffer. GL_COPY_*_BUFFER leave the VAO's element binding alone.
+        unsigned int grow(unsigned int buffer, size_t usedBytes, size_t newBytes) {
+            unsigned int bigger;
+            glGenBuffers(1, &bigger);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, bigger);
+            glBufferData(GL_COPY_WRITE_BUFFER, newBytes, nullptr, GL_STATIC_DRAW);
+            if (usedBytes) {
+                glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, usedBytes);
+            }
+            glDeleteBuffers(1, &buffer);
+            return bigger;
+        }
+    }
+
+    GeometryArena::GeometryArena(size_t vertexCapacity, size_t indexCapacity)
+            : vbo_(0), ebo_(0), vertexCapacity_(0), indexCapacity_(0), bIndirect(true) {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        bIndirectSupported = major > 4 || (major == 4 && minor >= 3) || hasExtension("GL_ARB_multi_draw_indirect");
+
+        glGenVertexArrays(1, &vao_);
+        glGenBuffers(1, &indirectBuffer_);
+        glGenBuffers(1, &vbo_);
+        glGenBuffers(1, &ebo_);
+        reserve(std::max<size_t>(vertexCapacity, 1), std::max<size_t>(indexCapacity, 3));
+    }
+
+    GeometryArena::~GeometryArena() {
+        glDeleteVertexArrays(1, &vao_);
+        glDeleteBuffers(1, &vbo_);
+        glDeleteBuffers(1, &ebo_);
+        glDeleteBuffers(1, &indirectBuffer_);
+    }
+
+    void GeometryArena::reserve(size_t vertices, size_t indices) {
+        if (vertices <= vertexCapacity_ && indices <= indexCapacity_) return;
+        if (vertices > vertexCapacity_) {
+            const size_t capacity = std::max(vertices, vertexCapacity_ * 2);
+            vbo_ = grow(vbo_, stats_.vertices * sizeof(Vertex), capacity * sizeof(Vertex));
+            vertexCapacity_ = capacity;
+        }
+        if (indices > indexCapacity_) {
+            const size_t capacity = std::max(indices, indexCapacity_ * 2);
+            ebo_ = grow(ebo_, stats_.indices * sizeof(GLuint), capacity * sizeof(GLuint));
+            indexCapacity_ = capacity;
+        }
+        glBindVertexArray(vao_);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
+        Mesh::setVertexAttributes();
+        glBindVertexArray(0);
+    }
+
+    int GeometryArena::add(const Vertex *vertices, size_t numVertices, const unsigned int *indices,
+                           size_t numIndices, const std::vector<Mesh::Lod> &lods) {
+        if (!numIndices)
+            throw std::runtime_error("GEOMETRYARENA::add::only indexed meshes can be merged.\n");
+        reserve(stats_.vertices + numVertices, stats_.indices + numIndices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, vbo_);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, stats_.vertices * sizeof(Vertex), numVertices * sizeof(Vertex), vertices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ebo_);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, stats_.indices * sizeof(GLuint), numIndices * sizeof(GLuint), indices);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+        Range range{GLuint(stats_.indices), GLint(stats_.vertices), lods};
+        if (range.lods.empty()) range.lods.push_back({0, (unsigned int) numIndices, 0.f});
+        ranges_.push_back(range);
+        stats_.vertices += numVertices;
+        stats_.indices += numIndices;
+        stats_.meshes++;
+        return int(ranges_.size()) - 1;
+    }
+
+    int GeometryArena::add(const Mesh &mesh) {
+        if (!mesh.vertices.empty() && !mesh.indices.empty())
+            return add(mesh.vertices.data(), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(), mesh.lods);
+
+        // read the uploaded data back; 16-bit indices are widened
+        std::vector<Vertex> vertices(mesh.getVertexCount());
+        std::vector<unsigned int> indices(mesh.getIndexCount());
+        glBindBuffer(GL_COPY_READ_BUFFER, mesh.vertexBuffer());
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, vertices.size() * sizeof(Vertex), vertices.data());
+        if (!indices.empty()) {
+            glBindBuffer(GL_COPY_READ_BUFFER, mesh.indexBuffer());
+            if (mesh.getIndexType() == GL_UNSIGNED_SHORT) {
+                std::vector<unsigned short> shortIndices(indices.size());
+                glGetBufferSubData(GL_COPY_READ_BUFFER, 0, shortIndices.size() * sizeof(unsigned short),
+                                   shortIndices.data());
+                std::copy(shortIndices.begin(), shortIndices.end(), indices.begin());
+            } else {
+                glGetBufferSubData(GL_COPY_READ_BUFFER, 0, indices.size() * sizeof(unsigned int), indices.data());
+            }
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        return add(vertices.data(), vertices.size(), indices.data(), indices.size(), mesh.lods);
+    }
+
+    void GeometryArena::queue(int handle, int lod) {
+        const Range &range = ranges_[handle];
+        const Mesh::Lod &level = range.lods[std::min(std::max(lod, 0), int(range.lods.size()) - 1)];
+        commands_.push_back({level.indexCount, 1, range.firstIndex + level.indexOffset, range.baseVertex, 0});
+    }
+
+    void GeometryArena::flush() {
+        if (commands_.empty()) return;
+        glBindVertexArray(vao_);
+        if (bIndirect && bIndirectSupported) {
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer_);
+            // orphan, so the previous batch can still be in flight
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, commands_.size() * sizeof(DrawCommand), nullptr, GL_STREAM_DRAW);
+            glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands_.size() * sizeof(DrawCommand), commands_.data());
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, GLsizei(commands_.size()), 0);
+            glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        } else {
+            counts_.resize(commands_.size());
+            offsets_.resize(commands_.size());
+            baseVertices_.resize(commands_.size());
+            for (size_t i = 0; i < commands_.size(); ++i) {
+                counts_[i] = GLsizei(commands_[i].count);
+                offsets_[i] = reinterpret_cast<const void *>(size_t(commands_[i].firstIndex) * sizeof(GLuint));
+                baseVertices_[i] = commands_[i].baseVertex;
+            }
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts_.data(), GL_UNSIGNED_INT, offsets_.data(),
+                                          GLsizei(commands_.size()), baseVertices_.data());
+        }
+        glBindVertexArray(0);
+        stats_.draws += commands_.size();
+        stats_.batches++;
+        commands_.clear();
+    }
+}
@@ -0,0 +1,85 @@
+//
+//  glGeometryArena.hpp
+//  Shared vertex and index buffers for many meshes, drawn with one call per batch.
+//
+//  Meshes are appended to one VBO/EBO pair behind a single VAO. Each draw is a record {count, firstIndex,
+//  baseVertex}; a batch of queued records is submitted with glMultiDrawElementsIndirect when the context is
+//  GL 4.3 or has ARB_multi_draw_indirect, otherwise with glMultiDrawElementsBaseVertex (GL 3.2 core).
+//  Everything in a batch shares the bound shader, uniforms and textures.
+//
+//  Usage:
+//      glUtil::GeometryArena arena;
+//      int handle = arena.add(mesh);
+//      shader->use(); bind textures
+//      arena.queue(handle, mesh.lod);
+//      ...
+//      arena.flush();
+//
+
+#ifndef glGeometryArena_hpp
+#define glGeometryArena_hpp
+
+#include "glMesh.hpp"
+
+namespace glUtil {
+    class GeometryArena {
+    public:
+        /// Layout of DrawElementsIndirectCommand.
+        struct DrawCommand {
+            GLuint count;
+            GLuint instanceCount;
+            GLuint firstIndex;
+            GLint baseVertex;
+            GLuint baseInstance;
+        };
+
+        struct Statistics {
+            size_t vertices = 0, indices = 0; // used
+            size_t meshes = 0;
+            size_t draws = 0;   // records submitted by the last flushes since resetStatistics
+            size_t batches = 0; // GL calls for them
+        };
+
+        explicit GeometryArena(size_t vertexCapacity = 1 << 16, size_t indexCapacity = 1 << 18);
+        ~GeometryArena();
+
+        /// Copy a mesh with all its levels of detail. Uses the CPU arrays of the mesh or, when they were not kept
+        /// (e.g. loaded from the mesh cache), reads its GPU buffers back. Returns the handle for queue().
+        int add(const Mesh &mesh);
+        int add(const Vertex *vertices, size_t numVertices, const unsigned int *indices, size_t numIndices,
+                const std::vector<Mesh::Lod> &lods = {});
+
+        void queue(int handle, int lod = 0);
+        /// Submit the queued draws and clear the queue.
+        void flush();
+
+        bool isIndirectSupported() const { return bIndirectSupported; }
+        /// Use glMultiDrawElementsIndirect when supported. Off forces the GL 3.3 path, e.g. to compare.
+        void setIndirect(bool option) { bIndirect = option; }
+
+        const Statistics &statistics() const { return stats_; }
+        void resetStatistics() { stats_.draws = stats_.batches = 0; }
+
+    private:
+        struct Range {
+            GLuint firstIndex;
+            GLint baseVertex;
+            std::vector<Mesh::Lod> lods;
+        };
+
+        void reserve(size_t vertices, size_t indices);
+
+        unsigned int vao_, vbo_, ebo_, indirectBuffer_;
+        size_t vertexCapacity_, indexCapacity_;
+        std::vector<Range> ranges_;
+        std::vector<DrawCommand> commands_;
+        // GL 3.3 path
+        std::vector<GLsizei> counts_;
+        std::vector<const void *> offsets_;
+        std::vector<GLint> baseVertices_;
+        bool bIndirectSupported, bIndirect;
+        Statistics stats_;
+    };
+}
+
+#endif /* glGeometryArena_hpp */
@@ -0,0 +1,71 @@
+/*
+ Usage:
+ Measure GPU time of a range of GL commands without stalling the pipeline.
+
+     timer.begin();
+     ... draw ...
+     timer.end();
+     float ms;
+     if (timer.poll(ms)) use(ms); // result of an earlier frame, once the GPU has finished it
+
+ A ring of GL_TIMESTAMP query pairs is used so the results are read a few frames later. Unlike GL_TIME_ELAPSED
+ queries, timer ranges may nest or overlap, e.g. the shadow pass inside the scene pass.
+*/
+#ifndef GLGPUTIMER_H
+#define GLGPUTIMER_H
+
+#include "glShader.hpp"
+
+namespace glUtil {
+    class GpuTimer {
+    public:
+        GpuTimer() : head_(0), tail_(0), count_(0), bActive_(false) {
+            glGenQueries(2 * kNumQueries, queries_);
+        }
+        ~GpuTimer() {
+            glDeleteQueries(2 * kNumQueries, queries_);
+        }
+
+        /// Start a measurement. Skipped if all queries are still in flight.
+        void begin() {
+            if (bActive_ || count_ == kNumQueries) return;
+            glQueryCounter(queries_[2 * head_], GL_TIMESTAMP);
+            bActive_ = true;
+        }
+
+        void end() {
+            if (!bActive_) return;
+            glQueryCounter(queries_[2 * head_ + 1], GL_TIMESTAMP);
+            bActive_ = false;
+            head_ = (head_ + 1) % kNumQueries;
+            count_++;
+        }
+
+        /// Non-blocking. Returns true and the newest finished measurement in milliseconds if there is one.
+        bool poll(float &milliseconds) {
+            bool bResult = false;
+            while (count_ > 0) {
+                GLint available = 0;
+                // the end timestamp is written last
+                glGetQueryObjectiv(queries_[2 * tail_ + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+                if (!available) break;
+                GLuint64 start = 0, stop = 0;
+                glGetQueryObjectui64v(queries_[2 * tail_], GL_QUERY_RESULT, &start);
+                glGetQueryObjectui64v(queries_[2 * tail_ + 1], GL_QUERY_RESULT, &stop);
+                milliseconds = static_cast<float>((stop - start) * 1e-6);
+                bResult = true;
+                tail_ = (tail_ + 1) % kNumQueries;
+                count_--;
+            }
+            return bResult;
+        }
+
+    private:
+        static const int kNumQueries = 4;
+        GLuint queries_[2 * kNumQueries]; // start and end timestamp per measurement
+        int head_, tail_, count_;
+        bool bActive_;
+    };
+} // end of namespace glUtil
+
+#endif
@@ -9,7 +9,13 @@
 #define materialsLighting_h
 
 #include <glm/glm.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
 #include <map>
+#include <sstream>
+#include <vector>
 #include "glShader.hpp"
 
 namespace glUtil{
@@ -32,7 +38,6 @@ namespace glUtil{
             shader->set(name + ".shininess", typeMaps[type].shininess);
         }
         
-    private:
         struct Lighting {
             glm::vec3 ambient;
             glm::vec3 diffuse;
@@ -45,6 +50,10 @@ namespace glUtil{
                 shininess = shininess_*128;
             }
         };
+        const Lighting &get(Materials type) const { return typeMaps.at(type); }
+        static const int kNumMaterials = yellowRubber + 1;
+
+    private:
         std::map<Materials, Lighting> typeMaps;
         void setDefault(){
             typeMaps[emerald].init(glm::vec3(0.0215f, 0.1745f, 0.0215f), glm::vec3(0.07568f, 0.61424f, 0.07568f), glm::vec3(0.633f, 0.727811f, 0.633f), 0.6f);
@@ -65,7 +74,7 @@ namespace glUtil{
             typeMaps[redPlastic].init(glm::vec3(0.f), glm::vec3(0.5f, 0.f, 0.f), glm::vec3(0.7f, 0.6f, 0.6f), 0.25f);
             typeMaps[whitePlastic].init(glm::vec3(0.f), glm::vec3(0.55f), glm::vec3(0.7f), 0.25f);
             typeMaps[yellowPlastic].init(glm::vec3(0.f), glm::vec3(0.5f, 0.5f, 0.f), glm::vec3(0.6f, 0.6f, 0.5f), 0.25f);
-            typeMaps[blackPlastic].init(glm::vec3(0.02f), glm::vec3(0.01f), glm::vec3(0.4f), 0.078125f);
+            typeMaps[blackRubber].init(glm::vec3(0.02f), glm::vec3(0.01f), glm::vec3(0.4f), 0.078125f);
             typeMaps[cyanRubber].init(glm::vec3(0.f, 0.05f, 0.05f), glm::vec3(0.4f, 0.5f, 0.5f), glm::vec3(0.04f, 0.7f, 0.7f), 0.078125f);
             typeMaps[greenRubber].init(glm::vec3(0.f, 0.05f, 0.0f), glm::vec3(0.4f, 0.5f, 0.4f), glm::vec3(0.04f, 0.7f, 0.04f), 0.078125f);
             typeMaps[redRubber].init(glm::vec3(0.05f, 0.f, 0.f), glm::vec3(0.5f, 0.4f, 0.4f), glm::vec3(0.7f, 0.04f, 0.04f), 0.078125f);
@@ -73,6 +82,167 @@ namespace glUtil{
             typeMaps[yellowRubber].init(glm::vec3(0.05f, 0.05f, 0.f), glm::vec3(0.5f, 0.5f, 0.4f), glm::vec3(0.7f, 0.7f, 0.04f), 0.078125f);
         }
     };
+
+    /**
+     All materials in one std140 uniform buffer (Shaders/materialTable.vs/.fs). Upload once, then a draw only
+     selects its material by index: the "materialIndex" uniform, plus the per-instance attribute of
+     setInstanceAttributes() for instanced draws. Replaces the four string-named uniforms per draw of setTo().
+     Opt-in: Mesh and Model still draw with their own shaders, this is for callers that draw with materialTable.
+
+     The table holds capacity() materials, as many as GL_MAX_UNIFORM_BLOCK_SIZE allows up to kMaxMaterials
+     (341 at the 16 KB GL 3.3 guarantees). createShader() compiles materialTable with that size.
+
+     Usage:
+         MaterialBuffer materials;
+         materials.addPresets(ShaderMatrialLighting()); // index == ShaderMatrialLighting::Materials
+         int custom = materials.add(ambient, diffuse, specular, 32.f);
+         materials.upload();
+         Shader *shader = materials.createShader(vsPath, fsPath);
+         materials.bindTo(shader);
+         MaterialBuffer::select(shader, custom); draw...
+     */
+    class MaterialBuffer {
+    public:
+        static const int kMaxMaterials = 1024; // upper bound of capacity()
+
+        /// Per-instance data of setInstanceAttributes(): model matrix and material index.
+        struct InstanceData {
+            glm::mat4 model;
+            int material;
+        };
+
+        explicit MaterialBuffer(unsigned int bindingPoint = 1) : bindingPoint_(bindingPoint), dirtyBegin_(0), dirtyEnd_(0) {
+            GLint maxBlockSize = 16384;
+            glGetIntegerv(GL_MAX_UNIFORM_BLOCK_SIZE, &maxBlockSize);
+            capacity_ = std::min(kMaxMaterials, int(maxBlockSize / GLint(sizeof(Entry))));
+            glGenBuffers(1, &ubo_);
+            glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+            glBufferData(GL_UNIFORM_BUFFER, capacity_ * sizeof(Entry), NULL, GL_STATIC_DRAW);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint_, ubo_);
+        }
+        ~MaterialBuffer() { glDeleteBuffers(1, &ubo_); }
+
+        /// Returns the index of the new material, or -1 if the table is full.
+        int add(const glm::vec3 &ambient, const glm::vec3 &diffuse, const glm::vec3 &specular, float shininess) {
+            if (entries_.size() >= size_t(capacity_)) {
+                std::cout << "ERROR::MATERIALBUFFER::At most " << capacity_ << " materials" << std::endl;
+                return -1;
+            }
+            entries_.push_back(Entry());
+            const int index = static_cast<int>(entries_.size()) - 1;
+            set(index, ambient, diffuse, specular, shininess);
+            return index;
+        }
+
+        void set(int index, const glm::vec3 &ambient, const glm::vec3 &diffuse, const glm::vec3 &specular, float shininess) {
+            Entry &entry = entries_.at(index);
+            entry.ambient = glm::vec4(ambient, 1.f);
+            entry.diffuse = glm::vec4(diffuse, 1.f);
+            entry.specular = glm::vec4(specular, shininess);
+            markDirty(index);
+        }
+
+        /// Appends the presets in enum order, so the index of a preset is its Materials value if the table was empty.
+        void addPresets(const ShaderMatrialLighting &presets) {
+            for (int i = 0; i < ShaderMatrialLighting::kNumMaterials; ++i) {
+                const auto &l = presets.get(static_cast<ShaderMatrialLighting::Materials>(i));
+                add(l.ambient, l.diffuse, l.specular, l.shininess);
+            }
+        }
+
+        /// Upload the entries changed since the last upload.
+        void upload() {
+            if (dirtyBegin_ >= dirtyEnd_) return;
+            glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+            glBufferSubData(GL_UNIFORM_BUFFER, dirtyBegin_ * sizeof(Entry), (dirtyEnd_ - dirtyBegin_) * sizeof(Entry),
+                            &entries_[dirtyBegin_]);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            dirtyBegin_ = dirtyEnd_ = 0;
+        }
+
+        /// Compile materialTable.vs/.fs (or shaders declaring MaterialBlock the same way) with MAX_MATERIALS set
+        /// to capacity(), so the block fits the driver's limit. The caller owns the shader.
+        Shader *createShader(const std::string &vertexPath, const std::string &fragmentPath) const {
+            auto read = [this](const std::string &path) {
+                std::ifstream file(path);
+                if (!file.is_open())
+                    throw std::runtime_error("MATERIALBUFFER::createShader::Unable to open " + path + "\n");
+                std::stringstream code;
+                std::string line;
+                while (std::getline(file, line)) {
+                    if (line.compare(0, 22, "#define MAX_MATERIALS ") == 0)
+                        line = "#define MAX_MATERIALS " + std::to_string(capacity_);
+                    code << line << '\n';
+                }
+                return code.str();
+            };
+            Shader *shader = new Shader();
+            shader->compileShader(read(vertexPath), read(fragmentPath));
+            return shader;
+        }
+
+        /// Select a material for the next draw: the "materialIndex" uniform, and 0 for the per-instance index at
+        /// location 5. An int attribute without an enabled array reads the current generic value, which is float
+        /// unless set with glVertexAttribI*, so it is set on every draw rather than relied on.
+        static void select(Shader *shader, int index) {
+            shader->set("materialIndex", index);
+            glVertexAttribI1i(5, 0);
+        }
+
+        /// Point the shader's uniform block at this buffer. Once per shader, not per draw.
+        void bindTo(Shader *shader, const std::string &blockName = "MaterialBlock") const {
+            GLuint blockIndex = glGetUniformBlockIndex(shader->ID, blockName.c_str());
+            if (blockIndex == GL_INVALID_INDEX) {
+                std::cout << "ERROR::MATERIALBUFFER::Uniform block " << blockName << " not found" << std::endl;
+                return;
+            }
+            glUniformBlockBinding(shader->ID, blockIndex, bindingPoint_);
+            glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint_, ubo_);
+        }
+
+        /// Per-instance material index (location 5) and model matrix (locations 6-9) from a buffer of InstanceData.
+        /// Mesh attributes 0-4 are left alone.
+        static void setInstanceAttributes(unsigned int vao, unsigned int instanceVBO) {
+            glBindVertexArray(vao);
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+            glEnableVertexAttribArray(5);
+            glVertexAttribIPointer(5, 1, GL_INT, sizeof(InstanceData), (void *) offsetof(InstanceData, material));
+            glVertexAttribDivisor(5, 1);
+            for (int i = 0; i < 4; ++i) {
+                glEnableVertexAttribArray(6 + i);
+                glVertexAttribPointer(6 + i, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                                      (void *) (offsetof(InstanceData, model) + i * sizeof(glm::vec4)));
+                glVertexAttribDivisor(6 + i, 1);
+            }
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+
+        int size() const { return static_cast<int>(entries_.size()); }
+        int capacity() const { return capacity_; }
+        unsigned int getUBO() const { return ubo_; }
+
+    private:
+        /// std140 layout: three vec4, 48 bytes. specular.w holds the shininess.
+        struct Entry {
+            glm::vec4 ambient, diffuse, specular;
+        };
+        unsigned int ubo_, bindingPoint_;
+        int capacity_;
+        std::vector<Entry> entries_;
+        size_t dirtyBegin_, dirtyEnd_;
+
+        void markDirty(int index) {
+            if (dirtyBegin_ >= dirtyEnd_) {
+                dirtyBegin_ = index;
+                dirtyEnd_ = index + 1;
+            } else {
+                dirtyBegin_ = std::min(dirtyBegin_, size_t(index));
+                dirtyEnd_ = std::max(dirtyEnd_, size_t(index) + 1);
+            }
+        }
+    };
 }
 
 #endif /* materialsLighting_h */
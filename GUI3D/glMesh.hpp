@@ -7,6 +7,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "glShader.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_simplifier.hpp"
+#include "glTextureArrays.hpp"
 
 #include <string>
 #include <fstream>
@@ -14,6 +17,8 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <cfloat>
 
 namespace glUtil{
     struct Vertex {
@@ -53,30 +58,54 @@ namespace glUtil{
     
     class Mesh : public Model_base {
     public:
+        // A level of detail: a range of the index buffer, all levels share the vertices
+        struct Lod {
+            unsigned int indexOffset, indexCount;
+            float error; // largest deviation from the full mesh, model units
+        };
+        
         /*  Mesh Data  */
         std::vector<Vertex> vertices;
         std::vector<unsigned int> indices;
         std::vector<Texture> textures;
+        std::vector<Lod> lods; // fine to coarse, lods[0] is the full mesh
+        int lod = 0;           // level drawn by Draw()
+        glm::vec3 boundCenter = glm::vec3(0.f);
+        float boundRadius = 0;
         unsigned int VAO;
         
         /*  Functions  */
         // constructor
-        Mesh(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices, const std::vector<Texture> &textures)
+        Mesh(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices, const std::vector<Texture> &textures,
+             const std::vector<Lod> &lods = {})
         {
             this->vertices = vertices;
             this->indices = indices;
             this->textures = textures;
+            this->lods = lods;
             setupMesh();
         }
         
+        // a triangle soup, welded and indexed on upload
         Mesh(const std::vector<Vertex> &vertices)
         {
             this->vertices = vertices;
             this->indices.clear();
             this->textures = textures;
+            optimize(this->vertices, this->indices);
             setupMesh();
         }
         
+        // upload straight from memory that only has to live during the call, e.g. a mapped mesh cache.
+        // vertices and indices stay empty.
+        Mesh(const Vertex *vertices, size_t numVertices, const unsigned int *indices, size_t numIndices,
+             const std::vector<Texture> &textures, const std::vector<Lod> &lods = {})
+        {
+            this->textures = textures;
+            this->lods = lods;
+            setupMesh(vertices, numVertices, indices, numIndices);
+        }
+        
         virtual ~Mesh()
         {
             glDeleteVertexArrays(1, &VAO);
@@ -101,11 +130,84 @@ namespace glUtil{
         /// inherit the init from Model_base
         void init(){}
         
+        /**
+         Weld identical vertices, order the triangles for the vertex cache and overdraw, then the vertices by first
+         use. An empty index list is treated as a triangle soup and filled in.
+         */
+        static void optimize(std::vector<Vertex> &vertices, std::vector<unsigned int> &indices)
+        {
+            if(vertices.empty()) return;
+            const bool soup = indices.empty();
+            const size_t numIndices = soup ? vertices.size() : indices.size();
+            std::vector<unsigned int> remap(vertices.size()), welded(numIndices), ordered(numIndices);
+            const size_t unique = SC::GenerateVertexRemap(remap.data(), soup ? nullptr : indices.data(), numIndices,
+                                                          vertices.data(), vertices.size(), sizeof(Vertex));
+            std::vector<Vertex> uniqueVertices(unique);
+            SC::RemapVertices(uniqueVertices.data(), vertices.data(), vertices.size(), sizeof(Vertex), remap.data());
+            SC::RemapIndices(welded.data(), soup ? nullptr : indices.data(), numIndices, remap.data());
+            SC::OptimizeVertexCache(ordered.data(), welded.data(), numIndices, unique);
+            SC::OptimizeOverdraw(welded.data(), ordered.data(), numIndices, uniqueVertices.data(), unique, sizeof(Vertex));
+            vertices.resize(unique);
+            vertices.resize(SC::OptimizeVertexFetch(vertices.data(), welded.data(), numIndices,
+                                                    uniqueVertices.data(), unique, sizeof(Vertex)));
+            indices.swap(welded);
+        }
+        
+        /**
+         Simplify an optimized mesh into up to maxLevels levels of detail, each about ratio times the triangles of
+         the previous one. The coarser levels are appended to indices; the result describes all levels, including
+         the full mesh. Stops early once a level cannot be reduced by at least 10%.
+         */
+        static std::vector<Lod> buildLods(const std::vector<Vertex> &vertices, std::vector<unsigned int> &indices,
+                                          int maxLevels = 5, float ratio = 0.5f)
+        {
+            std::vector<Lod> lods{{0, (unsigned int)indices.size(), 0.f}};
+            std::vector<unsigned int> simplified(indices.size()), ordered;
+            for(int level = 1; level < maxLevels; ++level) {
+                const Lod previous = lods.back();
+                float error = 0;
+                const size_t count = SC::SimplifyMesh(simplified.data(), indices.data() + previous.indexOffset,
+                                                      previous.indexCount, vertices.data(), vertices.size(), sizeof(Vertex),
+                                                      size_t(previous.indexCount * ratio) / 3 * 3, FLT_MAX, &error);
+                if(count == 0 || count > previous.indexCount * 9 / 10) break;
+                ordered.resize(count);
+                SC::OptimizeVertexCache(ordered.data(), simplified.data(), count, vertices.size());
+                lods.push_back({(unsigned int)indices.size(), (unsigned int)count, std::max(error, previous.error)});
+                indices.insert(indices.end(), ordered.begin(), ordered.end());
+            }
+            return lods;
+        }
+        
+        size_t triangleCount() const { return numIndices ? currentLod().indexCount / 3 : numVertices / 3; }
+        
         // render the mesh
         void Draw()
         {
+            bindTextures();
+            
+            // draw mesh
+            glBindVertexArray(VAO);
+            if(numIndices) {
+                const Lod &level = currentLod();
+                const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+                glDrawElements(GL_TRIANGLES, level.indexCount, indexType, (void*)(level.indexOffset * indexSize));
+            }
+            else
+                glDrawArrays(GL_TRIANGLES, 0, numVertices);
+            glBindVertexArray(0);
+            
+            // always good practice to set everything back to defaults once configured.
+            glActiveTexture(GL_TEXTURE0);
+        }
+        
+        // bind the textures to units 0..n-1 and set the samplers of the current shader, e.g. before a merged draw
+        void bindTextures()
+        {
+            if(textureArrays) {
+                setTextureSlots();
+                return;
+            }
             for(auto& pair : texNameMap) pair.second = 1;
-            // bind appropriate textures
             for(unsigned int i = 0; i < textures.size(); i++)
             {
                 // retrieve texture number (the N in diffuse_textureN)
@@ -121,17 +223,44 @@ namespace glUtil{
                 shader->set(texName.c_str(), static_cast<int>(i));
                 glBindTexture(textures[i].type, textures[i].id);// and finally bind the texture
             }
-            
-            // draw mesh
-            glBindVertexArray(VAO);
-            if(indices.size())
-                glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-            else
-                glDrawArrays(GL_TRIANGLES, 0, vertices.size());
-            glBindVertexArray(0);
-            
-            // always good practice to set everything back to defaults once configured.
-            glActiveTexture(GL_TEXTURE0);
+        }
+        
+        /**
+         Address the textures through TextureArrays instead of binding them: bindTextures() then only sets one
+         uniform per texture, <name>N_slot (array, layer) or the bindless handle in <name>N. The arrays must be
+         built and contain the textures of this mesh; nullptr goes back to binding textures.
+         */
+        void setTextureArrays(const TextureArrays *arrays)
+        {
+            textureArrays = arrays;
+            slotProgram = 0;
+        }
+        
+        // GPU buffers, e.g. to copy the mesh into a GeometryArena
+        unsigned int vertexBuffer() const { return VBO; }
+        unsigned int indexBuffer() const { return EBO; }
+        GLenum getIndexType() const { return indexType; }
+        GLsizei getVertexCount() const { return numVertices; }
+        GLsizei getIndexCount() const { return numIndices; }
+        
+        // attribute layout of Vertex for the VAO and GL_ARRAY_BUFFER currently bound
+        static void setVertexAttributes()
+        {
+            // vertex Positions
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+            // vertex normals
+            glEnableVertexAttribArray(1);
+            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+            // vertex texture coords
+            glEnableVertexAttribArray(2);
+            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+            // vertex tangent
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
+            // vertex bitangent
+            glEnableVertexAttribArray(4);
+            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
         }
 
         std::vector<std::pair<std::string, std::string>>  generateTexNames(){
@@ -168,17 +297,85 @@ namespace glUtil{
         //
         std::map<std::string, unsigned int> texNameMap;
         
+        const TextureArrays *textureArrays = nullptr;
+        unsigned int slotProgram = 0;      // program the locations below belong to
+        std::vector<GLint> slotLocations;  // per texture
+        std::vector<int> slotIndices;      // per texture, in textureArrays
+        std::vector<GLint> pairedLocations; // per texture in array mode, the other one of <name> and <name>_slot
+        
+        void setTextureSlots()
+        {
+            if(slotProgram != shader->ID) {
+                // names are built once per shader instead of every draw
+                slotProgram = shader->ID;
+                slotLocations.clear();
+                slotIndices.clear();
+                pairedLocations.clear();
+                for(unsigned int i = 0; i < textures.size(); i++) {
+                    slotIndices.push_back(textures[i].type == GL_TEXTURE_2D ? textureArrays->slotOf(textures[i].id) : -1);
+                    slotLocations.push_back(-1);
+                }
+                const auto names = generateTexNames();
+                for(unsigned int i = 0; i < textures.size(); i++) {
+                    const bool bSlot = slotIndices[i] >= 0 && !textureArrays->isBindless();
+                    slotLocations[i] = glGetUniformLocation(shader->ID, (names[i].first + (bSlot ? "_slot" : "")).c_str());
+                    const bool bPaired = !textureArrays->isBindless() && textures[i].type == GL_TEXTURE_2D;
+                    pairedLocations.push_back(bPaired ? glGetUniformLocation(shader->ID, (names[i].first + (bSlot ? "" : "_slot")).c_str()) : -1);
+                }
+            }
+            for(unsigned int i = 0; i < textures.size(); i++) {
+                if(slotIndices[i] >= 0) {
+                    textureArrays->setSlot(slotLocations[i], slotIndices[i]);
+                    // the unused sampler still needs a unit of its own, not one of the arrays
+                    glUniform1i(pairedLocations[i], TextureArrays::kMaxArrays + int(i));
+                } else {
+                    // not in the arrays (e.g. cube maps): bound as usual, after the units of the arrays
+                    const int unit = TextureArrays::kMaxArrays + int(i);
+                    glActiveTexture(GL_TEXTURE0 + unit);
+                    glBindTexture(textures[i].type, textures[i].id);
+                    glUniform1i(slotLocations[i], unit);
+                    glUniform2i(pairedLocations[i], -1, -1); // did not fit into the arrays: sample the texture
+                }
+            }
+        }
+        
         /*  Render data  */
-        unsigned int VBO, EBO;
+        unsigned int VBO, EBO = 0;
+        GLsizei numVertices = 0, numIndices = 0;
+        GLenum indexType = GL_UNSIGNED_INT; // GL_UNSIGNED_SHORT when all vertices are reachable with 16 bits
         
         /*  Functions    */
         // initializes all the buffer objects/arrays
         void setupMesh()
         {
+            setupMesh(vertices.data(), vertices.size(), indices.data(), indices.size());
+        }
+        
+        const Lod &currentLod() const
+        {
+            return lods[std::min(std::max(lod, 0), int(lods.size()) - 1)];
+        }
+        
+        void setupMesh(const Vertex *vertices, size_t numVertices, const unsigned int *indices, size_t numIndices)
+        {
+            this->numVertices = GLsizei(numVertices);
+            this->numIndices = GLsizei(numIndices);
+            if(lods.empty())
+                lods.push_back({0, (unsigned int)numIndices, 0.f});
+            // bounding sphere around the box center, for LOD selection
+            glm::vec3 bmin(FLT_MAX), bmax(-FLT_MAX);
+            for(size_t i = 0; i < numVertices; ++i) {
+                bmin = glm::min(bmin, vertices[i].Position);
+                bmax = glm::max(bmax, vertices[i].Position);
+            }
+            boundCenter = numVertices ? (bmin + bmax) * 0.5f : glm::vec3(0.f);
+            boundRadius = 0;
+            for(size_t i = 0; i < numVertices; ++i)
+                boundRadius = std::max(boundRadius, glm::length(vertices[i].Position - boundCenter));
             // create buffers/arrays
             glGenVertexArrays(1, &VAO);
             glGenBuffers(1, &VBO);
-            if(indices.size())
+            if(numIndices)
                 glGenBuffers(1, &EBO);
             
             glBindVertexArray(VAO);
@@ -187,29 +384,22 @@ namespace glUtil{
             // A great thing about structs is that their memory layout is sequential for all its items.
             // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
             // again translates to 3/2 floats which translates to a byte array.
-            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+            glBufferData(GL_ARRAY_BUFFER, numVertices * sizeof(Vertex), vertices, GL_STATIC_DRAW);
             
-            if(indices.size()) {
+            if(numIndices) {
                 glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-                glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+                if(SC::FitsIndex16(numVertices)) {
+                    std::vector<unsigned short> shortIndices(indices, indices + numIndices);
+                    glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(unsigned short), shortIndices.data(), GL_STATIC_DRAW);
+                    indexType = GL_UNSIGNED_SHORT;
+                } else {
+                    glBufferData(GL_ELEMENT_ARRAY_BUFFER, numIndices * sizeof(unsigned int), indices, GL_STATIC_DRAW);
+                    indexType = GL_UNSIGNED_INT;
+                }
             }
             
             // set the vertex attribute pointers
-            // vertex Positions
-            glEnableVertexAttribArray(0);
-            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-            // vertex normals
-            glEnableVertexAttribArray(1);
-            glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-            // vertex texture coords
-            glEnableVertexAttribArray(2);
-            glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-            // vertex tangent
-            glEnableVertexAttribArray(3);
-            glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-            // vertex bitangent
-            glEnableVertexAttribArray(4);
-            glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+            setVertexAttributes();
 
             glBindVertexArray(0);
         }
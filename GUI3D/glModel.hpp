@@ -5,21 +5,27 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <stb_image.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
 #include "glMesh.hpp"
 #include "glShader.hpp"
+#include "glTextureCache.hpp"
+#include "mesh_cache.hpp"
+#include "projection_control.hpp"
+#include "glGeometryArena.hpp"
+#include "glTextureArrays.hpp"
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
-//#include <map>
 #include <vector>
 #include <set>
+#include <chrono>
+#include <memory>
+#include <map>
 
 #include <Eigen/Core>
 
@@ -39,16 +45,19 @@ namespace glUtil{
             float yRange()const{return pY-mY;}
             float zRange()const{return pZ-mZ;}
         };
-        std::vector<Texture> textures_loaded;    // stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+        std::vector<Texture> textures_loaded;    // textures referenced by this model. Each holds one reference in the TextureCache.
         std::vector<Mesh*> meshes;
         std::string directory, modelName;
         Eigen::Matrix4f model_pose;
         Boundaries boundaries;
         bool gammaCorrection;
+        bool bLoadedFromCache = false; // read from <path>.scmesh instead of Assimp
+        double loadTimeMs = 0; // wall time of the constructor, for load statistics
         
         /*  Functions   */
         // constructor, expects a filepath to a 3D model.
-        Model(std::string const &path, bool gamma = false) : gammaCorrection(gamma),
+        // With useCache, the imported meshes are stored in <path>.scmesh and mapped from there on the next load.
+        Model(std::string const &path, bool gamma = false, bool useCache = true) : gammaCorrection(gamma),
         hasLights(false), hasMeshes(false), hasCameras(false), hasTextures(false),
         hasMaterials(false), hasAnimations(false)
         {
@@ -65,11 +74,22 @@ namespace glUtil{
             vCorrName.push_back(corrNameMap(aiTextureType_LIGHTMAP  , "texture_lightmap"));
             vCorrName.push_back(corrNameMap(aiTextureType_REFLECTION, "texture_reflection"));
             //vCorrName.push_back(corrNameMap(aiTextureType_UNKNOWN, "texture_unknown"));
-            loadModel(path);
+            model_pose.setIdentity();
+            const auto start = std::chrono::steady_clock::now();
+            const std::string cachePath = path + ".scmesh";
+            bLoadedFromCache = useCache && loadCache(path, cachePath);
+            if(!bLoadedFromCache) {
+                loadModel(path);
+                if(useCache && meshes.size()) writeCache(path, cachePath);
+            }
+            loadTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
         }
         ~Model(){
+            textureArrays_.reset(); // handles go non-resident before the textures are released
             for(auto& pMesh : meshes)
                 delete pMesh;
+            for(auto& texture : textures_loaded)
+                TextureCache::instance().release(texture.id);
         }
         Model& operator = (const Model & model){
             if (this != &model) {
@@ -79,8 +99,16 @@ namespace glUtil{
                 if(this->shader)
                     delete this->shader;
                 this->shader = model.shader;
+                for(auto& texture : model.textures_loaded)
+                    TextureCache::instance().retain(texture.id);
+                for(auto& texture : this->textures_loaded)
+                    TextureCache::instance().release(texture.id);
                 this->textures_loaded = model.textures_loaded;
                 this->meshes = model.meshes;
+                this->arena_ = model.arena_;
+                this->arenaHandles_ = model.arenaHandles_;
+                this->drawGroups_ = model.drawGroups_;
+                this->textureArrays_ = model.textureArrays_;
                 this->directory = model.directory;
                 this->gammaCorrection = model.gammaCorrection;
                 this->vCorrName = model.vCorrName;
@@ -92,6 +120,60 @@ namespace glUtil{
         /// No need to init here. Just to inehrit the virtual class in Model_base
         void init(){};
        
+        /**
+         Copy all meshes into one GeometryArena and draw them with one multi-draw per set of textures instead of
+         one VAO bind and draw per mesh. Pass a shared arena to pack several models (a whole scene) into the same
+         buffers; each model still submits its own batches since the model matrix is a per-model uniform.
+         */
+        void mergeGeometry(std::shared_ptr<GeometryArena> arena = nullptr)
+        {
+            if(!arena) {
+                size_t vertexCount = 0, indexCount = 0;
+                for(const auto& pMesh : meshes) {
+                    vertexCount += pMesh->getVertexCount();
+                    indexCount += pMesh->getIndexCount();
+                }
+                arena = std::make_shared<GeometryArena>(vertexCount, indexCount);
+            }
+            arena_ = arena;
+            arenaHandles_.clear();
+            drawGroups_.clear();
+            std::map<std::vector<unsigned int>, size_t> groupOfTextures;
+            for(size_t i = 0; i < meshes.size(); ++i) {
+                arenaHandles_.push_back(arena_->add(*meshes[i]));
+                std::vector<unsigned int> key;
+                for(const auto& texture : meshes[i]->textures) key.push_back(texture.id);
+                auto found = groupOfTextures.emplace(key, drawGroups_.size());
+                if(found.second) drawGroups_.emplace_back();
+                drawGroups_[found.first->second].push_back(i);
+            }
+        }
+        bool isMerged() const { return arena_ != nullptr; }
+        
+        /// Add the 2D textures of all meshes to arrays that are not built yet, e.g. to share them between models.
+        void collectTextures(TextureArrays &arrays) const
+        {
+            for(const auto& pMesh : meshes)
+                for(const auto& texture : pMesh->textures)
+                    if(texture.type == GL_TEXTURE_2D) arrays.add(texture.id);
+        }
+        
+        /**
+         Sample the textures from TextureArrays (or bindless handles) instead of binding them per mesh. Draw then
+         binds the arrays once and each mesh only sets its slot uniforms. Without arrays, this model's textures are
+         packed into new ones. The shader needs the array declarations: regenerate it with outputShaderTemplate.
+         */
+        void useTextureArrays(std::shared_ptr<TextureArrays> arrays = nullptr, bool bPreferBindless = false)
+        {
+            if(!arrays) {
+                arrays = std::make_shared<TextureArrays>(bPreferBindless);
+                collectTextures(*arrays);
+            }
+            arrays->build();
+            textureArrays_ = arrays;
+            for(auto& pMesh : meshes) pMesh->setTextureArrays(arrays.get());
+        }
+        
         /// Draw the model using auto-generated shader
         void Draw()
         {
@@ -104,12 +186,59 @@ namespace glUtil{
                 shader = new Shader(pathvs.c_str(), pathfs.c_str());
                 hasOwnership = true;
             }
+            if(textureArrays_) textureArrays_->bind(shader, 0);
+            if(arena_) {
+                for(const auto& group : drawGroups_) {
+                    Mesh* first = meshes[group.front()];
+                    first->setShader(shader);
+                    first->bindTextures();
+                    for(size_t i : group)
+                        arena_->queue(arenaHandles_[i], meshes[i]->lod);
+                    arena_->flush();
+                }
+                glActiveTexture(GL_TEXTURE0);
+                return;
+            }
             for(unsigned int i = 0; i < meshes.size(); i++){
                 meshes[i]->setShader(shader);
                 meshes[i]->Draw();
             }
         }
         
+        /**
+         Pick the level of detail of every mesh from its projected error: the coarsest level that deviates less
+         than thresholdPixels from the full mesh on screen. Call once per frame before Draw.
+
+         @param cameraPosition World space.
+         @param hysteresis Coarser levels need an error below (1 - hysteresis) * thresholdPixels, to avoid popping
+         back and forth at the switching distance.
+         */
+        void selectLod(const glm::vec3 &cameraPosition, const SC::ProjectionControl &projection,
+                       float thresholdPixels = 1.f, float hysteresis = 0.25f)
+        {
+            const float scale = model_pose.block<3,3>(0,0).colwise().norm().maxCoeff();
+            std::vector<float> errors;
+            for(auto& pMesh : meshes) {
+                const Eigen::Vector3f center = model_pose.block<3,3>(0,0) *
+                    Eigen::Vector3f(pMesh->boundCenter.x, pMesh->boundCenter.y, pMesh->boundCenter.z) +
+                    model_pose.block<3,1>(0,3);
+                const float distance = (center - Eigen::Vector3f(cameraPosition.x, cameraPosition.y, cameraPosition.z)).norm()
+                                       - pMesh->boundRadius * scale;
+                errors.clear();
+                for(const auto& level : pMesh->lods) errors.push_back(level.error * scale);
+                pMesh->lod = SC::SelectLod(errors.data(), int(errors.size()), projection.pixels_per_unit(distance),
+                                           pMesh->lod, thresholdPixels, hysteresis);
+            }
+        }
+        
+        /// Triangles drawn at the current levels of detail.
+        size_t triangleCount() const
+        {
+            size_t count = 0;
+            for(const auto& pMesh : meshes) count += pMesh->triangleCount();
+            return count;
+        }
+        
         /**
          Manually change/add the texture to this model. The texture must be loaded first.
 
@@ -144,14 +273,36 @@ namespace glUtil{
             std::fstream ss(outputPath + ".fs", std::fstream::out);
             ss << "#version 330 core\n";
             
+            const bool bArrays = textureArrays_ && !textureArrays_->isBindless();
+            if(textureArrays_ && textureArrays_->isBindless())
+                ss << "#extension GL_ARB_bindless_texture : require\n";
+            
             std::set<std::pair<std::string, std::string>> unique_names;
             for(const auto& mesh : meshes) {
                 for (auto names : mesh->generateTexNames()) {
                     unique_names.insert(names);
                 }
             }
+            if(bArrays) {
+                // GLSL 330 can only index sampler arrays with constants, hence the switch
+                ss << "uniform sampler2DArray textureArrays[" << TextureArrays::kMaxArrays << "];\n";
+                ss << "vec4 textureSlot(ivec2 slot, vec2 uv){\n";
+                ss << "\tswitch(slot.x){\n";
+                for(int i = 0; i < TextureArrays::kMaxArrays; ++i)
+                    ss << "\t\tcase " << i << ": return texture(textureArrays[" << i << "], vec3(uv, slot.y));\n";
+                ss << "\t}\n";
+                ss << "\treturn vec4(0);\n";
+                ss << "}\n";
+            }
             for (const auto& name:unique_names) {
-                ss << "uniform " << name.second << " " << name.first << ";\n";
+                if(bArrays && name.second == "sampler2D") {
+                    // the sampler takes textures that did not fit into the arrays (slot -1)
+                    ss << "uniform ivec2 " << name.first << "_slot;\n";
+                    ss << "uniform " << name.second << " " << name.first << ";\n";
+                } else if(textureArrays_ && name.second == "sampler2D")
+                    ss << "layout(bindless_sampler) uniform " << name.second << " " << name.first << ";\n";
+                else
+                    ss << "uniform " << name.second << " " << name.first << ";\n";
             }
             
             ss << "out vec4 FragColor;\n";
@@ -162,8 +313,13 @@ namespace glUtil{
             ss << "in vec3 BiTangent;\n";
             ss << "void main(){\n";
             ss << "\tvec4 result = vec4(0,0,0,0);\n";
-            for (const auto& name:unique_names)
-                ss << "\tresult += texture(" << name.first << ", TexCoords);\n";
+            for (const auto& name:unique_names) {
+                if(bArrays && name.second == "sampler2D")
+                    ss << "\tresult += " << name.first << "_slot.x >= 0 ? textureSlot(" << name.first
+                       << "_slot, TexCoords) : texture(" << name.first << ", TexCoords);\n";
+                else
+                    ss << "\tresult += texture(" << name.first << ", TexCoords);\n";
+            }
             ss << "\tresult /= " << unique_names.size() << ".0;\n";
             ss << "\tresult.w = 1;\n";
             ss << "\tFragColor = result;\n";
@@ -233,7 +389,81 @@ namespace glUtil{
         
         bool hasLights, hasMeshes, hasCameras, hasTextures, hasMaterials, hasAnimations; // material = textures
         
+        std::shared_ptr<GeometryArena> arena_;
+        std::vector<int> arenaHandles_;              // per mesh
+        std::vector<std::vector<size_t>> drawGroups_; // mesh indices sharing the same textures
+        std::shared_ptr<TextureArrays> textureArrays_;
+        
         /*  Functions   */
+        void setNames(std::string const &path)
+        {
+            // retrieve the directory path of the filepath
+            directory = path.substr(0, path.find_last_of('/'));
+            modelName = path.substr(directory.length()+1, path.length());
+            modelName = modelName.substr(0, modelName.find_last_of('.'));
+        }
+        
+        bool loadCache(std::string const &path, std::string const &cachePath)
+        {
+            SC::MappedMeshCache cache;
+            if(!cache.open(cachePath, path, sizeof(Vertex))) {
+                if(cache.error() != "no cache file")
+                    printf("MODEL::Ignoring mesh cache %s: %s\n", cachePath.c_str(), cache.error().c_str());
+                return false;
+            }
+            setNames(path);
+            const float *b = cache.bounds();
+            boundaries.mX = b[0]; boundaries.mY = b[1]; boundaries.mZ = b[2];
+            boundaries.pX = b[3]; boundaries.pY = b[4]; boundaries.pZ = b[5];
+            const uint32_t flags = cache.flags();
+            hasLights = flags & 1; hasMeshes = flags & 2; hasCameras = flags & 4;
+            hasTextures = flags & 8; hasMaterials = flags & 16; hasAnimations = flags & 32;
+            for(size_t i = 0; i < cache.numMeshes(); ++i) {
+                const SC::MappedMeshCache::MeshView view = cache.mesh(i);
+                std::vector<Texture> textures;
+                for(const auto& t : view.textures) {
+                    Texture texture;
+                    texture.id = TextureFromFile(t.path.c_str(), this->directory, t.name);
+                    texture.name = t.name;
+                    texture.type = GL_TEXTURE_2D;
+                    texture.path = t.path;
+                    textures.push_back(texture);
+                    textures_loaded.push_back(texture);
+                }
+                std::vector<Mesh::Lod> lods;
+                for(const auto& level : view.lods)
+                    lods.push_back({level.indexOffset, level.indexCount, level.error});
+                // uploaded from the mapping, no intermediate copy
+                meshes.push_back(new Mesh(static_cast<const Vertex*>(view.vertices), view.numVertices,
+                                          view.indices, view.numIndices, textures, lods));
+            }
+            return true;
+        }
+        
+        void writeCache(std::string const &path, std::string const &cachePath)
+        {
+            SC::MeshCacheWriter writer(sizeof(Vertex));
+            for(const auto& pMesh : meshes) {
+                std::vector<SC::MeshCacheTexture> textures;
+                for(const auto& texture : pMesh->textures)
+                    textures.push_back({texture.name, texture.path});
+                std::vector<SC::MeshCacheLod> lods;
+                for(const auto& level : pMesh->lods)
+                    lods.push_back({level.indexOffset, level.indexCount, level.error});
+                writer.addMesh(pMesh->vertices.data(), uint32_t(pMesh->vertices.size()),
+                               pMesh->indices.data(), uint32_t(pMesh->indices.size()), textures, lods);
+            }
+            const float bounds[6] = {boundaries.mX, boundaries.mY, boundaries.mZ, boundaries.pX, boundaries.pY, boundaries.pZ};
+            writer.setBounds(bounds);
+            writer.setFlags(hasLights | hasMeshes << 1 | hasCameras << 2 | hasTextures << 3 | hasMaterials << 4 |
+                            hasAnimations << 5);
+            try {
+                writer.write(cachePath, path);
+            } catch (const std::runtime_error &e) {
+                std::cout << "ERROR::MODEL::" << e.what() << std::endl;
+            }
+        }
+        
         // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes std::vector.
         void loadModel(std::string const &path)
         {
@@ -253,10 +483,7 @@ namespace glUtil{
                 std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
                 return;
             }
-            // retrieve the directory path of the filepath
-            directory = path.substr(0, path.find_last_of('/'));
-            modelName = path.substr(directory.length()+1, path.length());
-            modelName = modelName.substr(0, modelName.find_last_of('.'));
+            setNames(path);
             
             // process ASSIMP's root node recursively
             processNode(scene->mRootNode, scene);
@@ -381,13 +608,18 @@ namespace glUtil{
                 textures.insert(textures.end(), maps.begin(), maps.end());
             }
 
+            // weld, reorder and simplify once at import; the mesh cache stores the result
+            Mesh::optimize(vertices, indices);
+            const std::vector<Mesh::Lod> lods = Mesh::buildLods(vertices, indices);
+            
             // return a mesh object created from the extracted mesh data
 //            return Mesh(vertices, indices, textures);
-            Mesh* pMesh = new Mesh(vertices, indices, textures);
+            Mesh* pMesh = new Mesh(vertices, indices, textures, lods);
             return pMesh;
         }
         
         // checks all material textures of a given type and loads the textures if they're not loaded yet.
+        // Textures are shared through the TextureCache, also across models using the same files.
         // the required info is returned as a Texture struct.
         std::vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName)
         {
@@ -396,71 +628,27 @@ namespace glUtil{
             {
                 aiString str;
                 mat->GetTexture(type, i, &str);
-                // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-                bool skip = false;
-                for(unsigned int j = 0; j < textures_loaded.size(); j++)
-                {
-                    if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                    {
-                        textures.push_back(textures_loaded[j]);
-                        skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                        break;
-                    }
-                }
-                if(!skip)
-                {   // if texture hasn't been loaded already, load it
-                    Texture texture;
-                    texture.id = TextureFromFile(str.C_Str(), this->directory);
-                    texture.name = typeName;
-                    texture.type = GL_TEXTURE_2D;
-                    texture.path = str.C_Str();
-                    textures.push_back(texture);
-                    textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-                }
+                Texture texture;
+                texture.id = TextureFromFile(str.C_Str(), this->directory, typeName);
+                texture.name = typeName;
+                texture.type = GL_TEXTURE_2D;
+                texture.path = str.C_Str();
+                textures.push_back(texture);
+                textures_loaded.push_back(texture);  // one cache reference per use, released in the destructor
             }
             return textures;
         }
         
-        unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma = false)
+        // compressed when TextureCache::setCompression is on: BC3 keeps the alpha of diffuse and opacity maps,
+        // BC1 for the rest. Normal maps stay BC1 since the shaders read xyz and BC5 would need z rebuilt.
+        unsigned int TextureFromFile(const char *path, const std::string &directory, const std::string &typeName,
+                                     bool gamma = false)
         {
             std::string filename = std::string(path);
             filename = directory + '/' + filename;
-            
-            unsigned int textureID;
-            glGenTextures(1, &textureID);
-            
-            int width, height, nrComponents;
-            unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-            if (data)
-            {
-                GLenum format;
-                if (nrComponents == 1)
-                    format = GL_RED;
-                else if (nrComponents == 3)
-                    format = GL_RGB;
-                else if (nrComponents == 4)
-                    format = GL_RGBA;
-                else
-                    throw "glMODEL::TextureFromFile::format doesn't support.\n";
-                
-                glBindTexture(GL_TEXTURE_2D, textureID);
-                glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-                glGenerateMipmap(GL_TEXTURE_2D);
-                
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                
-                stbi_image_free(data);
-            }
-            else
-            {
-                std::cout << "Texture failed to load at path: " << path << std::endl;
-                stbi_image_free(data);
-            }
-            
-            return textureID;
+            const bool bAlpha = typeName.find("diffuse") != std::string::npos ||
+                                typeName.find("opacity") != std::string::npos;
+            return TextureCache::instance().acquire(filename, bAlpha ? SC::BlockFormat::BC3 : SC::BlockFormat::BC1);
         }
     };
     
@@ -0,0 +1,143 @@
+//
+//  glOIT.cpp
+//
+
+#include "glOIT.hpp"
+#include <algorithm>
+
+namespace glUtil {
+    WeightedBlendedOIT::WeightedBlendedOIT(const std::string &shaderPath, int width, int height)
+            : width_(0), height_(0) {
+        glGenFramebuffers(1, &fbo_);
+        glGenTextures(1, &accumTexture_);
+        glGenTextures(1, &weightTexture_);
+        for (unsigned int texture : {accumTexture_, weightTexture_}) {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        resize(width, height);
+
+        float quadVertices[] = {
+                // positions   // texCoords
+                -1.0f, 1.0f, 0.0f, 1.0f,
+                -1.0f, -1.0f, 0.0f, 0.0f,
+                1.0f, -1.0f, 1.0f, 0.0f,
+
+                -1.0f, 1.0f, 0.0f, 1.0f,
+                1.0f, -1.0f, 1.0f, 0.0f,
+                1.0f, 1.0f, 1.0f, 1.0f
+        };
+        glGenVertexArrays(1, &quadVAO_);
+        glGenBuffers(1, &quadVBO_);
+        glBindVertexArray(quadVAO_);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO_);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) 0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) (2 * sizeof(float)));
+        glBindVertexArray(0);
+
+        compositeShader_.reset(new Shader(shaderPath + "2D.vs", shaderPath + "oitComposite.fs"));
+        compositeShader_->use();
+        compositeShader_->setTexture("accumTexture", 0);
+        compositeShader_->setTexture("weightTexture", 1);
+    }
+
+    WeightedBlendedOIT::~WeightedBlendedOIT() {
+        glDeleteFramebuffers(1, &fbo_);
+        glDeleteTextures(1, &accumTexture_);
+        glDeleteTextures(1, &weightTexture_);
+        glDeleteVertexArrays(1, &quadVAO_);
+        glDeleteBuffers(1, &quadVBO_);
+    }
+
+    void WeightedBlendedOIT::resize(int width, int height) {
+        width = std::max(1, width);
+        height = std::max(1, height);
+        if (width == width_ && height == height_) return;
+        width_ = width;
+        height_ = height;
+        // Half floats: the weighted sums exceed 1 and need the range
+        glBindTexture(GL_TEXTURE_2D, accumTexture_);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width_, height_, 0, GL_RGBA, GL_HALF_FLOAT, NULL);
+        glBindTexture(GL_TEXTURE_2D, weightTexture_);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R16F, width_, height_, 0, GL_RED, GL_HALF_FLOAT, NULL);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    void WeightedBlendedOIT::begin(unsigned int depthTexture) {
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFbo_);
+        glGetIntegerv(GL_VIEWPORT, prevViewport_);
+        prevBlend_ = glIsEnabled(GL_BLEND);
+        prevDepthTest_ = glIsEnabled(GL_DEPTH_TEST);
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &prevDepthMask_);
+        glGetIntegerv(GL_BLEND_SRC_RGB, &prevBlendSrcRGB_);
+        glGetIntegerv(GL_BLEND_DST_RGB, &prevBlendDstRGB_);
+        glGetIntegerv(GL_BLEND_SRC_ALPHA, &prevBlendSrcAlpha_);
+        glGetIntegerv(GL_BLEND_DST_ALPHA, &prevBlendDstAlpha_);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, accumTexture_, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, weightTexture_, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+        const GLenum drawBuffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+        glDrawBuffers(2, drawBuffers);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::OIT::Framebuffer is not complete! The depth texture must be " << width_ << "x"
+                      << height_ << std::endl;
+        glViewport(0, 0, width_, height_);
+
+        const GLfloat accumClear[4] = {0.f, 0.f, 0.f, 1.f}; // revealage starts at 1
+        const GLfloat weightClear[4] = {0.f, 0.f, 0.f, 0.f};
+        glClearBufferfv(GL_COLOR, 0, accumClear);
+        glClearBufferfv(GL_COLOR, 1, weightClear);
+
+        glEnable(GL_DEPTH_TEST);
+        glDepthMask(GL_FALSE);
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+    }
+
+    void WeightedBlendedOIT::end() {
+        glBindFramebuffer(GL_FRAMEBUFFER, prevFbo_);
+        glViewport(prevViewport_[0], prevViewport_[1], prevViewport_[2], prevViewport_[3]);
+        glBlendFuncSeparate(prevBlendSrcRGB_, prevBlendDstRGB_, prevBlendSrcAlpha_, prevBlendDstAlpha_);
+        glDepthMask(prevDepthMask_);
+        if (!prevBlend_) glDisable(GL_BLEND);
+        if (!prevDepthTest_) glDisable(GL_DEPTH_TEST);
+    }
+
+    void WeightedBlendedOIT::composite() {
+        GLboolean bDepthTest = glIsEnabled(GL_DEPTH_TEST), bBlend = glIsEnabled(GL_BLEND);
+        GLint srcRGB, dstRGB, srcAlpha, dstAlpha;
+        glGetIntegerv(GL_BLEND_SRC_RGB, &srcRGB);
+        glGetIntegerv(GL_BLEND_DST_RGB, &dstRGB);
+        glGetIntegerv(GL_BLEND_SRC_ALPHA, &srcAlpha);
+        glGetIntegerv(GL_BLEND_DST_ALPHA, &dstAlpha);
+
+        glDisable(GL_DEPTH_TEST);
+        glEnable(GL_BLEND);
+        // result = average color * (1 - revealage) + opaque * revealage
+        glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA);
+        compositeShader_->use();
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, accumTexture_);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, weightTexture_);
+        glBindVertexArray(quadVAO_);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glBlendFuncSeparate(srcRGB, dstRGB, srcAlpha, dstAlpha);
+        if (!bBlend) glDisable(GL_BLEND);
+        if (bDepthTest) glEnable(GL_DEPTH_TEST);
+    }
+}
@@ -0,0 +1,51 @@
+//
+//  glOIT.hpp
+//  Weighted blended order-independent transparency (McGuire & Bavoil 2013).
+//
+//  Transparent surfaces are drawn in any order into two targets: the weighted premultiplied color sum with the
+//  revealage product in its alpha, and the weight sum. The composite pass resolves them over the opaque image.
+//  OpenGL 3.3 has no per-target blend functions, so both targets share glBlendFuncSeparate(ONE, ONE, ZERO,
+//  ONE_MINUS_SRC_ALPHA): color channels add up and alpha channels multiply.
+//
+//  Usage:
+//      draw opaque geometry into a target with a depth texture
+//      oit.begin(depthTexture);
+//      draw transparent geometry with a shader that writes the OIT outputs (Shaders/oit*.fs)
+//      oit.end();
+//      oit.composite(); // onto the opaque target, which must be bound
+//
+
+#ifndef glOIT_hpp
+#define glOIT_hpp
+
+#include "glShader.hpp"
+#include <memory>
+
+namespace glUtil {
+    class WeightedBlendedOIT {
+    public:
+        WeightedBlendedOIT(const std::string &shaderPath, int width, int height);
+        ~WeightedBlendedOIT();
+
+        void resize(int width, int height);
+
+        /// Depth of the opaque pass is tested against but not written. Restores the previous state in end().
+        void begin(unsigned int depthTexture);
+        void end();
+        /// Blend the resolved transparent layer over the currently bound framebuffer.
+        void composite();
+
+        int width() const { return width_; }
+        int height() const { return height_; }
+
+    private:
+        int width_, height_;
+        unsigned int fbo_, accumTexture_, weightTexture_, quadVAO_, quadVBO_;
+        std::unique_ptr<Shader> compositeShader_;
+        GLint prevFbo_, prevViewport_[4];
+        GLboolean prevBlend_, prevDepthTest_, prevDepthMask_;
+        GLint prevBlendSrcRGB_, prevBlendDstRGB_, prevBlendSrcAlpha_, prevBlendDstAlpha_;
+    };
+}
+
+#endif /* glOIT_hpp */
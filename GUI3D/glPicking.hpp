@@ -0,0 +1,206 @@
+/*
+ Usage:
+ Create a PickingBuffer with the framebuffer size. Every frame, call begin(), draw the
+ pickable objects with shader() and a unique "objectID" (0 is reserved for background),
+ then call end(x, y) with the cursor position in framebuffer pixels (origin bottom-left).
+ end() issues an asynchronous read of the pixels around the cursor; poll() returns the
+ result once the GPU has finished, without stalling the pipeline.
+*/
+#ifndef GLPICKING_H
+#define GLPICKING_H
+
+#include "glShader.hpp"
+
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+namespace glUtil {
+    struct PickResult {
+        unsigned int objectId = 0;    // 0: nothing under the cursor
+        unsigned int instanceId = 0;  // gl_InstanceID of the drawn instance
+        unsigned int primitiveId = 0; // triangle/line/point index inside the draw call
+        bool valid() const { return objectId != 0; }
+    };
+
+    class PickingBuffer {
+    public:
+        /// @param radius half size of the region read back around the cursor, in pixels.
+        PickingBuffer(int width, int height, int radius = 3)
+        : width_(0), height_(0), radius_(radius), fbo_(0), idTexture_(0), rbo_(0), current_(0) {
+            for (auto &f : fences_) f = nullptr;
+            for (auto &r : regionOrigin_) r = glm::ivec2(0);
+            const size_t regionBytes = (2 * radius_ + 1) * (2 * radius_ + 1) * 4 * sizeof(GLuint);
+            glGenBuffers(2, pbos_);
+            for (auto pbo : pbos_) {
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+                glBufferData(GL_PIXEL_PACK_BUFFER, regionBytes, nullptr, GL_STREAM_READ);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            shader_.compileShader(vertexShader, fragmentShader);
+            resize(width, height);
+        }
+
+        ~PickingBuffer() {
+            for (auto &f : fences_) if (f) glDeleteSync(f);
+            glDeleteBuffers(2, pbos_);
+            release();
+        }
+
+        void resize(int width, int height) {
+            if (width == width_ && height == height_) return;
+            release();
+            width_ = width;
+            height_ = height;
+
+            glGenFramebuffers(1, &fbo_);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+            // (objectId, instanceId, primitiveId, 1). RGB32UI is not required to be color-renderable.
+            glGenTextures(1, &idTexture_);
+            glBindTexture(GL_TEXTURE_2D, idTexture_);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, width_, height_, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, NULL);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, idTexture_, 0);
+
+            glGenRenderbuffers(1, &rbo_);
+            glBindRenderbuffer(GL_RENDERBUFFER, rbo_);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width_, height_);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rbo_);
+
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "ERROR::PICKINGBUFFER::Framebuffer is not complete!" << std::endl;
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+
+        /// Bind the id buffer and clear it. Draw pickable objects with shader() afterwards.
+        void begin() {
+            glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFbo_);
+            glGetIntegerv(GL_VIEWPORT, prevViewport_);
+            bBlend_ = glIsEnabled(GL_BLEND);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+            glViewport(0, 0, width_, height_);
+            glDisable(GL_BLEND);
+            const GLuint zero[4] = {0, 0, 0, 0};
+            glClearBufferuiv(GL_COLOR, 0, zero);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            shader_.use();
+        }
+
+        /// Queue an asynchronous read of the region around (x, y). Coordinates are framebuffer pixels, origin bottom-left.
+        void end(int x, int y) {
+            GLsync &fence = fences_[current_];
+            if (fence == nullptr) { // the previous request in this slot has been consumed
+                glm::ivec2 &origin = regionOrigin_[current_];
+                const int size = 2 * radius_ + 1;
+                origin.x = std::max(0, std::min(x - radius_, width_ - size));
+                origin.y = std::max(0, std::min(y - radius_, height_ - size));
+                regionCenter_[current_] = glm::ivec2(x, y);
+
+                glPixelStorei(GL_PACK_ALIGNMENT, 4);
+                glReadBuffer(GL_COLOR_ATTACHMENT0);
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[current_]);
+                glReadPixels(origin.x, origin.y, size, size, GL_RGBA_INTEGER, GL_UNSIGNED_INT, 0);
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+                fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                current_ = (current_ + 1) % 2;
+            }
+
+            glBindFramebuffer(GL_FRAMEBUFFER, prevFbo_);
+            glViewport(prevViewport_[0], prevViewport_[1], prevViewport_[2], prevViewport_[3]);
+            if (bBlend_) glEnable(GL_BLEND);
+        }
+
+        /// Non-blocking. Returns true and fills result if a queued read has completed.
+        bool poll(PickResult &result) {
+            bool updated = false;
+            for (int i = 0; i < 2; ++i) {
+                const int slot = (current_ + i) % 2; // oldest first
+                GLsync &fence = fences_[slot];
+                if (fence == nullptr) continue;
+                GLenum status = glClientWaitSync(fence, 0, 0);
+                if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+                glDeleteSync(fence);
+                fence = nullptr;
+
+                const int size = 2 * radius_ + 1;
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[slot]);
+                auto *data = (const GLuint *) glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+                                                               size * size * 4 * sizeof(GLuint), GL_MAP_READ_BIT);
+                if (data) {
+                    result = closestToCenter(data, size, regionCenter_[slot] - regionOrigin_[slot]);
+                    updated = true;
+                    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                }
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            }
+            return updated;
+        }
+
+        Shader *shader() { return &shader_; }
+        unsigned int getTexture() const { return idTexture_; }
+        int width() const { return width_; }
+        int height() const { return height_; }
+
+    private:
+        int width_, height_, radius_;
+        unsigned int fbo_, idTexture_, rbo_;
+        unsigned int pbos_[2];
+        GLsync fences_[2];
+        glm::ivec2 regionOrigin_[2], regionCenter_[2];
+        int current_;
+        GLint prevFbo_{}, prevViewport_[4]{};
+        GLboolean bBlend_{};
+        Shader shader_;
+
+        void release() {
+            if (fbo_) glDeleteFramebuffers(1, &fbo_);
+            if (idTexture_) glDeleteTextures(1, &idTexture_);
+            if (rbo_) glDeleteRenderbuffers(1, &rbo_);
+            fbo_ = idTexture_ = rbo_ = 0;
+        }
+
+        /// Thin points and lines rarely hit the exact cursor pixel. Take the nearest non-empty pixel instead.
+        static PickResult closestToCenter(const GLuint *data, int size, glm::ivec2 center) {
+            PickResult result;
+            int best = std::numeric_limits<int>::max();
+            for (int y = 0; y < size; ++y) {
+                for (int x = 0; x < size; ++x) {
+                    const GLuint *px = data + (y * size + x) * 4;
+                    if (px[0] == 0) continue;
+                    const int d = (x - center.x) * (x - center.x) + (y - center.y) * (y - center.y);
+                    if (d < best) {
+                        best = d;
+                        result.objectId = px[0];
+                        result.instanceId = px[1];
+                        result.primitiveId = px[2];
+                    }
+                }
+            }
+            return result;
+        }
+
+        const char *vertexShader = "#version 330 core\n"
+        "layout (location = 0) in vec3 aPos;\n"
+        "flat out uint InstanceID;\n"
+        "uniform mat4 model;\n"
+        "uniform mat4 view;\n"
+        "uniform mat4 projection;\n"
+        "void main(){\n"
+        "InstanceID = uint(gl_InstanceID);\n"
+        "gl_Position = projection * view * model * vec4(aPos, 1.0);}\n\0";
+        // gl_PrimitiveID is the triangle, line or point index within the draw call.
+        const char *fragmentShader = "#version 330 core\n"
+        "flat in uint InstanceID;\n"
+        "uniform uint objectID;\n"
+        "out uvec4 FragID;\n"
+        "void main(){\n"
+        "FragID = uvec4(objectID, InstanceID, uint(gl_PrimitiveID), 1u);\n"
+        "}\0";
+    };
+} // end of namespace glUtil
+
+#endif
@@ -0,0 +1,250 @@
+//
+//  glRGBDStream.cpp
+//
+
+#include "glRGBDStream.hpp"
+#include <cstring>
+
+namespace glUtil {
+    RGBDStream::RGBDStream(int width, int height, const std::string &shaderPath, float depthScale)
+            : width_(width), height_(height), depthScale_(depthScale),
+              intrinsics_(width, width, 0.5f * width, 0.5f * height),
+              pending_(nullptr), dropped_(0), pboIndex_(0) {
+        // Textures
+        glGenTextures(1, &colorTexture_);
+        glBindTexture(GL_TEXTURE_2D, colorTexture_);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width_, height_, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        // Raw depth. Integer textures must use nearest filtering.
+        glGenTextures(1, &depthTexture_);
+        glBindTexture(GL_TEXTURE_2D, depthTexture_);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R16UI, width_, height_, 0, GL_RED_INTEGER, GL_UNSIGNED_SHORT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glGenTextures(1, &depthColormapTexture_);
+        glBindTexture(GL_TEXTURE_2D, depthColormapTexture_);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width_, height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &colormapFBO_);
+        glBindFramebuffer(GL_FRAMEBUFFER, colormapFBO_);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, depthColormapTexture_, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+            std::cout << "ERROR::RGBDSTREAM::Framebuffer is not complete!" << std::endl;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        // Pixel buffers. Three per image so the CPU copy, the DMA transfer and the draw can overlap.
+        glGenBuffers(kNumPBO, colorPBO_);
+        glGenBuffers(kNumPBO, depthPBO_);
+        for (int i = 0; i < kNumPBO; ++i) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, colorPBO_[i]);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size_t(width_) * height_ * 3, NULL, GL_STREAM_DRAW);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, depthPBO_[i]);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size_t(width_) * height_ * sizeof(unsigned short), NULL, GL_STREAM_DRAW);
+            fences_[i] = nullptr;
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        // Screen quad for the colormap pass
+        float quadVertices[] = {
+                // positions   // texCoords
+                -1.0f, 1.0f, 0.0f, 1.0f,
+                -1.0f, -1.0f, 0.0f, 0.0f,
+                1.0f, -1.0f, 1.0f, 0.0f,
+
+                -1.0f, 1.0f, 0.0f, 1.0f,
+                1.0f, -1.0f, 1.0f, 0.0f,
+                1.0f, 1.0f, 1.0f, 1.0f
+        };
+        glGenVertexArrays(1, &quadVAO_);
+        glGenBuffers(1, &quadVBO_);
+        glBindVertexArray(quadVAO_);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO_);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), &quadVertices, GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) 0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void *) (2 * sizeof(float)));
+        glBindVertexArray(0);
+        // The point cloud has no attributes, but core profile still needs a VAO bound.
+        glGenVertexArrays(1, &cloudVAO_);
+
+        colormapShader_.reset(new Shader(shaderPath + "2D.vs", shaderPath + "depthColormap.fs"));
+        colormapShader_->use();
+        colormapShader_->setTexture("depthTexture", 0);
+        cloudShader_.reset(new Shader(shaderPath + "rgbdCloud.vs", shaderPath + "rgbdCloud.fs"));
+        cloudShader_->use();
+        cloudShader_->setTexture("depthTexture", 0);
+        cloudShader_->setTexture("colorTexture", 1);
+        cloudOITShader_.reset(new Shader(shaderPath + "rgbdCloud.vs", shaderPath + "rgbdCloudOIT.fs"));
+        cloudOITShader_->use();
+        cloudOITShader_->setTexture("depthTexture", 0);
+        cloudOITShader_->setTexture("colorTexture", 1);
+        cloudPickShader_.reset(new Shader(shaderPath + "rgbdCloud.vs", shaderPath + "rgbdCloudPick.fs"));
+        cloudPickShader_->use();
+        cloudPickShader_->setTexture("depthTexture", 0);
+        cloudPickShader_->setTexture("colorTexture", 1);
+    }
+
+    RGBDStream::~RGBDStream() {
+        PendingFrame *pending = pending_.exchange(nullptr);
+        if (pending) {
+            if (pending->frame.release) pending->frame.release();
+            delete pending;
+        }
+        for (auto &fence : fences_) if (fence) glDeleteSync(fence);
+        glDeleteBuffers(kNumPBO, colorPBO_);
+        glDeleteBuffers(kNumPBO, depthPBO_);
+        glDeleteTextures(1, &colorTexture_);
+        glDeleteTextures(1, &depthTexture_);
+        glDeleteTextures(1, &depthColormapTexture_);
+        glDeleteFramebuffers(1, &colormapFBO_);
+        glDeleteVertexArrays(1, &quadVAO_);
+        glDeleteBuffers(1, &quadVBO_);
+        glDeleteVertexArrays(1, &cloudVAO_);
+    }
+
+    void RGBDStream::submit(RGBDFrame frame) {
+        auto *pending = new PendingFrame{std::move(frame), std::chrono::steady_clock::now()};
+        PendingFrame *old = pending_.exchange(pending, std::memory_order_acq_rel);
+        if (old) { // the GL thread did not pick it up in time
+            if (old->frame.release) old->frame.release();
+            delete old;
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void RGBDStream::copyToPBO(unsigned int pbo, const void *data, size_t bytes, bool mayBeInUse) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        // If the GPU may still read the buffer, orphan it instead of waiting.
+        GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+        if (!mayBeInUse) access |= GL_MAP_UNSYNCHRONIZED_BIT;
+        void *ptr = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, access);
+        if (ptr) {
+            std::memcpy(ptr, data, bytes);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        }
+    }
+
+    bool RGBDStream::upload() {
+        stats_.dropped = dropped_.load(std::memory_order_relaxed);
+        PendingFrame *pending = pending_.exchange(nullptr, std::memory_order_acq_rel);
+        if (!pending) return false;
+        const RGBDFrame &frame = pending->frame;
+
+        const int index = pboIndex_;
+        pboIndex_ = (pboIndex_ + 1) % kNumPBO;
+        bool mayBeInUse = false;
+        if (fences_[index]) {
+            GLenum status = glClientWaitSync(fences_[index], 0, 0);
+            mayBeInUse = status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED;
+            glDeleteSync(fences_[index]);
+            fences_[index] = nullptr;
+        }
+
+        // The only CPU copy: producer memory straight into the mapped pixel buffers.
+        if (frame.color)
+            copyToPBO(colorPBO_[index], frame.color, size_t(width_) * height_ * 3, mayBeInUse);
+        if (frame.depth)
+            copyToPBO(depthPBO_[index], frame.depth, size_t(width_) * height_ * sizeof(unsigned short), mayBeInUse);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (frame.release) frame.release();
+
+        const double latency = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - pending->submitted).count();
+        stats_.latencyMs = stats_.uploaded == 0 ? float(latency) : 0.9f * stats_.latencyMs + 0.1f * float(latency);
+        stats_.lastTimestamp = frame.timestamp;
+        stats_.uploaded++;
+
+        // Texture transfers are sourced from the pixel buffers and do not block the CPU.
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        if (frame.color) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, colorPBO_[index]);
+            glBindTexture(GL_TEXTURE_2D, colorTexture_);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGB, GL_UNSIGNED_BYTE, 0);
+        }
+        if (frame.depth) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, depthPBO_[index]);
+            glBindTexture(GL_TEXTURE_2D, depthTexture_);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RED_INTEGER, GL_UNSIGNED_SHORT, 0);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        fences_[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        delete pending;
+        return true;
+    }
+
+    void RGBDStream::colorizeDepth(float minDepth, float maxDepth) {
+        GLint prevFbo, viewport[4];
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFbo);
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        GLboolean bDepthTest = glIsEnabled(GL_DEPTH_TEST);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, colormapFBO_);
+        glViewport(0, 0, width_, height_);
+        glDisable(GL_DEPTH_TEST);
+        colormapShader_->use();
+        colormapShader_->set("depthScale", depthScale_);
+        colormapShader_->set("minDepth", minDepth);
+        colormapShader_->set("maxDepth", maxDepth);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, depthTexture_);
+        glBindVertexArray(quadVAO_);
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, prevFbo);
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        if (bDepthTest) glEnable(GL_DEPTH_TEST);
+    }
+
+    void RGBDStream::drawPointCloud(const glm::mat4 &projection, const glm::mat4 &view, const glm::mat4 &model,
+                                    float pointSize, float opacity) {
+        if (stats_.uploaded == 0) return;
+        Shader *shader = opacity < 1.f ? cloudOITShader_.get() : cloudShader_.get();
+        shader->use();
+        if (opacity < 1.f) shader->set("opacity", opacity);
+        drawCloud(shader, projection, view, model, pointSize);
+    }
+
+    void RGBDStream::drawPointCloudIds(const glm::mat4 &projection, const glm::mat4 &view, const glm::mat4 &model,
+                                       float pointSize, unsigned int objectId) {
+        if (stats_.uploaded == 0) return;
+        cloudPickShader_->use();
+        cloudPickShader_->set("objectID", objectId);
+        drawCloud(cloudPickShader_.get(), projection, view, model, pointSize);
+    }
+
+    void RGBDStream::drawCloud(Shader *shader, const glm::mat4 &projection, const glm::mat4 &view,
+                               const glm::mat4 &model, float pointSize) {
+        shader->set("projection", projection);
+        shader->set("view", view);
+        shader->set("model", model);
+        shader->set("intrinsics", intrinsics_);
+        shader->set("depthScale", depthScale_);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, depthTexture_);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, colorTexture_);
+        glPointSize(pointSize);
+        glBindVertexArray(cloudVAO_);
+        glDrawArrays(GL_POINTS, 0, width_ * height_);
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+}
@@ -0,0 +1,95 @@
+//
+//  glRGBDStream.hpp
+//  Stream RGB-D frames from a producer thread into GL textures and a GPU point cloud.
+//
+//  Producer: fill an RGBDFrame with pointers to its own buffers and call submit() from any thread.
+//  GL thread: call upload() once per frame, then draw with the textures or drawPointCloud().
+//
+
+#ifndef glRGBDStream_hpp
+#define glRGBDStream_hpp
+
+#include "glShader.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+namespace glUtil {
+    struct RGBDFrame {
+        const unsigned char *color = nullptr;  // width * height * 3, RGB8, row-major, top row first. Optional.
+        const unsigned short *depth = nullptr; // width * height, raw 16-bit depth. Optional.
+        double timestamp = 0;                   // producer time stamp, passed through
+        /// Called once the buffers are not needed anymore. From the GL thread after the copy into the
+        /// upload buffer, or from the submitting thread if the frame is dropped for a newer one.
+        std::function<void()> release;
+    };
+
+    class RGBDStream {
+    public:
+        /// @param depthScale converts raw depth to meters, e.g. 0.001 for millimeters.
+        RGBDStream(int width, int height, const std::string &shaderPath, float depthScale = 0.001f);
+        ~RGBDStream();
+
+        /// Thread-safe and lock-free. Only the newest frame is kept; a pending older frame is dropped.
+        void submit(RGBDFrame frame);
+
+        /// GL thread. Copies the pending frame from producer memory into the next pixel buffer and starts the
+        /// texture transfer. Returns false if no new frame was pending.
+        bool upload();
+
+        /// GL thread. Render the colorized depth into getDepthColormapTexture().
+        void colorizeDepth(float minDepth, float maxDepth);
+
+        /// GL thread. One point per valid depth pixel, unprojected and colored on the GPU. With opacity < 1 the
+        /// points write the weighted blended OIT outputs and must be drawn between WeightedBlendedOIT::begin/end.
+        void drawPointCloud(const glm::mat4 &projection, const glm::mat4 &view, const glm::mat4 &model,
+                            float pointSize = 1.f, float opacity = 1.f);
+        /// GL thread. The point cloud into a glUtil::PickingBuffer: objectId, 0, and the pixel index y * width + x.
+        void drawPointCloudIds(const glm::mat4 &projection, const glm::mat4 &view, const glm::mat4 &model,
+                               float pointSize, unsigned int objectId);
+
+        void setIntrinsics(float fx, float fy, float cx, float cy) { intrinsics_ = glm::vec4(fx, fy, cx, cy); }
+
+        unsigned int getColorTexture() const { return colorTexture_; }
+        unsigned int getDepthTexture() const { return depthTexture_; }
+        unsigned int getDepthColormapTexture() const { return depthColormapTexture_; }
+        int width() const { return width_; }
+        int height() const { return height_; }
+
+        struct Statistics {
+            unsigned long uploaded = 0, dropped = 0;
+            double lastTimestamp = 0;
+            float latencyMs = 0; // submit to upload, exponentially smoothed
+        };
+        const Statistics &statistics() const { return stats_; }
+
+    private:
+        static const int kNumPBO = 3;
+        struct PendingFrame {
+            RGBDFrame frame;
+            std::chrono::steady_clock::time_point submitted;
+        };
+
+        int width_, height_;
+        float depthScale_;
+        glm::vec4 intrinsics_;
+        std::atomic<PendingFrame *> pending_;
+        std::atomic<unsigned long> dropped_;
+        Statistics stats_;
+
+        unsigned int colorTexture_, depthTexture_, depthColormapTexture_;
+        unsigned int colorPBO_[kNumPBO], depthPBO_[kNumPBO];
+        GLsync fences_[kNumPBO];
+        int pboIndex_;
+        unsigned int colormapFBO_, quadVAO_, quadVBO_, cloudVAO_;
+        std::unique_ptr<Shader> colormapShader_, cloudShader_, cloudOITShader_, cloudPickShader_;
+
+        void drawCloud(Shader *shader, const glm::mat4 &projection, const glm::mat4 &view, const glm::mat4 &model,
+                       float pointSize);
+        void copyToPBO(unsigned int pbo, const void *data, size_t bytes, bool mayBeInUse);
+    };
+}
+
+#endif /* glRGBDStream_hpp */
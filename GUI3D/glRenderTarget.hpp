@@ -0,0 +1,92 @@
+/*
+ Usage:
+ An offscreen color + depth target. Call bind() before drawing into it and unbind() afterwards; the previous
+ framebuffer and viewport are restored. Both attachments are textures so later passes can sample them.
+*/
+#ifndef GLRENDERTARGET_H
+#define GLRENDERTARGET_H
+
+#include "glShader.hpp"
+#include <algorithm>
+
+namespace glUtil {
+    class RenderTarget {
+    public:
+        RenderTarget(int width, int height, GLenum colorFormat = GL_RGBA8)
+        : width_(0), height_(0), colorFormat_(colorFormat) {
+            glGenFramebuffers(1, &fbo_);
+            glGenTextures(1, &colorTexture_);
+            glGenTextures(1, &depthTexture_);
+
+            glBindTexture(GL_TEXTURE_2D, colorTexture_);
+            // Linear so a lower internal resolution is upscaled smoothly
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_2D, depthTexture_);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            resize(width, height);
+        }
+
+        ~RenderTarget() {
+            glDeleteFramebuffers(1, &fbo_);
+            glDeleteTextures(1, &colorTexture_);
+            glDeleteTextures(1, &depthTexture_);
+        }
+
+        /// Reallocate the attachment storage. The texture ids stay the same, so UI references remain valid.
+        void resize(int width, int height) {
+            width = std::max(1, width);
+            height = std::max(1, height);
+            if (width == width_ && height == height_) return;
+            width_ = width;
+            height_ = height;
+
+            glBindTexture(GL_TEXTURE_2D, colorTexture_);
+            glTexImage2D(GL_TEXTURE_2D, 0, colorFormat_, width_, height_, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            glBindTexture(GL_TEXTURE_2D, depthTexture_);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, width_, height_, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            GLint prevFbo;
+            glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFbo);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTexture_, 0);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture_, 0);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+                std::cout << "ERROR::RENDERTARGET::Framebuffer is not complete!" << std::endl;
+            glBindFramebuffer(GL_FRAMEBUFFER, prevFbo);
+        }
+
+        void bind() {
+            glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFbo_);
+            glGetIntegerv(GL_VIEWPORT, prevViewport_);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+            glViewport(0, 0, width_, height_);
+        }
+
+        void unbind() {
+            glBindFramebuffer(GL_FRAMEBUFFER, prevFbo_);
+            glViewport(prevViewport_[0], prevViewport_[1], prevViewport_[2], prevViewport_[3]);
+        }
+
+        unsigned int getFBO() const { return fbo_; }
+        unsigned int getColorTexture() const { return colorTexture_; }
+        unsigned int getDepthTexture() const { return depthTexture_; }
+        int width() const { return width_; }
+        int height() const { return height_; }
+
+    private:
+        int width_, height_;
+        GLenum colorFormat_;
+        unsigned int fbo_{}, colorTexture_{}, depthTexture_{};
+        GLint prevFbo_{}, prevViewport_[4]{};
+    };
+} // end of namespace glUtil
+
+#endif
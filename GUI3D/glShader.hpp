@@ -265,6 +265,13 @@ namespace glUtil{
             hasOwnership = false;
         }
         virtual void addTexture(std::string name, unsigned int textureId, int type = GL_TEXTURE_2D, unsigned int order = 0){};
+        /// Draw once with another shader (e.g. picking) without touching the ownership of the current one.
+        virtual void DrawWith(Shader *other){
+            Shader *own = shader;
+            shader = other;
+            Draw();
+            shader = own;
+        }
     protected:
         Shader *shader;
         bool hasOwnership;
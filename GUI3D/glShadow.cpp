@@ -0,0 +1,359 @@
+//
+//  glShadow.cpp
+//
+
+#include "glShadow.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace glUtil {
+    namespace {
+        /// Conservative: false only if all corners are outside the same clip plane.
+        bool intersects(const glm::mat4 &lightSpace, const glm::vec3 &bmin, const glm::vec3 &bmax) {
+            int outside[6] = {0, 0, 0, 0, 0, 0};
+            for (int i = 0; i < 8; ++i) {
+                glm::vec4 p = lightSpace * glm::vec4(i & 1 ? bmax.x : bmin.x, i & 2 ? bmax.y : bmin.y,
+                                                     i & 4 ? bmax.z : bmin.z, 1.f);
+                outside[0] += p.x < -p.w;
+                outside[1] += p.x > p.w;
+                outside[2] += p.y < -p.w;
+                outside[3] += p.y > p.w;
+                outside[4] += p.z < -p.w;
+                outside[5] += p.z > p.w;
+            }
+            for (int count : outside) if (count == 8) return false;
+            return true;
+        }
+
+        glm::mat4 cubeFaceMatrix(const glm::vec3 &position, float farPlane, int face) {
+            static const glm::vec3 directions[6] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+            static const glm::vec3 ups[6] = {{0, -1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {0, -1, 0}, {0, -1, 0}};
+            glm::mat4 projection = glm::perspective(glm::radians(90.f), 1.f, 0.05f, farPlane);
+            return projection * glm::lookAt(position, position + directions[face], ups[face]);
+        }
+
+        void setDepthParameters(GLenum target) {
+            glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        }
+    }
+
+    ShadowMaps::ShadowMaps(const std::string &shaderPath, int cascadeSize, int numCascades, int cubeSize)
+            : cascadeSize_(cascadeSize), numCascades_(std::min(std::max(numCascades, 1), int(kMaxCascades))),
+              cubeSize_(cubeSize), shadowDistance_(50.f), depthRange_(100.f),
+              lightDirection_(glm::normalize(glm::vec3(-0.3f, -1.f, -0.5f))), lightColor_(1.f),
+              cascadeRegions_(numCascades_) {
+        std::fill(cascadeSplits_, cascadeSplits_ + kMaxCascades, 0.f);
+        unsigned int *arrays[2] = {&staticCascades_, &finalCascades_};
+        for (unsigned int *texture : arrays) {
+            glGenTextures(1, texture);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, *texture);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, cascadeSize_, cascadeSize_, numCascades_, 0,
+                         GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+            setDepthParameters(GL_TEXTURE_2D_ARRAY);
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        glGenFramebuffers(1, &drawFBO_);
+        glGenFramebuffers(1, &readFBO_);
+        depthShader_.reset(new Shader(shaderPath + "simpleShadow.vs", shaderPath + "simpleShadow.fs"));
+        timer_.reset(new GpuTimer());
+    }
+
+    ShadowMaps::~ShadowMaps() {
+        glDeleteTextures(1, &staticCascades_);
+        glDeleteTextures(1, &finalCascades_);
+        for (auto &light : pointLights_) {
+            glDeleteTextures(1, &light.staticCube);
+            glDeleteTextures(1, &light.finalCube);
+        }
+        glDeleteFramebuffers(1, &drawFBO_);
+        glDeleteFramebuffers(1, &readFBO_);
+    }
+
+    int ShadowMaps::addCaster(Model_base *model, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax,
+                              const glm::mat4 &transform, bool bStatic) {
+        Caster caster{model, boundsMin, boundsMax, transform, glm::vec3(0.f), glm::vec3(0.f), bStatic};
+        updateWorldBounds(caster);
+        touch(caster.worldMin, caster.worldMax, bStatic);
+        casters_.push_back(caster);
+        return static_cast<int>(casters_.size()) - 1;
+    }
+
+    void ShadowMaps::setCasterTransform(int id, const glm::mat4 &transform) {
+        Caster &caster = casters_.at(id);
+        if (caster.transform == transform) return;
+        touch(caster.worldMin, caster.worldMax, caster.bStatic); // where it was
+        caster.transform = transform;
+        updateWorldBounds(caster);
+        touch(caster.worldMin, caster.worldMax, caster.bStatic); // where it is
+    }
+
+    void ShadowMaps::removeCaster(int id) {
+        Caster &caster = casters_.at(id);
+        if (!caster.model) return;
+        touch(caster.worldMin, caster.worldMax, caster.bStatic);
+        caster.model = nullptr; // keep the ids of the others stable
+    }
+
+    void ShadowMaps::replaceModel(Model_base *previous, Model_base *model, const glm::vec3 &boundsMin,
+                                  const glm::vec3 &boundsMax) {
+        if (!previous) return;
+        for (auto &caster : casters_) {
+            if (caster.model != previous) continue;
+            touch(caster.worldMin, caster.worldMax, caster.bStatic);
+            caster.model = model;
+            caster.localMin = boundsMin;
+            caster.localMax = boundsMax;
+            updateWorldBounds(caster);
+            touch(caster.worldMin, caster.worldMax, caster.bStatic);
+        }
+    }
+
+    void ShadowMaps::setDirectionalLight(const glm::vec3 &direction, const glm::vec3 &color) {
+        lightColor_ = color;
+        glm::vec3 normalized = glm::normalize(direction);
+        if (normalized == lightDirection_) return;
+        lightDirection_ = normalized;
+        for (auto &region : cascadeRegions_) region.bStaticValid = region.bFinalValid = false;
+    }
+
+    int ShadowMaps::addPointLight(const glm::vec3 &position, float farPlane, const glm::vec3 &color) {
+        if (pointLights_.size() >= kMaxPointLights) {
+            std::cout << "ERROR::SHADOW::At most " << kMaxPointLights << " point lights are supported" << std::endl;
+            return -1;
+        }
+        PointLight light{position, color, farPlane, createCube(), createCube()};
+        pointLights_.push_back(light);
+        for (int face = 0; face < 6; ++face) {
+            Region region;
+            region.lightSpace = cubeFaceMatrix(position, farPlane, face);
+            cubeRegions_.push_back(region);
+        }
+        return static_cast<int>(pointLights_.size()) - 1;
+    }
+
+    void ShadowMaps::setPointLight(int index, const glm::vec3 &position, float farPlane) {
+        PointLight &light = pointLights_.at(index);
+        if (light.position == position && light.farPlane == farPlane) return;
+        light.position = position;
+        light.farPlane = farPlane;
+        for (int face = 0; face < 6; ++face) {
+            Region &region = cubeRegions_[index * 6 + face];
+            region.lightSpace = cubeFaceMatrix(position, farPlane, face);
+            region.bStaticValid = region.bFinalValid = false;
+        }
+    }
+
+    void ShadowMaps::invalidate() {
+        for (auto &region : cascadeRegions_) region.bStaticValid = region.bFinalValid = false;
+        for (auto &region : cubeRegions_) region.bStaticValid = region.bFinalValid = false;
+    }
+
+    void ShadowMaps::updateWorldBounds(Caster &caster) {
+        caster.worldMin = glm::vec3(std::numeric_limits<float>::max());
+        caster.worldMax = glm::vec3(-std::numeric_limits<float>::max());
+        for (int i = 0; i < 8; ++i) {
+            glm::vec3 corner(i & 1 ? caster.localMax.x : caster.localMin.x, i & 2 ? caster.localMax.y : caster.localMin.y,
+                             i & 4 ? caster.localMax.z : caster.localMin.z);
+            glm::vec3 world = glm::vec3(caster.transform * glm::vec4(corner, 1.f));
+            caster.worldMin = glm::min(caster.worldMin, world);
+            caster.worldMax = glm::max(caster.worldMax, world);
+        }
+    }
+
+    void ShadowMaps::touch(const glm::vec3 &worldMin, const glm::vec3 &worldMax, bool bStatic) {
+        auto mark = [&](Region &region) {
+            if (!intersects(region.lightSpace, worldMin, worldMax)) return;
+            if (bStatic) region.bStaticValid = false;
+            region.bFinalValid = false;
+        };
+        for (auto &region : cascadeRegions_) mark(region);
+        for (auto &region : cubeRegions_) mark(region);
+    }
+
+    unsigned int ShadowMaps::createCube() {
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+        for (int face = 0; face < 6; ++face)
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_DEPTH_COMPONENT24, cubeSize_, cubeSize_, 0,
+                         GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        setDepthParameters(GL_TEXTURE_CUBE_MAP);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+        return texture;
+    }
+
+    glm::mat4 ShadowMaps::cascadeMatrix(const glm::mat4 &invViewProj, float ndcNear, float ndcFar) const {
+        // Bounding sphere of the frustum slice. Its size does not change when the camera rotates.
+        glm::vec3 corners[8];
+        glm::vec3 center(0.f);
+        for (int i = 0; i < 8; ++i) {
+            glm::vec4 p = invViewProj * glm::vec4(i & 1 ? 1.f : -1.f, i & 2 ? 1.f : -1.f, i & 4 ? ndcFar : ndcNear, 1.f);
+            corners[i] = glm::vec3(p) / p.w;
+            center += corners[i] / 8.f;
+        }
+        float radius = 0;
+        for (const auto &corner : corners) radius = std::max(radius, glm::length(corner - center));
+        radius = std::ceil(radius * 16.f) / 16.f;
+
+        // Snap to whole texels (and coarse depth steps) so the matrix, and with it the cache, only changes
+        // after the camera moved by at least a texel.
+        glm::vec3 up = std::fabs(lightDirection_.y) > 0.99f ? glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+        glm::mat4 lightView = glm::lookAt(glm::vec3(0.f), lightDirection_, up);
+        glm::vec3 c = glm::vec3(lightView * glm::vec4(center, 1.f));
+        const float texel = 2.f * radius / cascadeSize_;
+        c.x = std::floor(c.x / texel) * texel;
+        c.y = std::floor(c.y / texel) * texel;
+        const float depthStep = radius * 0.25f;
+        c.z = std::floor(c.z / depthStep) * depthStep;
+        glm::mat4 projection = glm::ortho(c.x - radius, c.x + radius, c.y - radius, c.y + radius,
+                                          -c.z - radius - depthRange_, -c.z + radius + depthStep);
+        return projection * lightView;
+    }
+
+    void ShadowMaps::attach(unsigned int fbo, unsigned int texture, int layer, bool bCube) {
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        if (bCube)
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + layer, texture, 0);
+        else
+            glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, layer);
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+
+    void ShadowMaps::renderRegion(Region &region, unsigned int texture, int layer, bool bCube, bool bStatic,
+                                  const PointLight *light) {
+        attach(drawFBO_, texture, layer, bCube);
+        const int size = bCube ? cubeSize_ : cascadeSize_;
+        glViewport(0, 0, size, size);
+        if (bStatic) glClear(GL_DEPTH_BUFFER_BIT);
+
+        depthShader_->use();
+        depthShader_->set("lightSpaceMatrix", region.lightSpace);
+        depthShader_->set("linearDepth", light != nullptr);
+        if (light) {
+            depthShader_->set("lightPos", light->position);
+            depthShader_->set("farPlane", light->farPlane);
+        }
+        for (const auto &caster : casters_) {
+            if (!caster.model || caster.bStatic != bStatic) continue;
+            if (!intersects(region.lightSpace, caster.worldMin, caster.worldMax)) continue;
+            depthShader_->set("model", caster.transform);
+            caster.model->DrawWith(depthShader_.get());
+        }
+    }
+
+    void ShadowMaps::copyLayer(unsigned int src, unsigned int dst, int layer, bool bCube, int size) {
+        attach(readFBO_, src, layer, bCube);
+        attach(drawFBO_, dst, layer, bCube);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, readFBO_);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, drawFBO_);
+        glBlitFramebuffer(0, 0, size, size, 0, 0, size, size, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+    }
+
+    void ShadowMaps::update(const glm::mat4 &view, const glm::mat4 &projection, float nearPlane, float farPlane) {
+        float gpuMs;
+        const bool bMeasured = timer_->poll(gpuMs);
+        if (bMeasured) stats_.gpuMs = gpuMs;
+        stats_.staticRendered = stats_.dynamicRendered = 0;
+
+        // Practical split scheme, halfway between uniform and logarithmic
+        const float far = std::min(farPlane, shadowDistance_);
+        const glm::mat4 invViewProj = glm::inverse(projection * view);
+        auto toNDC = [&](float distance) {
+            glm::vec4 clip = projection * glm::vec4(0.f, 0.f, -distance, 1.f);
+            return clip.z / clip.w;
+        };
+        float begin = nearPlane;
+        for (int i = 0; i < numCascades_; ++i) {
+            const float f = float(i + 1) / numCascades_;
+            const float end = 0.5f * (nearPlane * std::pow(far / nearPlane, f)) + 0.5f * (nearPlane + (far - nearPlane) * f);
+            cascadeSplits_[i] = end;
+            glm::mat4 lightSpace = cascadeMatrix(invViewProj, toNDC(begin), toNDC(end));
+            Region &region = cascadeRegions_[i];
+            if (lightSpace != region.lightSpace) {
+                region.lightSpace = lightSpace;
+                region.bStaticValid = region.bFinalValid = false;
+            }
+            begin = end;
+        }
+
+        bool bNothingToDo = true;
+        for (const auto &region : cascadeRegions_) bNothingToDo &= region.bFinalValid;
+        for (const auto &region : cubeRegions_) bNothingToDo &= region.bFinalValid;
+        if (bNothingToDo) {
+            // everything came from the cache: no GPU work, unless a result of an earlier redraw just arrived
+            if (!bMeasured) stats_.gpuMs = 0;
+            return;
+        }
+
+        GLint prevFbo, prevViewport[4];
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &prevFbo);
+        glGetIntegerv(GL_VIEWPORT, prevViewport);
+        GLboolean bBlend = glIsEnabled(GL_BLEND);
+        glDisable(GL_BLEND);
+        glEnable(GL_DEPTH_TEST);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        timer_->begin();
+
+        auto refresh = [&](Region &region, unsigned int staticTexture, unsigned int finalTexture, int layer, bool bCube,
+                           int size, const PointLight *light) {
+            if (region.bFinalValid) return;
+            if (!region.bStaticValid) {
+                renderRegion(region, staticTexture, layer, bCube, true, light);
+                region.bStaticValid = true;
+                stats_.staticRendered++;
+            }
+            copyLayer(staticTexture, finalTexture, layer, bCube, size);
+            renderRegion(region, finalTexture, layer, bCube, false, light);
+            region.bFinalValid = true;
+            stats_.dynamicRendered++;
+        };
+        for (int i = 0; i < numCascades_; ++i)
+            refresh(cascadeRegions_[i], staticCascades_, finalCascades_, i, false, cascadeSize_, nullptr);
+        for (size_t l = 0; l < pointLights_.size(); ++l)
+            for (int face = 0; face < 6; ++face)
+                refresh(cubeRegions_[l * 6 + face], pointLights_[l].staticCube, pointLights_[l].finalCube, face, true,
+                        cubeSize_, &pointLights_[l]);
+
+        timer_->end();
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        if (bBlend) glEnable(GL_BLEND);
+        glBindFramebuffer(GL_FRAMEBUFFER, prevFbo);
+        glViewport(prevViewport[0], prevViewport[1], prevViewport[2], prevViewport[3]);
+    }
+
+    void ShadowMaps::bind(Shader *shader, int firstUnit) const {
+        shader->set("lightDirection", lightDirection_);
+        shader->set("lightColor", lightColor_);
+        shader->set("numCascades", numCascades_);
+        for (int i = 0; i < numCascades_; ++i) {
+            shader->set("cascadeMatrices[" + std::to_string(i) + "]", cascadeRegions_[i].lightSpace);
+            shader->set("cascadeSplits[" + std::to_string(i) + "]", cascadeSplits_[i]);
+        }
+        glActiveTexture(GL_TEXTURE0 + firstUnit);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, finalCascades_);
+        shader->setTexture("cascadeShadowMap", firstUnit);
+
+        shader->set("numPointLights", static_cast<int>(pointLights_.size()));
+        for (int i = 0; i < kMaxPointLights; ++i) {
+            // Every cube sampler gets its own unit even if unused; samplers of different types must not share one.
+            const int unit = firstUnit + 1 + i;
+            const std::string index = "[" + std::to_string(i) + "]";
+            shader->setTexture("pointShadowMaps" + index, unit);
+            if (i >= static_cast<int>(pointLights_.size())) continue;
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, pointLights_[i].finalCube);
+            shader->set("pointLightPositions" + index, pointLights_[i].position);
+            shader->set("pointLightColors" + index, pointLights_[i].color);
+            shader->set("pointFarPlanes" + index, pointLights_[i].farPlane);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+}
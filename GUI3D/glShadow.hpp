@@ -0,0 +1,116 @@
+//
+//  glShadow.hpp
+//  Cached shadow maps: cascaded maps for one directional light and cubemaps for point lights.
+//
+//  Every cascade and every cube face is a region with its own light matrix. A region keeps two depth layers:
+//  the static casters, rendered only when the region's matrix changes or a static caster in it moves, and the
+//  final layer, a copy of the static one with the dynamic casters drawn on top, refreshed only when a dynamic
+//  caster in the region moved. A static scene therefore costs nothing after the first frame.
+//
+//  Usage:
+//      shadows.setDirectionalLight(direction);
+//      int id = shadows.addCaster(model, boundsMin, boundsMax, transform, bStatic);
+//      ...
+//      shadows.update(view, projection, near, far); // before drawing the scene
+//      shader->use(); shadows.bind(shader, 4);      // with Shaders/shadowLighting.vs/.fs
+//
+
+#ifndef glShadow_hpp
+#define glShadow_hpp
+
+#include "glShader.hpp"
+#include "glGpuTimer.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace glUtil {
+    class ShadowMaps {
+    public:
+        static const int kMaxCascades = 4;
+        static const int kMaxPointLights = 4;
+
+        ShadowMaps(const std::string &shaderPath, int cascadeSize = 2048, int numCascades = 3, int cubeSize = 512);
+        ~ShadowMaps();
+
+        /// @param boundsMin/boundsMax local axis-aligned bounds of the model, used to find the regions it touches.
+        /// @param bStatic static casters are cached; dynamic ones are redrawn over the cache when they move.
+        int addCaster(Model_base *model, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax,
+                      const glm::mat4 &transform = glm::mat4(1.f), bool bStatic = true);
+        void setCasterTransform(int id, const glm::mat4 &transform);
+        void removeCaster(int id);
+        /// Point every caster drawing previous at model instead, with new local bounds, e.g. before previous is
+        /// deleted because its geometry was replaced. The regions of the old and the new bounds are redrawn.
+        void replaceModel(Model_base *previous, Model_base *model, const glm::vec3 &boundsMin,
+                          const glm::vec3 &boundsMax);
+
+        void setDirectionalLight(const glm::vec3 &direction, const glm::vec3 &color = glm::vec3(1.f));
+        /// Returns the light index, or -1 if all kMaxPointLights are in use.
+        int addPointLight(const glm::vec3 &position, float farPlane, const glm::vec3 &color = glm::vec3(1.f));
+        void setPointLight(int index, const glm::vec3 &position, float farPlane);
+
+        /// Cascades cover the view from near up to min(far, shadow distance). depthRange is how far behind a
+        /// cascade (towards the light) casters are still captured.
+        void setShadowDistance(float distance, float depthRange = 100.f) {
+            shadowDistance_ = distance;
+            depthRange_ = depthRange;
+        }
+        /// Drop every cached map, e.g. after the geometry of a caster was edited in place.
+        void invalidate();
+
+        /// Re-render the regions that changed. Restores the framebuffer and viewport.
+        void update(const glm::mat4 &view, const glm::mat4 &projection, float nearPlane, float farPlane);
+
+        /// Set the shadowLighting uniforms. Uses texture units firstUnit .. firstUnit + kMaxPointLights.
+        void bind(Shader *shader, int firstUnit) const;
+
+        struct Statistics {
+            int staticRendered = 0;  // regions whose static layer was rendered in the last update
+            int dynamicRendered = 0; // regions whose final layer was recomposed in the last update
+            float gpuMs = 0;         // GPU time of an earlier update, 0 while every map comes from the cache
+        };
+        const Statistics &statistics() const { return stats_; }
+
+    private:
+        struct Caster {
+            Model_base *model;
+            glm::vec3 localMin, localMax;
+            glm::mat4 transform;
+            glm::vec3 worldMin, worldMax;
+            bool bStatic;
+        };
+        struct Region {
+            glm::mat4 lightSpace;
+            bool bStaticValid = false, bFinalValid = false;
+        };
+        struct PointLight {
+            glm::vec3 position, color;
+            float farPlane;
+            unsigned int staticCube, finalCube;
+        };
+
+        int cascadeSize_, numCascades_, cubeSize_;
+        float shadowDistance_, depthRange_;
+        glm::vec3 lightDirection_, lightColor_;
+        float cascadeSplits_[kMaxCascades];
+        unsigned int staticCascades_, finalCascades_; // GL_TEXTURE_2D_ARRAY, one layer per cascade
+        unsigned int drawFBO_, readFBO_;
+        std::vector<Region> cascadeRegions_;
+        std::vector<PointLight> pointLights_;
+        std::vector<Region> cubeRegions_; // 6 per point light
+        std::vector<Caster> casters_;
+        std::unique_ptr<Shader> depthShader_;
+        std::unique_ptr<GpuTimer> timer_;
+        Statistics stats_;
+
+        void updateWorldBounds(Caster &caster);
+        void touch(const glm::vec3 &worldMin, const glm::vec3 &worldMax, bool bStatic);
+        unsigned int createCube();
+        void attach(unsigned int fbo, unsigned int texture, int layer, bool bCube);
+        void renderRegion(Region &region, unsigned int texture, int layer, bool bCube, bool bStatic, const PointLight *light);
+        void copyLayer(unsigned int src, unsigned int dst, int layer, bool bCube, int size);
+        glm::mat4 cascadeMatrix(const glm::mat4 &invViewProj, float ndcNear, float ndcFar) const;
+    };
+}
+
+#endif /* glShadow_hpp */
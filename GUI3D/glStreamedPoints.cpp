@@ -0,0 +1,82 @@
+//
+//  glStreamedPoints.cpp
+//
+
+#include "glStreamedPoints.hpp"
+
+#include <algorithm>
+
+namespace glUtil {
+    StreamedPoints::StreamedPoints(size_t capacity, const std::string &shaderPath)
+            : capacity_(std::max<size_t>(1, capacity)), head_(0), size_(0) {
+        // positions and colors in separate buffers, so batches upload without interleaving on the CPU
+        glGenVertexArrays(1, &VAO_);
+        glGenBuffers(1, &positionVBO_);
+        glGenBuffers(1, &colorVBO_);
+        glBindVertexArray(VAO_);
+        glBindBuffer(GL_ARRAY_BUFFER, positionVBO_);
+        glBufferData(GL_ARRAY_BUFFER, capacity_ * 3 * sizeof(float), NULL, GL_DYNAMIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0);
+        glBindBuffer(GL_ARRAY_BUFFER, colorVBO_);
+        glBufferData(GL_ARRAY_BUFFER, capacity_ * sizeof(uint32_t), NULL, GL_DYNAMIC_DRAW);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(uint32_t), 0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+
+        shader_.reset(new Shader(shaderPath + "streamedPoints.vs", shaderPath + "streamedPoints.fs"));
+    }
+
+    StreamedPoints::~StreamedPoints() {
+        glDeleteVertexArrays(1, &VAO_);
+        glDeleteBuffers(1, &positionVBO_);
+        glDeleteBuffers(1, &colorVBO_);
+    }
+
+    void StreamedPoints::append(const float *positions, const uint32_t *colors, size_t n) {
+        if (n > capacity_) { // only the newest capacity_ points survive anyway
+            positions += (n - capacity_) * 3;
+            if (colors) colors += n - capacity_;
+            n = capacity_;
+        }
+        // split at the end of the ring
+        const size_t first = std::min(n, capacity_ - head_);
+        upload(positions, colors, head_, first);
+        if (first < n) upload(positions + first * 3, colors ? colors + first : nullptr, 0, n - first);
+        head_ = (head_ + n) % capacity_;
+        size_ = std::min(capacity_, size_ + n);
+    }
+
+    void StreamedPoints::upload(const float *positions, const uint32_t *colors, size_t offset, size_t n) {
+        if (!colors) {
+            if (white_.size() < n) white_.assign(n, 0xFFFFFFFFu);
+            colors = white_.data();
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, positionVBO_);
+        glBufferSubData(GL_ARRAY_BUFFER, offset * 3 * sizeof(float), n * 3 * sizeof(float), positions);
+        glBindBuffer(GL_ARRAY_BUFFER, colorVBO_);
+        glBufferSubData(GL_ARRAY_BUFFER, offset * sizeof(uint32_t), n * sizeof(uint32_t), colors);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void StreamedPoints::draw(const glm::mat4 &projection, const glm::mat4 &view, float pointSize) {
+        if (size_ == 0) return;
+        shader_->use();
+        shader_->set("projection", projection);
+        shader_->set("view", view);
+        glPointSize(pointSize);
+        glBindVertexArray(VAO_);
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(size_));
+        glBindVertexArray(0);
+    }
+
+    void StreamedPoints::drawWith(Shader *shader, float pointSize) {
+        if (size_ == 0) return;
+        shader->use();
+        glPointSize(pointSize);
+        glBindVertexArray(VAO_);
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(size_));
+        glBindVertexArray(0);
+    }
+}
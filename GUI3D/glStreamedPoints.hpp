@@ -0,0 +1,48 @@
+//
+//  glStreamedPoints.hpp
+//  A fixed-size GPU point cloud that grows by appending batches, e.g. map points from SC::DataIngest. Once full,
+//  new points overwrite the oldest ones, so memory and draw cost stay bounded however long the stream runs.
+//
+//  Usage:
+//      glUtil::StreamedPoints points(1 << 20, shaderPath);
+//      points.append(xyz, rgba, n);               // GL thread, any number of times per frame
+//      points.draw(projection, view, pointSize);  // with Shaders/streamedPoints.vs/.fs
+//
+
+#ifndef glStreamedPoints_hpp
+#define glStreamedPoints_hpp
+
+#include "glShader.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace glUtil {
+    class StreamedPoints {
+    public:
+        StreamedPoints(size_t capacity, const std::string &shaderPath);
+        ~StreamedPoints();
+
+        /// Upload n points: xyz positions and RGBA8 colors (R in the lowest byte), nullptr for white.
+        void append(const float *positions, const uint32_t *colors, size_t n);
+        void draw(const glm::mat4 &projection, const glm::mat4 &view, float pointSize = 2.f);
+        /// Draw with another shader that reads the positions at location 0, e.g. picking. The caller sets its
+        /// uniforms. Point i of the draw is slot i of the ring, not the i-th oldest point.
+        void drawWith(Shader *shader, float pointSize);
+        void clear() { head_ = size_ = 0; }
+
+        size_t size() const { return size_; }
+        size_t capacity() const { return capacity_; }
+
+    private:
+        void upload(const float *positions, const uint32_t *colors, size_t offset, size_t n);
+
+        size_t capacity_, head_, size_; // head_: next point to write
+        unsigned int VAO_, positionVBO_, colorVBO_;
+        std::unique_ptr<Shader> shader_;
+        std::vector<uint32_t> white_;
+    };
+}
+
+#endif /* glStreamedPoints_hpp */
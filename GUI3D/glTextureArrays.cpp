@@ -0,0 +1,167 @@
+//
+//  glTextureArrays.cpp
+//
+
+#include "glTextureArrays.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace glUtil {
+    TextureArrays::TextureArrays(bool bPreferBindless) : bBindless(bPreferBindless && isBindlessSupported()) {}
+
+    TextureArrays::~TextureArrays() {
+        for (const auto &slot : slots_)
+            if (slot.handle) glMakeTextureHandleNonResidentARB(slot.handle);
+        if (!arrays_.empty()) glDeleteTextures(GLsizei(arrays_.size()), arrays_.data());
+    }
+
+    bool TextureArrays::isBindlessSupported() {
+        static int supported = -1;
+        if (supported < 0) {
+            supported = 0;
+            GLint count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (GLint i = 0; i < count; ++i) {
+                const char *name = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, i));
+                if (name && std::strcmp(name, "GL_ARB_bindless_texture") == 0) supported = 1;
+            }
+        }
+        return supported == 1;
+    }
+
+    int TextureArrays::add(unsigned int texture) {
+        auto found = indexOf_.find(texture);
+        if (found != indexOf_.end()) return found->second;
+        if (bBuilt)
+            throw std::runtime_error("TEXTUREARRAYS::add::textures must be added before build().\n");
+        indexOf_[texture] = int(sources_.size());
+        sources_.push_back(texture);
+        slots_.emplace_back();
+        return int(sources_.size()) - 1;
+    }
+
+    int TextureArrays::slotOf(unsigned int texture) const {
+        auto found = indexOf_.find(texture);
+        return found == indexOf_.end() ? -1 : found->second;
+    }
+
+    TextureArrays::Format TextureArrays::formatOf(unsigned int texture) const {
+        Format format{};
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &format.width);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &format.height);
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_INTERNAL_FORMAT, &format.internalFormat);
+        GLint compressed = 0;
+        glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+        format.compressed = compressed != 0;
+        // levels that exist: up to MAX_LEVEL, and only as long as they have a size
+        GLint maxLevel = 1000;
+        glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+        format.levels = 1;
+        for (GLint level = 1; level <= maxLevel; ++level) {
+            GLint width = 0;
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+            if (width == 0) break;
+            format.levels++;
+        }
+        return format;
+    }
+
+    void TextureArrays::build() {
+        if (bBuilt) return;
+        bBuilt = true;
+        if (bBindless) {
+            for (size_t i = 0; i < sources_.size(); ++i) {
+                slots_[i].handle = glGetTextureHandleARB(sources_[i]);
+                glMakeTextureHandleResidentARB(slots_[i].handle);
+            }
+            return;
+        }
+
+        // group by size, format and mip count
+        std::map<Format, std::vector<int>> groups;
+        for (size_t i = 0; i < sources_.size(); ++i) groups[formatOf(sources_[i])].push_back(int(i));
+        if (groups.size() > size_t(kMaxArrays))
+            std::cout << "ERROR::TEXTUREARRAYS::" << groups.size() << " texture formats, only " << kMaxArrays
+                      << " arrays can be indexed. The rest are bound per texture." << std::endl;
+
+        std::vector<unsigned char> pixels;
+        for (const auto &group : groups) {
+            if (int(arrays_.size()) == kMaxArrays) break;
+            const Format &format = group.first;
+            const GLsizei layers = GLsizei(group.second.size());
+            unsigned int array;
+            glGenTextures(1, &array);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, array);
+            for (GLint level = 0; level < format.levels; ++level) {
+                const GLsizei width = std::max(1, format.width >> level), height = std::max(1, format.height >> level);
+                for (GLsizei layer = 0; layer < layers; ++layer) {
+                    const unsigned int source = sources_[group.second[layer]];
+                    glBindTexture(GL_TEXTURE_2D, source);
+                    if (format.compressed) {
+                        GLint bytes = 0;
+                        glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &bytes);
+                        if (layer == 0)
+                            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, format.internalFormat, width, height,
+                                                   layers, 0, bytes * layers, nullptr);
+                        pixels.resize(bytes);
+                        glGetCompressedTexImage(GL_TEXTURE_2D, level, pixels.data());
+                        glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1,
+                                                  format.internalFormat, bytes, pixels.data());
+                    } else {
+                        // the arrays are RGBA8 (sRGB kept), whatever the channel count of the sources
+                        const bool srgb = format.internalFormat == GL_SRGB8_ALPHA8 || format.internalFormat == GL_SRGB8;
+                        if (layer == 0)
+                            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, width, height,
+                                         layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+                        pixels.resize(size_t(width) * height * 4);
+                        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+                        glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+                        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, GL_RGBA,
+                                        GL_UNSIGNED_BYTE, pixels.data());
+                    }
+                }
+            }
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, format.levels - 1);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                            format.levels > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            for (GLsizei layer = 0; layer < layers; ++layer) {
+                slots_[group.second[layer]].array = int(arrays_.size());
+                slots_[group.second[layer]].layer = layer;
+            }
+            arrays_.push_back(array);
+        }
+        // textures left out have no slot: slotOf returns -1 and Mesh binds them as usual
+        for (size_t i = 0; i < sources_.size(); ++i)
+            if (slots_[i].array < 0) indexOf_.erase(sources_[i]);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    void TextureArrays::bind(Shader *shader, int firstUnit) const {
+        if (bBindless) return;
+        for (int i = 0; i < kMaxArrays; ++i) {
+            // unused entries point at the last array so every sampler has a valid binding
+            const int unit = firstUnit + std::min(i, std::max(int(arrays_.size()) - 1, 0));
+            if (i < int(arrays_.size())) {
+                glActiveTexture(GL_TEXTURE0 + unit);
+                glBindTexture(GL_TEXTURE_2D_ARRAY, arrays_[i]);
+            }
+            shader->set(("textureArrays[" + std::to_string(i) + "]").c_str(), unit);
+        }
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    void TextureArrays::setSlot(GLint location, int index) const {
+        if (location < 0 || index < 0) return;
+        const Slot &slot = slots_[index];
+        if (bBindless)
+            glUniformHandleui64ARB(location, slot.handle);
+        else
+            glUniform2i(location, slot.array, slot.layer);
+    }
+}
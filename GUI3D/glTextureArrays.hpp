@@ -0,0 +1,83 @@
+//
+//  glTextureArrays.hpp
+//  Materials' textures packed into a few GL_TEXTURE_2D_ARRAYs, or bindless handles.
+//
+//  Textures of the same size and format share one array; a texture is then addressed by a slot (array, layer)
+//  uniform instead of its own binding, so a scene binds its arrays once rather than its textures per mesh.
+//  With GL_ARB_bindless_texture the textures stay separate and a slot is a resident 64-bit handle that is
+//  written straight into the sampler uniform.
+//
+//  Usage:
+//      glUtil::TextureArrays arrays;
+//      arrays.add(texture) for every texture, then arrays.build();
+//      per frame: arrays.bind(shader, firstUnit); then per mesh arrays.setSlot(location, index) (Mesh does this)
+//
+//  Model::outputShaderTemplate writes the matching sampler declarations and the textureSlot() lookup.
+//
+
+#ifndef glTextureArrays_hpp
+#define glTextureArrays_hpp
+
+#include "glShader.hpp"
+#include <cstdint>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace glUtil {
+    class TextureArrays {
+    public:
+        /// Arrays a shader can index; textureArrays[kMaxArrays] in the shader.
+        static const int kMaxArrays = 8;
+
+        struct Slot {
+            int array = -1, layer = -1; // texture array mode
+            uint64_t handle = 0;        // bindless mode
+        };
+
+        /// Bindless is used if requested and the driver has GL_ARB_bindless_texture.
+        explicit TextureArrays(bool bPreferBindless = false);
+        ~TextureArrays();
+
+        /// Register a GL_TEXTURE_2D before build(). Adding the same texture again returns the same index.
+        int add(unsigned int texture);
+        /// Copy all registered textures into arrays (or make their handles resident). Layer 0 of every source is
+        /// copied with all of its mip levels; the source textures can be released afterwards in array mode.
+        void build();
+        bool isBuilt() const { return bBuilt; }
+
+        const Slot &slot(int index) const { return slots_[index]; }
+        /// Index of a texture added before, or -1 if it is unknown or did not fit into the kMaxArrays arrays.
+        int slotOf(unsigned int texture) const;
+
+        /// Bind the arrays to units firstUnit.. and point the shader's textureArrays[] at them. No-op if bindless.
+        void bind(Shader *shader, int firstUnit) const;
+        /// Set the uniform of a texture in the current program: an ivec2 (array, layer), or the bindless handle of
+        /// a sampler2D declared with layout(bindless_sampler).
+        void setSlot(GLint location, int index) const;
+
+        bool isBindless() const { return bBindless; }
+        int numArrays() const { return int(arrays_.size()); }
+        size_t numTextures() const { return sources_.size(); }
+        static bool isBindlessSupported();
+
+    private:
+        struct Format {
+            GLint width, height, internalFormat, levels;
+            bool compressed;
+            bool operator<(const Format &o) const {
+                return std::tie(width, height, internalFormat, levels) <
+                       std::tie(o.width, o.height, o.internalFormat, o.levels);
+            }
+        };
+        Format formatOf(unsigned int texture) const;
+
+        bool bBindless, bBuilt = false;
+        std::vector<unsigned int> sources_;
+        std::map<unsigned int, int> indexOf_;
+        std::vector<Slot> slots_;
+        std::vector<unsigned int> arrays_;
+    };
+}
+
+#endif /* glTextureArrays_hpp */
@@ -0,0 +1,164 @@
+//
+//  glTextureCache.cpp
+//
+
+#include "glTextureCache.hpp"
+#include "glCompressedTexture.hpp"
+#include "glUtils.hpp"
+#include "texture_compression.hpp"
+#include <climits>
+#include <cstdlib>
+
+namespace glUtil {
+    namespace {
+        std::string canonicalPath(const std::string &path) {
+            char resolved[PATH_MAX];
+            return realpath(path.c_str(), resolved) ? std::string(resolved) : path;
+        }
+
+        unsigned int upload2D(const std::vector<std::string> &paths, size_t *bytes) {
+            return Utils::uploadTexture(paths.front().c_str(), bytes);
+        }
+    }
+
+    TextureCache::TextureCache() = default;
+    TextureCache::~TextureCache() = default;
+
+    TextureCache &TextureCache::instance() {
+        static TextureCache cache;
+        return cache;
+    }
+
+    unsigned int TextureCache::acquire(const std::string &path) {
+        const std::string canonical = canonicalPath(path);
+        return acquire(canonical, canonical, upload2D, {path});
+    }
+
+    unsigned int TextureCache::acquire(const std::string &path, SC::BlockFormat format, bool bSRGB) {
+        if (!compressed_) return acquire(path);
+        const std::string canonical = canonicalPath(path);
+        // one entry per encoding; no content matching, the KTX2 cache is keyed by content already
+        const std::string key = canonical + "|bc" + std::to_string(int(format)) + (bSRGB ? "s" : "");
+        CompressedTextureCache *compressed = compressed_.get();
+        return acquire(key, "", [compressed, format, bSRGB](const std::vector<std::string> &paths, size_t *bytes) {
+            return compressed->load(paths.front(), format, bSRGB, bytes);
+        }, {path});
+    }
+
+    void TextureCache::setCompression(const std::string &cacheDir) {
+        compressed_.reset(cacheDir.empty() ? nullptr : new CompressedTextureCache(cacheDir));
+    }
+
+    unsigned int TextureCache::acquireCubemap(const std::vector<std::string> &faces) {
+        if (faces.size() != 6)
+            throw std::runtime_error("GLUTIL::TEXTURECACHE::faces must have 6 elements.\n");
+        std::string key = "cube:";
+        for (const auto &face : faces) key += canonicalPath(face) + '|';
+        // the faces are hashed as one: only the first face would be ambiguous
+        return acquire(key, "", Utils::uploadCubemap, faces);
+    }
+
+    unsigned int TextureCache::acquire(const std::string &key, const std::string &hashPath,
+                                       const std::function<unsigned int(const std::vector<std::string> &, size_t *)> &upload,
+                                       const std::vector<std::string> &paths) {
+        auto found = byPath_.find(key);
+        if (found != byPath_.end()) {
+            Entry &entry = entries_[found->second];
+            retain(entry.id);
+            stats_.hits++;
+            stats_.bytesSaved += entry.bytes;
+            return entry.id;
+        }
+
+        uint64_t hash = 0;
+        if (bContentHashing && !hashPath.empty()) {
+            try {
+                hash = SC::HashFile(hashPath);
+            } catch (const std::runtime_error &) {
+                hash = 0; // let the loader report the missing file
+            }
+            auto same = hash ? byContent_.find(hash) : byContent_.end();
+            if (same != byContent_.end()) {
+                Entry &entry = entries_[same->second];
+                entry.keys.push_back(key);
+                byPath_[key] = entry.id;
+                retain(entry.id);
+                stats_.contentHits++;
+                stats_.bytesSaved += entry.bytes;
+                return entry.id;
+            }
+        }
+
+        size_t bytes = 0;
+        const unsigned int id = upload(paths, &bytes);
+        Entry &entry = entries_[id];
+        entry.id = id;
+        entry.bytes = bytes;
+        entry.refs = 1;
+        entry.keys = {key};
+        entry.contentHash = hash;
+        entry.unusedIt = unused_.end();
+        byPath_[key] = id;
+        if (hash) byContent_[hash] = id;
+        stats_.misses++;
+        stats_.textures++;
+        stats_.bytesResident += bytes;
+        return id;
+    }
+
+    void TextureCache::retain(unsigned int textureId) {
+        auto it = entries_.find(textureId);
+        if (it == entries_.end()) return;
+        Entry &entry = it->second;
+        if (entry.refs++ == 0) {
+            unused_.erase(entry.unusedIt);
+            entry.unusedIt = unused_.end();
+            stats_.bytesUnused -= entry.bytes;
+        }
+    }
+
+    void TextureCache::release(unsigned int textureId) {
+        auto it = entries_.find(textureId);
+        if (it == entries_.end() || it->second.refs == 0) return;
+        Entry &entry = it->second;
+        if (--entry.refs > 0) return;
+        entry.unusedIt = unused_.insert(unused_.end(), textureId);
+        stats_.bytesUnused += entry.bytes;
+        evict(unusedBudget_);
+    }
+
+    void TextureCache::setUnusedBudget(size_t bytes) {
+        unusedBudget_ = bytes;
+        evict(unusedBudget_);
+    }
+
+    void TextureCache::trim() {
+        evict(0);
+    }
+
+    int TextureCache::refCount(unsigned int textureId) const {
+        auto it = entries_.find(textureId);
+        return it == entries_.end() ? 0 : it->second.refs;
+    }
+
+    void TextureCache::evict(size_t budget) {
+        while (stats_.bytesUnused > budget || (budget == 0 && !unused_.empty())) {
+            const unsigned int id = unused_.front();
+            unused_.pop_front();
+            Entry &entry = entries_[id];
+            stats_.bytesUnused -= entry.bytes;
+            stats_.evictions++;
+            erase(entry);
+        }
+    }
+
+    void TextureCache::erase(Entry &entry) {
+        const unsigned int id = entry.id;
+        for (const auto &key : entry.keys) byPath_.erase(key);
+        if (entry.contentHash) byContent_.erase(entry.contentHash);
+        glDeleteTextures(1, &entry.id);
+        stats_.bytesResident -= entry.bytes;
+        stats_.textures--;
+        entries_.erase(id);
+    }
+}
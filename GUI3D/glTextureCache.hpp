@@ -0,0 +1,108 @@
+//
+//  glTextureCache.hpp
+//  Process-wide, reference-counted texture cache.
+//
+//  Textures are keyed by their canonical path (realpath), so "a/../b.png" and "b.png" share one upload. With
+//  content hashing enabled, a file at a new path is hashed first and joins an identical texture that is already
+//  resident. Released textures stay resident up to an unused-memory budget and are evicted oldest first.
+//  With setCompression, textures acquired with a block format are uploaded as BCn from a KTX2 cache (see
+//  glCompressedTexture.hpp), or as before where the driver lacks the format.
+//
+//  Not thread-safe: use it from the thread that owns the GL context.
+//
+//  Usage:
+//      unsigned int id = glUtil::TextureCache::instance().acquire("atlas.png");
+//      ...
+//      glUtil::TextureCache::instance().release(id);
+//
+
+#ifndef glTextureCache_hpp
+#define glTextureCache_hpp
+
+#include "texture_compression.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace glUtil {
+    class CompressedTextureCache;
+
+    class TextureCache {
+    public:
+        struct Statistics {
+            size_t hits = 0;         // found by path
+            size_t contentHits = 0;  // new path, identical content
+            size_t misses = 0;       // decoded and uploaded
+            size_t bytesSaved = 0;   // uploads avoided by hits and content hits
+            size_t bytesResident = 0;
+            size_t bytesUnused = 0;  // resident with a reference count of 0
+            size_t evictions = 0;
+            size_t textures = 0;
+        };
+
+        static TextureCache &instance();
+
+        /// GL_TEXTURE_2D with mipmaps. Every acquire needs one release.
+        unsigned int acquire(const std::string &path);
+        /// Like acquire(path), but compressed to format while setCompression is on.
+        unsigned int acquire(const std::string &path, SC::BlockFormat format, bool bSRGB = false);
+        /// GL_TEXTURE_CUBE_MAP from 6 faces: right, left, top, bottom, front, back.
+        unsigned int acquireCubemap(const std::vector<std::string> &faces);
+        /// Add a reference to a texture returned by acquire, e.g. when a Model is copied.
+        void retain(unsigned int textureId);
+        /// Ids not owned by the cache are ignored.
+        void release(unsigned int textureId);
+
+        /// Memory kept for textures nobody references. 0 deletes them on release.
+        void setUnusedBudget(size_t bytes);
+        size_t unusedBudget() const { return unusedBudget_; }
+        /// Keep BCn copies of the textures acquired with a block format in cacheDir and upload those. An empty
+        /// directory turns it off. Textures acquired before keep their format.
+        void setCompression(const std::string &cacheDir);
+        bool isCompressing() const { return compressed_ != nullptr; }
+        /// Also match textures by content hash. Costs one file read per new path.
+        void setContentHashing(bool option) { bContentHashing = option; }
+        /// Delete every unreferenced texture.
+        void trim();
+
+        const Statistics &statistics() const { return stats_; }
+        int refCount(unsigned int textureId) const;
+
+    private:
+        TextureCache();
+        ~TextureCache();
+        TextureCache(const TextureCache &) = delete;
+        TextureCache &operator=(const TextureCache &) = delete;
+
+        struct Entry {
+            unsigned int id = 0;
+            size_t bytes = 0;
+            int refs = 0;
+            std::vector<std::string> keys; // all paths aliasing this texture
+            uint64_t contentHash = 0;
+            std::list<unsigned int>::iterator unusedIt;
+        };
+
+        unsigned int acquire(const std::string &key, const std::string &hashPath,
+                             const std::function<unsigned int(const std::vector<std::string> &, size_t *)> &upload,
+                             const std::vector<std::string> &paths);
+        void evict(size_t budget);
+        void erase(Entry &entry);
+
+        std::unordered_map<std::string, unsigned int> byPath_;
+        std::unordered_map<uint64_t, unsigned int> byContent_;
+        std::unordered_map<unsigned int, Entry> entries_;
+        std::list<unsigned int> unused_; // least recently released first
+        size_t unusedBudget_ = size_t(64) << 20;
+        bool bContentHashing = false;
+        std::unique_ptr<CompressedTextureCache> compressed_;
+        Statistics stats_;
+    };
+}
+
+#endif /* glTextureCache_hpp */
@@ -6,6 +6,11 @@
 //
 
 #include "glUtils.hpp"
+#include "glTextureCache.hpp"
+#ifdef WITH_STB
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#endif
 
 namespace glUtil {
 #ifdef WITH_STB
@@ -18,7 +23,7 @@ namespace glUtil {
     // +Z (front)
     // -Z (back)
     // -------------------------------------------------------
-    unsigned int Utils::loadCubemap(const std::vector<std::string> &faces)
+    unsigned int Utils::uploadCubemap(const std::vector<std::string> &faces, size_t *bytes)
     {
         if(faces.size() != 6)
             throw std::runtime_error("GLUTIL::LOADCUBEMAP::faces must have 6 elements.\n");
@@ -28,6 +33,7 @@ namespace glUtil {
         glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
         
         int width, height, nrChannels;
+        if(bytes) *bytes = 0;
         for (unsigned int i = 0; i < faces.size(); i++)
         {
             unsigned char *data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
@@ -36,6 +42,7 @@ namespace glUtil {
                 glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i,
                              0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data
                              );
+                if(bytes) *bytes += size_t(width) * height * 3;
                 stbi_image_free(data);
             }
             else
@@ -53,7 +60,7 @@ namespace glUtil {
         return textureID;
     }
     
-    uint Utils::loadTexture(char const * path){
+    uint Utils::uploadTexture(char const * path, size_t *bytes){
         unsigned int textureID;
         glGenTextures(1, &textureID);
         
@@ -74,6 +81,7 @@ namespace glUtil {
             glBindTexture(GL_TEXTURE_2D, textureID);
             glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
             glGenerateMipmap(GL_TEXTURE_2D);
+            if(bytes) *bytes = size_t(width) * height * nrComponents * 4 / 3; // with the mip chain
             
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -91,14 +99,21 @@ namespace glUtil {
         return textureID;
     }
 #else
-    unsigned int Utils::loadCubemap(const std::vector<std::string> &faces){
+    unsigned int Utils::uploadCubemap(const std::vector<std::string> &faces, size_t *bytes){
         throw std::runtime_error("load cube map requires stb library!\n");
     }
-    uint Utils::loadTexture(char const *path) {
-        throw std::runtime_error("load cube map requires stb library!\n");
+    uint Utils::uploadTexture(char const *path, size_t *bytes) {
+        throw std::runtime_error("load texture requires stb library!\n");
     }
 #endif
     
+    unsigned int Utils::loadCubemap(const std::vector<std::string> &faces){
+        return TextureCache::instance().acquireCubemap(faces);
+    }
+    uint Utils::loadTexture(char const *path) {
+        return TextureCache::instance().acquire(path);
+    }
+    
     void Utils::save_screen( const char *spath )
     {
         
@@ -21,13 +21,18 @@
 
 #include "glShader.hpp"
 #include "glMesh.hpp"
+#include "glTextureCache.hpp"
 
 namespace glUtil {
     class Utils {
     public:
         // faces should have 6 paths: right, left, front, back, top, bottom
+        // Both go through the shared TextureCache; release the result with TextureCache::release, not glDeleteTextures.
         static unsigned int loadCubemap(const std::vector<std::string> &faces);
         uint loadTexture(char const * path);
+        // Decode and upload without the cache. bytes returns the estimated GPU memory.
+        static unsigned int uploadCubemap(const std::vector<std::string> &faces, size_t *bytes = nullptr);
+        static uint uploadTexture(char const * path, size_t *bytes = nullptr);
         static void save_screen( const char *spath );
         
     };
@@ -51,7 +56,7 @@ namespace glUtil {
         }
         
         ~SkyBox(){
-            glDeleteTextures(1, &textureId);
+            TextureCache::instance().release(textureId);
         }
         void init(){
             mesh = new Mesh(ShapeVertices().skybox);
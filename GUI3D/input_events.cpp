@@ -0,0 +1,69 @@
+#include "input_events.hpp"
+
+#include <algorithm>
+
+using namespace SC;
+
+int KeyBindings::bind(int key, int mods, std::function<void()> action, const std::string &description,
+                      bool bRepeat, void *source) {
+    if (key < 0 || key >= kNumKeys) return -1;
+    bindings_.push_back({key, mods == kAnyMods ? kAnyMods : (mods & kModsMask), bRepeat, source, std::move(action),
+                         description});
+    bDirty_ = true;
+    return int(bindings_.size()) - 1;
+}
+
+void KeyBindings::clear() {
+    bindings_.clear();
+    bDirty_ = true;
+}
+
+void KeyBindings::rebuild() {
+    // counting sort by key, registration order kept within a key
+    offsets_.assign(kNumKeys + 1, 0);
+    for (const auto &binding : bindings_) offsets_[binding.key + 1]++;
+    for (int k = 0; k < kNumKeys; ++k) offsets_[k + 1] += offsets_[k];
+    order_.resize(bindings_.size());
+    std::vector<uint32_t> cursor(offsets_.begin(), offsets_.end() - 1);
+    for (size_t i = 0; i < bindings_.size(); ++i) order_[cursor[bindings_[i].key]++] = int(i);
+    bDirty_ = false;
+}
+
+int KeyBindings::dispatch(const InputEvent &event, bool bRunActions) {
+    if (event.type != InputEvent::Key || event.code < 0 || event.code >= kNumKeys) return 0;
+    const bool bRepeat = event.action == 2;
+    if (event.action == 0) {
+        down_[event.code] = 0;
+        return 0;
+    }
+    // a press while down is a lost release (e.g. focus change); treat it as a fresh press
+    down_[event.code] = 1;
+    if (!bRunActions) return 0;
+    if (bDirty_) rebuild();
+
+    const int mods = event.mods & kModsMask;
+    int called = 0;
+    for (int pass = 0; pass < 2 && called == 0; ++pass) { // chords first, then any-modifier bindings
+        for (uint32_t i = offsets_[event.code]; i < offsets_[event.code + 1]; ++i) {
+            const Binding &binding = bindings_[order_[i]];
+            if (pass == 0 ? binding.mods != mods : binding.mods != kAnyMods) continue;
+            if (bRepeat && !binding.bRepeat) continue;
+            if (binding.source && binding.source != event.source) continue;
+            binding.action();
+            called++;
+        }
+    }
+    return called;
+}
+
+int InputQueue::process(KeyBindings &bindings, const std::function<void(const InputEvent &)> &handler,
+                        bool bKeyboardCaptured) {
+    InputEvent event;
+    int count = 0;
+    while (events_.pop(event)) {
+        if (event.type == InputEvent::Key) bindings.dispatch(event, !bKeyboardCaptured);
+        if (handler) handler(event);
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "spsc_queue.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace SC {
+    /// One window system callback, recorded as it arrived. Codes and mods are GLFW's.
+    struct InputEvent {
+        enum Type : uint8_t { Key, MouseButton, CursorPos, Scroll };
+        Type type = Key;
+        int code = 0;          // key or mouse button
+        int action = 0;        // 0 release, 1 press, 2 repeat
+        int mods = 0;          // shift 1, control 2, alt 4, super 8
+        double x = 0, y = 0;   // cursor position or scroll offset
+        double time = 0;       // seconds, caller's clock
+        void *source = nullptr; // the window
+    };
+
+    /**
+     Key bindings in a flat table indexed by key code, so dispatching an event only looks at the bindings of
+     that key no matter how many are registered. Bindings fire on press, and on the key repeat of the window
+     system if they ask for it.
+
+     A chord binding requires exactly its modifiers (e.g. control + S). A binding with kAnyMods fires whatever
+     modifiers are held, unless a chord of the same key matched.
+     */
+    class KeyBindings {
+    public:
+        static const int kNumKeys = 512;  // above GLFW_KEY_LAST
+        static const int kAnyMods = -1;
+        static const int kModsMask = 0xF; // shift, control, alt, super; caps and num lock are ignored
+
+        struct Binding {
+            int key;
+            int mods;
+            bool bRepeat;
+            void *source; // only events of this window, nullptr for all
+            std::function<void()> action;
+            std::string description;
+        };
+
+        /// Returns the binding id.
+        int bind(int key, int mods, std::function<void()> action, const std::string &description = "",
+                 bool bRepeat = false, void *source = nullptr);
+        void clear();
+
+        /// Run the bindings matching a key event. Returns the number of actions called. Actions must not bind().
+        /// @param bRunActions false only tracks which keys are down.
+        int dispatch(const InputEvent &event, bool bRunActions = true);
+        bool isDown(int key) const { return key >= 0 && key < kNumKeys && down_[key]; }
+
+        const std::vector<Binding> &bindings() const { return bindings_; }
+
+    private:
+        std::vector<Binding> bindings_;   // in registration order
+        std::vector<int> order_;          // binding ids sorted by key
+        std::vector<uint32_t> offsets_;   // per key, its range in order_; rebuilt lazily after bind
+        std::vector<uint8_t> down_ = std::vector<uint8_t>(kNumKeys, 0);
+        bool bDirty_ = true; // offsets_ is built on the first dispatch, even with no bindings
+
+        void rebuild();
+    };
+
+    /**
+     Window system callbacks go into a lock-free queue with their timestamp and are dispatched once per frame,
+     in order. Recording does no work beyond a copy, so callbacks may come from another thread than the one
+     that processes them (one producer, one consumer).
+     */
+    class InputQueue {
+    public:
+        explicit InputQueue(size_t capacity = 1024) : events_(capacity), dropped_(0) {}
+
+        /// Producer. Returns false and counts the event as dropped if the queue is full.
+        bool record(const InputEvent &event) {
+            if (events_.push(event)) return true;
+            dropped_++;
+            return false;
+        }
+
+        /**
+         Consumer. Key events go to the bindings, every event goes to the optional handler (e.g. camera control).
+         @param bKeyboardCaptured Skip the key bindings, e.g. while a text field has focus. Key state is still tracked.
+         @return Number of events processed.
+         */
+        int process(KeyBindings &bindings, const std::function<void(const InputEvent &)> &handler = nullptr,
+                    bool bKeyboardCaptured = false);
+
+        /// Consumer. Drop the queued events unprocessed, e.g. live input during a replay. Returns how many.
+        /// @param inspect sees every event before it is dropped, e.g. to still honour a key that stops the replay.
+        int discard(const std::function<void(const InputEvent &)> &inspect = nullptr) {
+            InputEvent event;
+            int count = 0;
+            while (events_.pop(event)) {
+                if (inspect) inspect(event);
+                count++;
+            }
+            return count;
+        }
+
+        size_t dropped() const { return dropped_; }
+
+    private:
+        SpscQueue<InputEvent> events_;
+        size_t dropped_;
+    };
+}
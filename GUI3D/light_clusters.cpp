@@ -0,0 +1,90 @@
+#include "light_clusters.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace SC;
+
+LightClusters::LightClusters(int tilesX, int tilesY, int depthSlices)
+        : tilesX_(std::max(1, tilesX)), tilesY_(std::max(1, tilesY)), depthSlices_(std::max(1, depthSlices)),
+          maxPerCluster_(0) {
+    ranges_.resize(size_t(numClusters()) * 2);
+}
+
+void LightClusters::build(const ClusterLight *lights, int numLights, const float *m,
+                          float projScaleX, float projScaleY, float nearPlane, float farPlane, bool bOrthographic) {
+    const int numClusters = this->numClusters();
+    std::fill(ranges_.begin(), ranges_.end(), 0u);
+    extents_.resize(numLights);
+    const float sliceScale = bOrthographic ? depthSlices_ / (farPlane - nearPlane)
+                                           : depthSlices_ / std::log(farPlane / nearPlane);
+
+    auto tile = [](float ndc, int tiles) {
+        return std::min(std::max(int(std::floor((ndc * 0.5f + 0.5f) * tiles)), 0), tiles - 1);
+    };
+    auto slice = [&](float depth) {
+        const float s = bOrthographic ? (depth - nearPlane) * sliceScale : std::log(depth / nearPlane) * sliceScale;
+        return std::min(std::max(int(std::floor(s)), 0), depthSlices_ - 1);
+    };
+
+    // Pass 1: cluster range of every light and the number of lights per cluster
+    for (int i = 0; i < numLights; ++i) {
+        const ClusterLight &light = lights[i];
+        const float *p = light.position;
+        const float vx = m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12];
+        const float vy = m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13];
+        const float depth = -(m[2] * p[0] + m[6] * p[1] + m[10] * p[2] + m[14]);
+        const float r = light.radius;
+        Extent &e = extents_[i];
+        if (depth + r < nearPlane || depth - r > farPlane || r <= 0) {
+            e.x0 = -1;
+            continue;
+        }
+        const float dMin = std::max(depth - r, nearPlane), dMax = std::min(depth + r, farPlane);
+        float x0, x1, y0, y1;
+        if (bOrthographic) { // no division by depth: the box projects as it is
+            x0 = (vx - r) * projScaleX;
+            x1 = (vx + r) * projScaleX;
+            y0 = (vy - r) * projScaleY;
+            y1 = (vy + r) * projScaleY;
+        } else {
+            // x / depth is monotonic in both, so the corners of the sphere's view-space box bound its projection
+            x0 = std::min((vx - r) / dMin, (vx - r) / dMax) * projScaleX;
+            x1 = std::max((vx + r) / dMin, (vx + r) / dMax) * projScaleX;
+            y0 = std::min((vy - r) / dMin, (vy - r) / dMax) * projScaleY;
+            y1 = std::max((vy + r) / dMin, (vy + r) / dMax) * projScaleY;
+        }
+        if (x1 < -1.f || x0 > 1.f || y1 < -1.f || y0 > 1.f) {
+            e.x0 = -1;
+            continue;
+        }
+        e = {tile(x0, tilesX_), tile(x1, tilesX_), tile(y0, tilesY_), tile(y1, tilesY_), slice(dMin), slice(dMax)};
+        for (int z = e.z0; z <= e.z1; ++z)
+            for (int y = e.y0; y <= e.y1; ++y)
+                for (int x = e.x0; x <= e.x1; ++x)
+                    ranges_[((z * tilesY_ + y) * tilesX_ + x) * 2 + 1]++;
+    }
+
+    // Prefix sum into offsets
+    uint32_t offset = 0;
+    maxPerCluster_ = 0;
+    for (int c = 0; c < numClusters; ++c) {
+        ranges_[c * 2] = offset;
+        offset += ranges_[c * 2 + 1];
+        maxPerCluster_ = std::max(maxPerCluster_, int(ranges_[c * 2 + 1]));
+        ranges_[c * 2 + 1] = 0; // refilled as the write cursor in pass 2
+    }
+    indices_.resize(offset);
+
+    // Pass 2: scatter the light indices. Lights stay in ascending order within each cluster.
+    for (int i = 0; i < numLights; ++i) {
+        const Extent &e = extents_[i];
+        if (e.x0 < 0) continue;
+        for (int z = e.z0; z <= e.z1; ++z)
+            for (int y = e.y0; y <= e.y1; ++y)
+                for (int x = e.x0; x <= e.x1; ++x) {
+                    uint32_t *range = &ranges_[((z * tilesY_ + y) * tilesX_ + x) * 2];
+                    indices_[range[0] + range[1]++] = uint32_t(i);
+                }
+    }
+}
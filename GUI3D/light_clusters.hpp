@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace SC {
+    /// A point light as stored in the light buffer: two vec4 texels (position + radius, color + intensity).
+    struct ClusterLight {
+        float position[3]; // world space
+        float radius;      // no contribution beyond this distance
+        float color[3];
+        float intensity;
+    };
+
+    /**
+     Bins point lights into a view-space froxel grid: tilesX * tilesY screen tiles times depthSlices exponential
+     depth slices between near and far (linear slices for orthographic views). Each cluster gets a range in one shared light index list, so a fragment
+     only evaluates the lights whose sphere touches its cluster.
+
+     The grid assumes a symmetric perspective or orthographic projection.
+     */
+    class LightClusters {
+    public:
+        LightClusters(int tilesX = 16, int tilesY = 9, int depthSlices = 24);
+
+        /**
+         @param viewMatrix column-major 4x4 world to view.
+         @param projScaleX, projScaleY projection[0][0] and projection[1][1].
+         @param bOrthographic tiles are slabs of constant width instead of planes through the eye, and the depth
+         slices are spaced linearly.
+         */
+        void build(const ClusterLight *lights, int numLights, const float *viewMatrix,
+                   float projScaleX, float projScaleY, float nearPlane, float farPlane, bool bOrthographic = false);
+
+        int tilesX() const { return tilesX_; }
+        int tilesY() const { return tilesY_; }
+        int depthSlices() const { return depthSlices_; }
+        int numClusters() const { return tilesX_ * tilesY_ * depthSlices_; }
+
+        /// Per cluster (x fastest, then y, then slice): offset into lightIndices() and light count.
+        const std::vector<uint32_t> &clusterRanges() const { return ranges_; }
+        const std::vector<uint32_t> &lightIndices() const { return indices_; }
+        int maxLightsPerCluster() const { return maxPerCluster_; }
+
+    private:
+        int tilesX_, tilesY_, depthSlices_;
+        std::vector<uint32_t> ranges_, indices_;
+        int maxPerCluster_;
+
+        struct Extent { int x0, x1, y0, y1, z0, z1; };
+        std::vector<Extent> extents_; // per light, -1 if culled
+    };
+}
@@ -0,0 +1,250 @@
+#include "mesh_cache.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace SC;
+
+namespace {
+    const char kMagic[8] = {'S', 'C', 'M', 'E', 'S', 'H', '\0', '\0'};
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t vertexStride;
+        uint64_t sourceSize;
+        int64_t sourceMTime; // nanoseconds
+        uint32_t numMeshes;
+        uint32_t numTextures;
+        uint32_t flags;
+        uint32_t numLods;
+        float bounds[6];
+        uint64_t meshTable;
+        uint64_t textureTable;
+        uint64_t lodTable;
+        uint64_t strings;
+        uint64_t fileSize;
+    };
+
+    struct MeshRecord {
+        uint64_t vertexOffset;
+        uint64_t indexOffset;
+        uint32_t numVertices;
+        uint32_t numIndices;
+        uint32_t firstTexture;
+        uint32_t numTextures;
+        uint32_t firstLod;
+        uint32_t numLods;
+    };
+
+    struct TextureRecord {
+        uint32_t name; // offsets into the string table
+        uint32_t path;
+    };
+
+    bool sourceStamp(const std::string &path, uint64_t &size, int64_t &mtime) {
+        struct stat info;
+        if (stat(path.c_str(), &info) != 0) return false;
+        size = uint64_t(info.st_size);
+#ifdef __APPLE__
+        mtime = int64_t(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+        mtime = int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+        return true;
+    }
+
+    size_t align(size_t offset) {
+        return (offset + kMeshCacheAlignment - 1) / kMeshCacheAlignment * kMeshCacheAlignment;
+    }
+}
+
+void MeshCacheWriter::addMesh(const void *vertices, uint32_t numVertices, const uint32_t *indices,
+                              uint32_t numIndices, const std::vector<MeshCacheTexture> &textures,
+                              const std::vector<MeshCacheLod> &lods) {
+    Mesh mesh;
+    const uint8_t *bytes = static_cast<const uint8_t *>(vertices);
+    mesh.vertices.assign(bytes, bytes + size_t(numVertices) * stride_);
+    mesh.indices.assign(indices, indices + numIndices);
+    mesh.textures = textures;
+    mesh.lods = lods;
+    meshes_.push_back(std::move(mesh));
+}
+
+void MeshCacheWriter::write(const std::string &path, const std::string &sourcePath) const {
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kMeshCacheVersion;
+    header.vertexStride = stride_;
+    if (!sourceStamp(sourcePath, header.sourceSize, header.sourceMTime))
+        throw std::runtime_error("MeshCacheWriter: cannot stat " + sourcePath);
+    header.numMeshes = uint32_t(meshes_.size());
+    header.flags = flags_;
+    std::copy(bounds_, bounds_ + 6, header.bounds);
+
+    std::vector<MeshRecord> meshTable(meshes_.size());
+    std::vector<TextureRecord> textureTable;
+    std::vector<MeshCacheLod> lodTable;
+    std::string strings;
+    auto addString = [&strings](const std::string &s) {
+        const uint32_t offset = uint32_t(strings.size());
+        strings.append(s).push_back('\0');
+        return offset;
+    };
+    for (size_t i = 0; i < meshes_.size(); ++i) {
+        meshTable[i].firstTexture = uint32_t(textureTable.size());
+        meshTable[i].numTextures = uint32_t(meshes_[i].textures.size());
+        for (const auto &texture : meshes_[i].textures)
+            textureTable.push_back({addString(texture.name), addString(texture.path)});
+        meshTable[i].firstLod = uint32_t(lodTable.size());
+        meshTable[i].numLods = uint32_t(meshes_[i].lods.size());
+        lodTable.insert(lodTable.end(), meshes_[i].lods.begin(), meshes_[i].lods.end());
+    }
+    header.numTextures = uint32_t(textureTable.size());
+    header.numLods = uint32_t(lodTable.size());
+
+    size_t offset = sizeof(Header);
+    header.meshTable = offset;
+    offset += meshTable.size() * sizeof(MeshRecord);
+    header.textureTable = offset;
+    offset += textureTable.size() * sizeof(TextureRecord);
+    header.lodTable = offset;
+    offset += lodTable.size() * sizeof(MeshCacheLod);
+    header.strings = offset;
+    offset += strings.size();
+    for (size_t i = 0; i < meshes_.size(); ++i) {
+        meshTable[i].numVertices = uint32_t(meshes_[i].vertices.size() / stride_);
+        meshTable[i].numIndices = uint32_t(meshes_[i].indices.size());
+        offset = align(offset);
+        meshTable[i].vertexOffset = offset;
+        offset += meshes_[i].vertices.size();
+        offset = align(offset);
+        meshTable[i].indexOffset = offset;
+        offset += meshes_[i].indices.size() * sizeof(uint32_t);
+    }
+    header.fileSize = offset;
+
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary);
+        if (!file.is_open())
+            throw std::runtime_error("MeshCacheWriter: cannot open " + tmpPath);
+        size_t written = 0;
+        auto put = [&](const void *data, size_t bytes) {
+            file.write(static_cast<const char *>(data), std::streamsize(bytes));
+            written += bytes;
+        };
+        auto pad = [&]() {
+            static const char zeros[kMeshCacheAlignment] = {};
+            put(zeros, align(written) - written);
+        };
+        put(&header, sizeof(header));
+        put(meshTable.data(), meshTable.size() * sizeof(MeshRecord));
+        put(textureTable.data(), textureTable.size() * sizeof(TextureRecord));
+        put(lodTable.data(), lodTable.size() * sizeof(MeshCacheLod));
+        put(strings.data(), strings.size());
+        for (const auto &mesh : meshes_) {
+            pad();
+            put(mesh.vertices.data(), mesh.vertices.size());
+            pad();
+            put(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+        }
+        if (!file)
+            throw std::runtime_error("MeshCacheWriter: failed to write " + tmpPath);
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("MeshCacheWriter: cannot rename " + tmpPath + " to " + path);
+}
+
+bool MappedMeshCache::open(const std::string &path, const std::string &sourcePath, uint32_t vertexStride) {
+    close();
+    error_.clear();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error_ = "no cache file";
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(Header)) {
+        ::close(fd);
+        error_ = "truncated";
+        return false;
+    }
+    void *map = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file alive
+    if (map == MAP_FAILED) {
+        error_ = "mmap failed";
+        return false;
+    }
+    data_ = static_cast<const uint8_t *>(map);
+    size_ = size_t(info.st_size);
+    madvise(map, size_, MADV_WILLNEED);
+
+    const Header &header = *reinterpret_cast<const Header *>(data_);
+    uint64_t sourceSize;
+    int64_t sourceMTime;
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0) error_ = "not a mesh cache";
+    else if (header.version != kMeshCacheVersion) error_ = "version " + std::to_string(header.version);
+    else if (header.vertexStride != vertexStride) error_ = "vertex stride " + std::to_string(header.vertexStride);
+    else if (header.fileSize != size_) error_ = "truncated";
+    else if (!sourceStamp(sourcePath, sourceSize, sourceMTime)) error_ = "cannot stat " + sourcePath;
+    else if (sourceSize != header.sourceSize || sourceMTime != header.sourceMTime) error_ = "stale";
+    else if (header.meshTable + uint64_t(header.numMeshes) * sizeof(MeshRecord) > size_ ||
+             header.textureTable + uint64_t(header.numTextures) * sizeof(TextureRecord) > size_ ||
+             header.lodTable + uint64_t(header.numLods) * sizeof(MeshCacheLod) > size_ ||
+             header.strings > size_)
+        error_ = "corrupt tables";
+    else {
+        const MeshRecord *meshes = reinterpret_cast<const MeshRecord *>(data_ + header.meshTable);
+        for (uint32_t i = 0; i < header.numMeshes && error_.empty(); ++i)
+            if (meshes[i].vertexOffset + uint64_t(meshes[i].numVertices) * vertexStride > size_ ||
+                meshes[i].indexOffset + uint64_t(meshes[i].numIndices) * sizeof(uint32_t) > size_ ||
+                uint64_t(meshes[i].firstTexture) + meshes[i].numTextures > header.numTextures ||
+                uint64_t(meshes[i].firstLod) + meshes[i].numLods > header.numLods)
+                error_ = "corrupt mesh " + std::to_string(i);
+        if (error_.empty()) return true;
+    }
+    close();
+    return false;
+}
+
+void MappedMeshCache::close() {
+    if (data_) munmap(const_cast<uint8_t *>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+}
+
+size_t MappedMeshCache::numMeshes() const {
+    return data_ ? reinterpret_cast<const Header *>(data_)->numMeshes : 0;
+}
+
+MappedMeshCache::MeshView MappedMeshCache::mesh(size_t i) const {
+    const Header &header = *reinterpret_cast<const Header *>(data_);
+    const MeshRecord &record = reinterpret_cast<const MeshRecord *>(data_ + header.meshTable)[i];
+    const TextureRecord *textures = reinterpret_cast<const TextureRecord *>(data_ + header.textureTable);
+    const char *strings = reinterpret_cast<const char *>(data_ + header.strings);
+    MeshView view{data_ + record.vertexOffset, record.numVertices,
+                  reinterpret_cast<const uint32_t *>(data_ + record.indexOffset), record.numIndices, {}, {}};
+    for (uint32_t t = 0; t < record.numTextures; ++t) {
+        const TextureRecord &texture = textures[record.firstTexture + t];
+        view.textures.push_back({strings + texture.name, strings + texture.path});
+    }
+    const MeshCacheLod *lods = reinterpret_cast<const MeshCacheLod *>(data_ + header.lodTable);
+    view.lods.assign(lods + record.firstLod, lods + record.firstLod + record.numLods);
+    return view;
+}
+
+const float *MappedMeshCache::bounds() const {
+    return data_ ? reinterpret_cast<const Header *>(data_)->bounds : nullptr;
+}
+
+uint32_t MappedMeshCache::flags() const {
+    return data_ ? reinterpret_cast<const Header *>(data_)->flags : 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace SC {
+    /**
+     Binary mesh container written after the first import of a model and memory-mapped on later loads.
+
+     Layout: header, mesh table, texture table, LOD table, string table, then the vertex and index blobs, each aligned to
+     kMeshCacheAlignment so they can be passed to glBufferData straight from the mapping. The header records the
+     size and modification time of the source file, the vertex stride and the format version; a mismatch in any
+     of them makes the cache stale.
+     */
+    constexpr uint32_t kMeshCacheVersion = 3;
+    constexpr size_t kMeshCacheAlignment = 64;
+
+    struct MeshCacheTexture {
+        std::string name; // sampler name, e.g. texture_diffuse
+        std::string path; // relative to the model directory
+    };
+
+    /// A level of detail: a range of the mesh's index blob.
+    struct MeshCacheLod {
+        uint32_t indexOffset;
+        uint32_t indexCount;
+        float error; // model units
+    };
+
+    class MeshCacheWriter {
+    public:
+        explicit MeshCacheWriter(uint32_t vertexStride) : stride_(vertexStride) {}
+
+        /// The data is copied. indices holds all levels of detail, lods their ranges (may be empty).
+        void addMesh(const void *vertices, uint32_t numVertices, const uint32_t *indices, uint32_t numIndices,
+                     const std::vector<MeshCacheTexture> &textures, const std::vector<MeshCacheLod> &lods = {});
+        void setBounds(const float bounds[6]) { std::copy(bounds, bounds + 6, bounds_); }
+        void setFlags(uint32_t flags) { flags_ = flags; }
+
+        /// Writes to a temporary file and renames it, so a reader never maps a partial file. Throws on I/O errors.
+        void write(const std::string &path, const std::string &sourcePath) const;
+
+    private:
+        struct Mesh {
+            std::vector<uint8_t> vertices;
+            std::vector<uint32_t> indices;
+            std::vector<MeshCacheTexture> textures;
+            std::vector<MeshCacheLod> lods;
+        };
+        uint32_t stride_;
+        std::vector<Mesh> meshes_;
+        float bounds_[6] = {0, 0, 0, 0, 0, 0}; // min xyz, max xyz
+        uint32_t flags_ = 0;
+    };
+
+    class MappedMeshCache {
+    public:
+        struct MeshView {
+            const void *vertices;
+            uint32_t numVertices;
+            const uint32_t *indices;
+            uint32_t numIndices;
+            std::vector<MeshCacheTexture> textures;
+            std::vector<MeshCacheLod> lods;
+        };
+
+        MappedMeshCache() = default;
+        ~MappedMeshCache() { close(); }
+        MappedMeshCache(const MappedMeshCache &) = delete;
+        MappedMeshCache &operator=(const MappedMeshCache &) = delete;
+
+        /// False if the cache is missing, corrupt or stale for sourcePath. The reason is kept in error().
+        bool open(const std::string &path, const std::string &sourcePath, uint32_t vertexStride);
+        void close();
+
+        size_t numMeshes() const;
+        MeshView mesh(size_t i) const;
+        const float *bounds() const;
+        uint32_t flags() const;
+        size_t fileSize() const { return size_; }
+        const std::string &error() const { return error_; }
+
+    private:
+        const uint8_t *data_ = nullptr;
+        size_t size_ = 0;
+        std::string error_;
+    };
+}
@@ -0,0 +1,283 @@
+#include "mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+using namespace SC;
+
+namespace {
+    struct VertexHasher {
+        const uint8_t *vertices;
+        size_t stride;
+        size_t operator()(uint32_t v) const {
+            // FNV-1a over the vertex bytes
+            const uint8_t *p = vertices + size_t(v) * stride;
+            uint64_t hash = 14695981039346656037ull;
+            for (size_t i = 0; i < stride; ++i) {
+                hash ^= p[i];
+                hash *= 1099511628211ull;
+            }
+            return size_t(hash);
+        }
+    };
+
+    struct VertexEqual {
+        const uint8_t *vertices;
+        size_t stride;
+        bool operator()(uint32_t a, uint32_t b) const {
+            return std::memcmp(vertices + size_t(a) * stride, vertices + size_t(b) * stride, stride) == 0;
+        }
+    };
+
+    // Forsyth, "Linear-Speed Vertex Cache Optimisation", 2006
+    const int kCacheSize = 32;
+    const float kCacheDecayPower = 1.5f;
+    const float kLastTriScore = 0.75f;
+    const float kValenceBoostScale = 2.f;
+    const float kValenceBoostPower = 0.5f;
+
+    struct ScoreTable {
+        float cache[kCacheSize];
+        float valence[64];
+        ScoreTable() {
+            for (int i = 0; i < kCacheSize; ++i) {
+                if (i < 3) cache[i] = kLastTriScore;
+                else cache[i] = std::pow(1.f - float(i - 3) / (kCacheSize - 3), kCacheDecayPower);
+            }
+            valence[0] = 0;
+            for (int i = 1; i < 64; ++i) valence[i] = kValenceBoostScale * std::pow(float(i), -kValenceBoostPower);
+        }
+    };
+
+    float vertexScore(const ScoreTable &table, int cachePosition, uint32_t liveTriangles) {
+        if (liveTriangles == 0) return -1.f;
+        const float score = cachePosition < 0 ? 0.f : table.cache[cachePosition];
+        return score + table.valence[std::min<uint32_t>(liveTriangles, 63)];
+    }
+
+    const float *position(const void *vertices, size_t stride, uint32_t v) {
+        return reinterpret_cast<const float *>(static_cast<const uint8_t *>(vertices) + size_t(v) * stride);
+    }
+}
+
+size_t SC::GenerateVertexRemap(uint32_t *remap, const uint32_t *indices, size_t numIndices,
+                               const void *vertices, size_t numVertices, size_t stride) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(vertices);
+    std::fill(remap, remap + numVertices, ~0u);
+    std::unordered_map<uint32_t, uint32_t, VertexHasher, VertexEqual> unique(
+            numVertices, VertexHasher{bytes, stride}, VertexEqual{bytes, stride});
+    uint32_t next = 0;
+    for (size_t i = 0; i < numIndices; ++i) {
+        const uint32_t v = indices ? indices[i] : uint32_t(i);
+        if (remap[v] != ~0u) continue;
+        auto inserted = unique.emplace(v, next);
+        remap[v] = inserted.first->second;
+        if (inserted.second) next++;
+    }
+    return next;
+}
+
+void SC::RemapVertices(void *dst, const void *vertices, size_t numVertices, size_t stride, const uint32_t *remap) {
+    const uint8_t *src = static_cast<const uint8_t *>(vertices);
+    uint8_t *out = static_cast<uint8_t *>(dst);
+    for (size_t v = 0; v < numVertices; ++v)
+        if (remap[v] != ~0u) std::memcpy(out + size_t(remap[v]) * stride, src + v * stride, stride);
+}
+
+void SC::RemapIndices(uint32_t *dst, const uint32_t *indices, size_t numIndices, const uint32_t *remap) {
+    for (size_t i = 0; i < numIndices; ++i) dst[i] = remap[indices ? indices[i] : uint32_t(i)];
+}
+
+void SC::OptimizeVertexCache(uint32_t *dst, const uint32_t *indices, size_t numIndices, size_t numVertices) {
+    static const ScoreTable table;
+    const size_t numTriangles = numIndices / 3;
+
+    // vertex -> triangle adjacency (CSR)
+    std::vector<uint32_t> offsets(numVertices + 1, 0), live(numVertices, 0);
+    for (size_t i = 0; i < numTriangles * 3; ++i) live[indices[i]]++;
+    for (size_t v = 0; v < numVertices; ++v) offsets[v + 1] = offsets[v] + live[v];
+    std::vector<uint32_t> adjacency(offsets[numVertices]), cursor(offsets.begin(), offsets.end() - 1);
+    for (size_t t = 0; t < numTriangles; ++t)
+        for (int k = 0; k < 3; ++k) adjacency[cursor[indices[t * 3 + k]]++] = uint32_t(t);
+
+    std::vector<float> vScore(numVertices), tScore(numTriangles);
+    std::vector<char> emitted(numTriangles, 0);
+    for (size_t v = 0; v < numVertices; ++v) vScore[v] = vertexScore(table, -1, live[v]);
+    for (size_t t = 0; t < numTriangles; ++t)
+        tScore[t] = vScore[indices[t * 3]] + vScore[indices[t * 3 + 1]] + vScore[indices[t * 3 + 2]];
+
+    uint32_t cache[kCacheSize + 3];
+    int cacheCount = 0;
+    size_t input = 0; // first triangle that may not be emitted yet, for restarts
+    size_t best = numTriangles;
+    float bestScore = -1;
+    for (size_t t = 0; t < numTriangles; ++t)
+        if (tScore[t] > bestScore) bestScore = tScore[best = t];
+
+    for (size_t out = 0; out < numTriangles; ++out) {
+        if (best == numTriangles) {
+            // nothing adjacent to the cache: continue with the next triangle in input order
+            while (emitted[input]) input++;
+            best = input;
+        }
+        const uint32_t *tri = indices + best * 3;
+        std::copy(tri, tri + 3, dst + out * 3);
+        emitted[best] = 1;
+
+        // remove the triangle from its vertices' live lists
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t v = tri[k];
+            uint32_t *begin = &adjacency[offsets[v]], *end = begin + live[v];
+            std::iter_swap(std::find(begin, end, uint32_t(best)), end - 1);
+            live[v]--;
+        }
+
+        // move the triangle's vertices to the front of the LRU cache
+        uint32_t next[kCacheSize + 3];
+        int nextCount = 0;
+        for (int k = 0; k < 3; ++k) next[nextCount++] = tri[k];
+        for (int i = 0; i < cacheCount; ++i)
+            if (cache[i] != tri[0] && cache[i] != tri[1] && cache[i] != tri[2]) next[nextCount++] = cache[i];
+        cacheCount = std::min(nextCount, kCacheSize);
+        std::copy(next, next + nextCount, cache);
+
+        // rescore the cached (and just evicted) vertices and their live triangles, pick the best one
+        best = numTriangles;
+        bestScore = -1;
+        for (int i = 0; i < nextCount; ++i) {
+            const uint32_t v = next[i];
+            const float score = vertexScore(table, i < kCacheSize ? i : -1, live[v]);
+            const float delta = score - vScore[v];
+            vScore[v] = score;
+            for (uint32_t a = offsets[v]; a < offsets[v] + live[v]; ++a) {
+                const uint32_t t = adjacency[a];
+                tScore[t] += delta;
+            }
+        }
+        for (int i = 0; i < cacheCount; ++i) {
+            const uint32_t v = cache[i];
+            for (uint32_t a = offsets[v]; a < offsets[v] + live[v]; ++a) {
+                const uint32_t t = adjacency[a];
+                if (tScore[t] > bestScore) bestScore = tScore[best = t];
+            }
+        }
+    }
+}
+
+void SC::OptimizeOverdraw(uint32_t *dst, const uint32_t *indices, size_t numIndices, const void *vertices,
+                          size_t numVertices, size_t stride, float threshold) {
+    const size_t numTriangles = numIndices / 3;
+    if (numTriangles == 0) return;
+    const size_t cacheSize = 16, kMinClusterTriangles = 64;
+
+    // Split into clusters wherever the cluster so far is not worse than threshold times the whole mesh, so
+    // moving it costs little cache efficiency. A forced split happens where the cache restarts anyway.
+    const float meshAcmr = AnalyzeVertexCache(indices, numIndices, numVertices, cacheSize).acmr;
+    std::vector<uint32_t> timestamp(numVertices, 0);
+    uint32_t time = cacheSize + 1;
+    std::vector<size_t> clusters{0};
+    size_t misses = 0;
+    for (size_t t = 0; t < numTriangles; ++t) {
+        int triMisses = 0;
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t v = indices[t * 3 + k];
+            if (time - timestamp[v] > cacheSize) {
+                timestamp[v] = time++;
+                triMisses++;
+            }
+        }
+        const size_t clusterTriangles = t - clusters.back();
+        if (clusterTriangles > 0 && (triMisses == 3 || (clusterTriangles >= kMinClusterTriangles &&
+                                                        float(misses) / clusterTriangles <= meshAcmr * threshold))) {
+            clusters.push_back(t);
+            misses = 0;
+        }
+        misses += triMisses;
+    }
+    clusters.push_back(numTriangles);
+
+    // Mesh centroid and, per cluster, area weighted centroid and normal
+    double center[3] = {0, 0, 0};
+    double totalArea = 0;
+    std::vector<float> sortKey(clusters.size() - 1);
+    std::vector<float> clusterData((clusters.size() - 1) * 7, 0.f); // centroid * area, normal, area
+    for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+        float *data = &clusterData[c * 7];
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+            const float *p0 = position(vertices, stride, indices[t * 3]);
+            const float *p1 = position(vertices, stride, indices[t * 3 + 1]);
+            const float *p2 = position(vertices, stride, indices[t * 3 + 2]);
+            const float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            const float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            const float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2],
+                                e1[0] * e2[1] - e1[1] * e2[0]};
+            const float area = 0.5f * std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; ++k) {
+                data[k] += area * (p0[k] + p1[k] + p2[k]) / 3.f;
+                data[3 + k] += n[k]; // |n| = 2 * area
+            }
+            data[6] += area;
+        }
+        for (int k = 0; k < 3; ++k) center[k] += data[k];
+        totalArea += data[6];
+    }
+    for (int k = 0; k < 3; ++k) center[k] = totalArea > 0 ? center[k] / totalArea : 0;
+    for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+        const float *data = &clusterData[c * 7];
+        const float area = std::max(data[6], 1e-20f);
+        float key = 0;
+        for (int k = 0; k < 3; ++k) key += (data[k] / area - float(center[k])) * data[3 + k];
+        sortKey[c] = key;
+    }
+
+    std::vector<size_t> order(clusters.size() - 1);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+    size_t out = 0;
+    for (size_t c : order) {
+        const size_t begin = clusters[c] * 3, end = clusters[c + 1] * 3;
+        std::copy(indices + begin, indices + end, dst + out);
+        out += end - begin;
+    }
+}
+
+size_t SC::OptimizeVertexFetch(void *dst, uint32_t *indices, size_t numIndices, const void *vertices,
+                               size_t numVertices, size_t stride) {
+    std::vector<uint32_t> remap(numVertices, ~0u);
+    const uint8_t *src = static_cast<const uint8_t *>(vertices);
+    uint8_t *out = static_cast<uint8_t *>(dst);
+    uint32_t next = 0;
+    for (size_t i = 0; i < numIndices; ++i) {
+        uint32_t &r = remap[indices[i]];
+        if (r == ~0u) {
+            std::memcpy(out + size_t(next) * stride, src + size_t(indices[i]) * stride, stride);
+            r = next++;
+        }
+        indices[i] = r;
+    }
+    return next;
+}
+
+VertexCacheStatistics SC::AnalyzeVertexCache(const uint32_t *indices, size_t numIndices, size_t numVertices,
+                                             size_t cacheSize) {
+    std::vector<uint32_t> timestamp(numVertices, 0);
+    uint32_t time = uint32_t(cacheSize) + 1;
+    size_t misses = 0, used = 0;
+    std::vector<char> seen(numVertices, 0);
+    for (size_t i = 0; i < numIndices; ++i) {
+        const uint32_t v = indices[i];
+        if (time - timestamp[v] > cacheSize) {
+            timestamp[v] = time++;
+            misses++;
+        }
+        if (!seen[v]) {
+            seen[v] = 1;
+            used++;
+        }
+    }
+    return {numIndices ? float(misses) / (numIndices / 3) : 0.f, used ? float(misses) / used : 0.f};
+}
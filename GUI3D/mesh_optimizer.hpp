@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SC {
+    /**
+     Load-time mesh optimization. Vertices are opaque blobs of `stride` bytes; positions, where needed, are three
+     floats at the start of each vertex. The usual order is
+
+        1. GenerateVertexRemap + RemapVertices/RemapIndices  (weld bitwise identical vertices)
+        2. OptimizeVertexCache                               (triangle order for the post-transform cache)
+        3. OptimizeOverdraw                                  (cluster order, front-facing clusters first)
+        4. OptimizeVertexFetch                               (vertex order = first use)
+
+     and the result fits 16-bit indices when at most 65536 vertices remain (FitsIndex16).
+     */
+
+    /**
+     @param indices May be null for a non-indexed triangle soup, then numIndices == numVertices.
+     @param remap numVertices entries: the new index of every vertex. Unreferenced vertices get ~0u.
+     @return Number of unique vertices.
+     */
+    size_t GenerateVertexRemap(uint32_t *remap, const uint32_t *indices, size_t numIndices,
+                               const void *vertices, size_t numVertices, size_t stride);
+    /// dst holds the unique vertex count returned by GenerateVertexRemap.
+    void RemapVertices(void *dst, const void *vertices, size_t numVertices, size_t stride, const uint32_t *remap);
+    /// indices may be null (soup). dst may alias indices.
+    void RemapIndices(uint32_t *dst, const uint32_t *indices, size_t numIndices, const uint32_t *remap);
+
+    /// Forsyth's linear-speed vertex cache optimization. dst must not alias indices.
+    void OptimizeVertexCache(uint32_t *dst, const uint32_t *indices, size_t numIndices, size_t numVertices);
+
+    /**
+     Cuts a cache-optimized triangle order into clusters at cache restarts and sorts the clusters so that the
+     ones facing away from the mesh center, i.e. likely occluders, come first (Sander et al. 2007).
+     @param threshold A cluster may end once its ACMR is within threshold times the mesh's. Larger values give
+                      more, smaller clusters: less overdraw, more vertex shading.
+     dst must not alias indices.
+     */
+    void OptimizeOverdraw(uint32_t *dst, const uint32_t *indices, size_t numIndices, const void *vertices,
+                          size_t numVertices, size_t stride, float threshold = 1.05f);
+
+    /// Reorders the vertices by first use and rewrites indices in place. Returns the number of used vertices.
+    size_t OptimizeVertexFetch(void *dst, uint32_t *indices, size_t numIndices, const void *vertices,
+                               size_t numVertices, size_t stride);
+
+    struct VertexCacheStatistics {
+        float acmr; // vertex shader invocations per triangle, 0.5 is ideal for a regular grid, 3 the worst
+        float atvr; // invocations per vertex, 1 is ideal
+    };
+    /// Simulates a FIFO post-transform cache of cacheSize entries.
+    VertexCacheStatistics AnalyzeVertexCache(const uint32_t *indices, size_t numIndices, size_t numVertices,
+                                             size_t cacheSize = 16);
+
+    inline bool FitsIndex16(size_t numVertices) { return numVertices <= 65536; }
+}
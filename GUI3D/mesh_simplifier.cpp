@@ -0,0 +1,222 @@
+#include "mesh_simplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+using namespace SC;
+
+namespace {
+    struct Quadric {
+        double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0, b0 = 0, b1 = 0, b2 = 0, c = 0;
+
+        void addPlane(const double n[3], double d, double weight) {
+            a00 += weight * n[0] * n[0]; a01 += weight * n[0] * n[1]; a02 += weight * n[0] * n[2];
+            a11 += weight * n[1] * n[1]; a12 += weight * n[1] * n[2]; a22 += weight * n[2] * n[2];
+            b0 += weight * n[0] * d; b1 += weight * n[1] * d; b2 += weight * n[2] * d;
+            c += weight * d * d;
+        }
+        void add(const Quadric &q) {
+            a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2; c += q.c;
+        }
+        /// Sum of weighted squared distances of p to the planes.
+        double error(const float *p) const {
+            const double x = p[0], y = p[1], z = p[2];
+            const double e = a00 * x * x + a11 * y * y + a22 * z * z + 2 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+                             2 * (b0 * x + b1 * y + b2 * z) + c;
+            return std::max(e, 0.0);
+        }
+    };
+
+    struct Collapse {
+        uint32_t from, to;
+        double cost;
+    };
+
+    const float *position(const uint8_t *vertices, size_t stride, uint32_t v) {
+        return reinterpret_cast<const float *>(vertices + size_t(v) * stride);
+    }
+
+    void triangleNormal(const float *p0, const float *p1, const float *p2, double n[3]) {
+        const double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        const double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+        n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+        n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+    }
+
+    struct PositionHasher {
+        const uint8_t *vertices;
+        size_t stride;
+        size_t operator()(uint32_t v) const {
+            uint32_t bits[3];
+            std::memcpy(bits, position(vertices, stride, v), sizeof(bits));
+            return size_t(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+        }
+    };
+
+    struct PositionEqual {
+        const uint8_t *vertices;
+        size_t stride;
+        bool operator()(uint32_t a, uint32_t b) const {
+            return std::memcmp(position(vertices, stride, a), position(vertices, stride, b), 3 * sizeof(float)) == 0;
+        }
+    };
+}
+
+size_t SC::SimplifyMesh(uint32_t *dst, const uint32_t *indices, size_t numIndices, const void *vertexData,
+                        size_t numVertices, size_t stride, size_t targetIndexCount, float targetError,
+                        float *resultError) {
+    const uint8_t *vertices = static_cast<const uint8_t *>(vertexData);
+    std::vector<uint32_t> result(indices, indices + numIndices);
+    float maxError = 0;
+
+    // Lock seam vertices: more than one vertex at the same position
+    std::vector<char> locked(numVertices, 0);
+    {
+        std::unordered_map<uint32_t, uint32_t, PositionHasher, PositionEqual> first(
+                numVertices, PositionHasher{vertices, stride}, PositionEqual{vertices, stride});
+        for (uint32_t v = 0; v < numVertices; ++v) {
+            auto inserted = first.emplace(v, v);
+            if (!inserted.second) locked[v] = locked[inserted.first->second] = 1;
+        }
+    }
+    // Lock border vertices: an edge used by one triangle only. An edge (a, b) is matched by its reverse (b, a).
+    {
+        std::unordered_map<uint64_t, int> edges(numIndices);
+        for (size_t i = 0; i < numIndices; i += 3)
+            for (int k = 0; k < 3; ++k) {
+                const uint64_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+                edges[a << 32 | b]++;
+            }
+        for (const auto &edge : edges) {
+            const uint64_t a = edge.first >> 32, b = edge.first & 0xffffffffu;
+            if (edges.find(b << 32 | a) == edges.end()) locked[a] = locked[b] = 1;
+        }
+    }
+
+    // Area weighted plane quadrics
+    std::vector<Quadric> quadrics(numVertices);
+    for (size_t i = 0; i < numIndices; i += 3) {
+        const float *p0 = position(vertices, stride, indices[i]);
+        double n[3];
+        triangleNormal(p0, position(vertices, stride, indices[i + 1]), position(vertices, stride, indices[i + 2]), n);
+        const double length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length == 0) continue;
+        for (double &x : n) x /= length;
+        const double d = -(n[0] * p0[0] + n[1] * p0[1] + n[2] * p0[2]);
+        for (int k = 0; k < 3; ++k) quadrics[indices[i + k]].addPlane(n, d, length * 0.5);
+    }
+
+    const double maxCost = double(targetError) * targetError;
+    std::vector<uint32_t> remap(numVertices), offsets(numVertices + 1), adjacency;
+    std::vector<char> touched(numVertices);
+    std::vector<Collapse> candidates;
+    while (result.size() > targetIndexCount) {
+        // vertex -> triangle adjacency of the current mesh
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (uint32_t v : result) offsets[v + 1]++;
+        for (size_t v = 0; v < numVertices; ++v) offsets[v + 1] += offsets[v];
+        adjacency.resize(result.size());
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < result.size(); ++i) adjacency[cursor[result[i]]++] = uint32_t(i / 3);
+
+        // cheapest direction of every edge, the error measured by the summed quadric at the kept vertex
+        candidates.clear();
+        for (size_t i = 0; i < result.size(); i += 3)
+            for (int k = 0; k < 3; ++k) {
+                const uint32_t a = result[i + k], b = result[i + (k + 1) % 3];
+                if (a > b && !locked[a] && !locked[b]) continue; // the other half-edge adds it
+                Collapse best{0, 0, std::numeric_limits<double>::max()};
+                for (int dir = 0; dir < 2; ++dir) {
+                    const uint32_t from = dir ? b : a, to = dir ? a : b;
+                    if (locked[from]) continue;
+                    Quadric q = quadrics[from];
+                    q.add(quadrics[to]);
+                    const double cost = q.error(position(vertices, stride, to));
+                    if (cost < best.cost) best = {from, to, cost};
+                }
+                if (best.cost <= maxCost) candidates.push_back(best);
+            }
+        if (candidates.empty()) break;
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Collapse &x, const Collapse &y) { return x.cost < y.cost; });
+
+        for (uint32_t v = 0; v < numVertices; ++v) remap[v] = v;
+        std::fill(touched.begin(), touched.end(), 0);
+        size_t remaining = result.size() / 3, collapsed = 0;
+        const size_t targetTriangles = targetIndexCount / 3;
+        for (const Collapse &collapse : candidates) {
+            if (remaining <= targetTriangles) break;
+            if (touched[collapse.from] || touched[collapse.to]) continue;
+
+            // reject collapses that flip or squash a triangle around the moved vertex
+            const float *target = position(vertices, stride, collapse.to);
+            bool valid = true;
+            int removed = 0;
+            for (uint32_t a = offsets[collapse.from]; a < offsets[collapse.from + 1] && valid; ++a) {
+                const uint32_t *tri = &result[size_t(adjacency[a]) * 3];
+                if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to) {
+                    removed++;
+                    continue;
+                }
+                const float *p[3], *q[3];
+                for (int k = 0; k < 3; ++k) {
+                    p[k] = position(vertices, stride, tri[k]);
+                    q[k] = tri[k] == collapse.from ? target : p[k];
+                }
+                double before[3], after[3];
+                triangleNormal(p[0], p[1], p[2], before);
+                triangleNormal(q[0], q[1], q[2], after);
+                const double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+                const double lengths = std::sqrt((before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+                                                 (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]));
+                valid = dot > 0.25 * lengths; // at most ~75 degrees of rotation
+            }
+            if (!valid) continue;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            maxError = std::max(maxError, float(std::sqrt(collapse.cost)));
+            remaining -= removed;
+            collapsed++;
+            // the fan of the moved vertex changed: freeze it for the rest of this pass
+            for (uint32_t a = offsets[collapse.from]; a < offsets[collapse.from + 1]; ++a)
+                for (int k = 0; k < 3; ++k) touched[result[size_t(adjacency[a]) * 3 + k]] = 1;
+        }
+        if (collapsed == 0) break;
+
+        size_t out = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            const uint32_t a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+            if (a == b || b == c || a == c) continue;
+            result[out++] = a;
+            result[out++] = b;
+            result[out++] = c;
+        }
+        result.resize(out);
+    }
+
+    std::copy(result.begin(), result.end(), dst);
+    if (resultError) *resultError = maxError;
+    return result.size();
+}
+
+int SC::SelectLod(const float *errors, int numLods, float pixelsPerUnit, int current, float thresholdPixels,
+                  float hysteresis) {
+    int target = 0;
+    for (int i = numLods - 1; i > 0; --i)
+        if (errors[i] * pixelsPerUnit <= thresholdPixels) {
+            target = i;
+            break;
+        }
+    if (target <= current) return target; // finer, or the same level
+    // coarser: only as far as the tighter threshold allows
+    for (int i = target; i > current; --i)
+        if (errors[i] * pixelsPerUnit <= thresholdPixels * (1.f - hysteresis)) return i;
+    return current;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SC {
+    /**
+     Quadric error edge collapse (Garland and Heckbert 1997) restricted to collapsing a vertex onto one of its
+     neighbours, so every level of detail indexes the original vertex buffer and only the index buffer grows.
+
+     Vertices on open borders and on attribute seams (several vertices at one position) are never moved, which
+     keeps the silhouette of open meshes and the UV layout intact.
+
+     Positions are the first three floats of each vertex.
+     @param targetIndexCount Stop once at most this many indices remain.
+     @param targetError Largest allowed distance of a collapsed vertex to the original surface, in model units.
+     @param resultError If not null, the largest error of the applied collapses.
+     @return Number of indices written to dst, which must hold numIndices. dst may alias indices.
+     */
+    size_t SimplifyMesh(uint32_t *dst, const uint32_t *indices, size_t numIndices, const void *vertices,
+                        size_t numVertices, size_t stride, size_t targetIndexCount, float targetError,
+                        float *resultError = nullptr);
+
+    /**
+     Coarsest level whose error, projected to pixelsPerUnit, stays within thresholdPixels. Levels are ordered from
+     fine to coarse with increasing errors. A coarser level than current is only taken once its error is below
+     (1 - hysteresis) of the threshold, so an object at the switching distance does not flicker between levels.
+     */
+    int SelectLod(const float *errors, int numLods, float pixelsPerUnit, int current, float thresholdPixels = 1.f,
+                  float hysteresis = 0.25f);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace SC {
+    /**
+     Bounded lock-free queue for any number of producer and consumer threads (D. Vyukov's design): every cell
+     carries a sequence number that tells producers and consumers whose turn it is, so the only contention is
+     one compare-and-swap on the shared position. Used where several producers feed one consumer. The capacity
+     is rounded up to a power of two; push fails instead of blocking when the queue is full.
+     */
+    template <typename T>
+    class MpmcQueue {
+    public:
+        explicit MpmcQueue(size_t capacity = 256) : cells_(roundUp(capacity)), mask_(cells_.size() - 1),
+                                                    enqueue_(0), dequeue_(0) {
+            for (size_t i = 0; i < cells_.size(); ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        bool push(T item) {
+            size_t pos = enqueue_.load(std::memory_order_relaxed);
+            Cell *cell;
+            while (true) {
+                cell = &cells_[pos & mask_];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const std::ptrdiff_t diff = std::ptrdiff_t(sequence) - std::ptrdiff_t(pos);
+                if (diff == 0) {
+                    if (enqueue_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                } else if (diff < 0) {
+                    return false; // full
+                } else {
+                    pos = enqueue_.load(std::memory_order_relaxed);
+                }
+            }
+            cell->item = std::move(item);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T &item) {
+            size_t pos = dequeue_.load(std::memory_order_relaxed);
+            Cell *cell;
+            while (true) {
+                cell = &cells_[pos & mask_];
+                const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+                const std::ptrdiff_t diff = std::ptrdiff_t(sequence) - std::ptrdiff_t(pos + 1);
+                if (diff == 0) {
+                    if (dequeue_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+                } else if (diff < 0) {
+                    return false; // empty
+                } else {
+                    pos = dequeue_.load(std::memory_order_relaxed);
+                }
+            }
+            item = std::move(cell->item);
+            cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+            return true;
+        }
+
+        size_t capacity() const { return mask_ + 1; }
+
+    private:
+        struct Cell {
+            std::atomic<size_t> sequence;
+            T item;
+            Cell() : sequence(0), item() {}
+            Cell(Cell &&o) noexcept : sequence(o.sequence.load()), item(std::move(o.item)) {}
+        };
+        static size_t roundUp(size_t capacity) {
+            size_t size = 2;
+            while (size < capacity) size <<= 1;
+            return size;
+        }
+
+        std::vector<Cell> cells_;
+        const size_t mask_;
+        alignas(64) std::atomic<size_t> enqueue_;
+        alignas(64) std::atomic<size_t> dequeue_;
+    };
+}
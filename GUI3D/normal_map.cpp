@@ -0,0 +1,231 @@
+#include "normal_map.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "simd_xyz.hpp"
+#if defined(SC_SIMD_WITH_SSE)
+#define NORMALMAP_WITH_SSE
+#endif
+#if defined(SC_SIMD_WITH_AVX2)
+#define NORMALMAP_WITH_AVX2
+#endif
+
+using namespace SC;
+using namespace SC::simd;
+
+namespace {
+    /// Computes pixels [xBegin, xEnd) of row y. The caller guarantees 1 <= xBegin, xEnd <= width - 1 and 1 <= y < height - 1.
+    inline void normalRowScalar(int width, int y, int xBegin, int xEnd, const float *vertexMap, float *normalMap) {
+        for (int x = xBegin; x < xEnd; ++x) {
+            const int idx = y * width + x;
+            const float *left = vertexMap + (idx - 1) * 3;
+            const float *right = vertexMap + (idx + 1) * 3;
+            const float *upper = vertexMap + (idx - width) * 3;
+            const float *lower = vertexMap + (idx + width) * 3;
+            float *normal = normalMap + idx * 3;
+
+            if (left[2] == 0 || right[2] == 0 || upper[2] == 0 || lower[2] == 0) {
+                normal[0] = normal[1] = normal[2] = 0;
+                continue;
+            }
+            const float hx = left[0] - right[0], hy = left[1] - right[1], hz = left[2] - right[2];
+            const float vx = upper[0] - lower[0], vy = upper[1] - lower[1], vz = upper[2] - lower[2];
+            float nx = hy * vz - hz * vy;
+            float ny = hz * vx - hx * vz;
+            float nz = hx * vy - hy * vx;
+            const float inv = 1.f / std::sqrt(nx * nx + ny * ny + nz * nz);
+            nx *= inv;
+            ny *= inv;
+            nz *= inv;
+            if (nz > 0) {
+                nx = -nx;
+                ny = -ny;
+                nz = -nz;
+            }
+            normal[0] = nx;
+            normal[1] = ny;
+            normal[2] = nz;
+        }
+    }
+
+#ifdef NORMALMAP_WITH_SSE
+    inline void normalRowSSE(int width, int y, int xBegin, int xEnd, const float *vertexMap, float *normalMap) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 signBit = _mm_set1_ps(-0.f);
+        int x = xBegin;
+        for (; x + 4 <= xEnd; x += 4) {
+            const int idx = y * width + x;
+            __m128 lx, ly, lz, rx, ry, rz, ux, uy, uz, dx, dy, dz;
+            load4(vertexMap + (idx - 1) * 3, lx, ly, lz);
+            load4(vertexMap + (idx + 1) * 3, rx, ry, rz);
+            load4(vertexMap + (idx - width) * 3, ux, uy, uz);
+            load4(vertexMap + (idx + width) * 3, dx, dy, dz);
+
+            const __m128 invalid = _mm_or_ps(_mm_or_ps(_mm_cmpeq_ps(lz, zero), _mm_cmpeq_ps(rz, zero)),
+                                             _mm_or_ps(_mm_cmpeq_ps(uz, zero), _mm_cmpeq_ps(dz, zero)));
+
+            const __m128 hx = _mm_sub_ps(lx, rx), hy = _mm_sub_ps(ly, ry), hz = _mm_sub_ps(lz, rz);
+            const __m128 vx = _mm_sub_ps(ux, dx), vy = _mm_sub_ps(uy, dy), vz = _mm_sub_ps(uz, dz);
+            __m128 nx = _mm_sub_ps(_mm_mul_ps(hy, vz), _mm_mul_ps(hz, vy));
+            __m128 ny = _mm_sub_ps(_mm_mul_ps(hz, vx), _mm_mul_ps(hx, vz));
+            __m128 nz = _mm_sub_ps(_mm_mul_ps(hx, vy), _mm_mul_ps(hy, vx));
+            const __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz));
+            const __m128 inv = _mm_div_ps(one, _mm_sqrt_ps(len2));
+            nx = _mm_mul_ps(nx, inv);
+            ny = _mm_mul_ps(ny, inv);
+            nz = _mm_mul_ps(nz, inv);
+
+            // flip towards the camera, then zero the invalid lanes
+            const __m128 flip = _mm_and_ps(_mm_cmpgt_ps(nz, zero), signBit);
+            nx = _mm_andnot_ps(invalid, _mm_xor_ps(nx, flip));
+            ny = _mm_andnot_ps(invalid, _mm_xor_ps(ny, flip));
+            nz = _mm_andnot_ps(invalid, _mm_xor_ps(nz, flip));
+            store4(normalMap + idx * 3, nx, ny, nz);
+        }
+        normalRowScalar(width, y, x, xEnd, vertexMap, normalMap);
+    }
+#endif
+
+#ifdef NORMALMAP_WITH_AVX2
+    inline void normalRowAVX2(int width, int y, int xBegin, int xEnd, const float *vertexMap, float *normalMap) {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.f);
+        const __m256 signBit = _mm256_set1_ps(-0.f);
+        int x = xBegin;
+        for (; x + 8 <= xEnd; x += 8) {
+            const int idx = y * width + x;
+            __m256 lx, ly, lz, rx, ry, rz, ux, uy, uz, dx, dy, dz;
+            load8(vertexMap + (idx - 1) * 3, lx, ly, lz);
+            load8(vertexMap + (idx + 1) * 3, rx, ry, rz);
+            load8(vertexMap + (idx - width) * 3, ux, uy, uz);
+            load8(vertexMap + (idx + width) * 3, dx, dy, dz);
+
+            const __m256 invalid = _mm256_or_ps(
+                    _mm256_or_ps(_mm256_cmp_ps(lz, zero, _CMP_EQ_OQ), _mm256_cmp_ps(rz, zero, _CMP_EQ_OQ)),
+                    _mm256_or_ps(_mm256_cmp_ps(uz, zero, _CMP_EQ_OQ), _mm256_cmp_ps(dz, zero, _CMP_EQ_OQ)));
+
+            const __m256 hx = _mm256_sub_ps(lx, rx), hy = _mm256_sub_ps(ly, ry), hz = _mm256_sub_ps(lz, rz);
+            const __m256 vx = _mm256_sub_ps(ux, dx), vy = _mm256_sub_ps(uy, dy), vz = _mm256_sub_ps(uz, dz);
+            __m256 nx = _mm256_sub_ps(_mm256_mul_ps(hy, vz), _mm256_mul_ps(hz, vy));
+            __m256 ny = _mm256_sub_ps(_mm256_mul_ps(hz, vx), _mm256_mul_ps(hx, vz));
+            __m256 nz = _mm256_sub_ps(_mm256_mul_ps(hx, vy), _mm256_mul_ps(hy, vx));
+            const __m256 len2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, nx), _mm256_mul_ps(ny, ny)),
+                                              _mm256_mul_ps(nz, nz));
+            const __m256 inv = _mm256_div_ps(one, _mm256_sqrt_ps(len2));
+            nx = _mm256_mul_ps(nx, inv);
+            ny = _mm256_mul_ps(ny, inv);
+            nz = _mm256_mul_ps(nz, inv);
+
+            const __m256 flip = _mm256_and_ps(_mm256_cmp_ps(nz, zero, _CMP_GT_OQ), signBit);
+            nx = _mm256_andnot_ps(invalid, _mm256_xor_ps(nx, flip));
+            ny = _mm256_andnot_ps(invalid, _mm256_xor_ps(ny, flip));
+            nz = _mm256_andnot_ps(invalid, _mm256_xor_ps(nz, flip));
+            store8(normalMap + idx * 3, nx, ny, nz);
+        }
+        normalRowSSE(width, y, x, xEnd, vertexMap, normalMap);
+    }
+#endif
+
+    typedef void (*RowFunction)(int, int, int, int, const float *, float *);
+
+    RowFunction selectRowFunction(NormalMapBackend backend) {
+        switch (backend) {
+            case NormalMapBackend::Scalar:
+                return normalRowScalar;
+#ifdef NORMALMAP_WITH_SSE
+            case NormalMapBackend::SSE:
+                return normalRowSSE;
+#endif
+#ifdef NORMALMAP_WITH_AVX2
+            case NormalMapBackend::AVX2:
+                return normalRowAVX2;
+#endif
+            case NormalMapBackend::Auto:
+#if defined(NORMALMAP_WITH_AVX2)
+                return normalRowAVX2;
+#elif defined(NORMALMAP_WITH_SSE)
+                return normalRowSSE;
+#else
+                return normalRowScalar;
+#endif
+            default:
+                throw std::runtime_error(std::string("ComputeNormalMap: backend ") + toString(backend) +
+                                         " is not compiled in.\n");
+        }
+    }
+}
+
+bool SC::isAvailable(NormalMapBackend backend) {
+    switch (backend) {
+        case NormalMapBackend::Auto:
+        case NormalMapBackend::Scalar:
+            return true;
+        case NormalMapBackend::SSE:
+#ifdef NORMALMAP_WITH_SSE
+            return true;
+#else
+            return false;
+#endif
+        case NormalMapBackend::AVX2:
+#ifdef NORMALMAP_WITH_AVX2
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char *SC::toString(NormalMapBackend backend) {
+    switch (backend) {
+        case NormalMapBackend::Auto: return "Auto";
+        case NormalMapBackend::Scalar: return "Scalar";
+        case NormalMapBackend::SSE: return "SSE";
+        case NormalMapBackend::AVX2: return "AVX2";
+    }
+    return "Unknown";
+}
+
+void SC::ComputeNormalMap(int width, int height, const float *vertexMap, float *normalMap,
+                          NormalMapBackend backend, int threads) {
+    if (width <= 0 || height <= 0) return;
+    RowFunction rowFunction = selectRowFunction(backend);
+
+    // Borders
+    std::memset(normalMap, 0, sizeof(float) * 3 * width);
+    std::memset(normalMap + (height - 1) * width * 3, 0, sizeof(float) * 3 * width);
+    for (int y = 1; y < height - 1; ++y) {
+        std::memset(normalMap + y * width * 3, 0, sizeof(float) * 3);
+        std::memset(normalMap + (y * width + width - 1) * 3, 0, sizeof(float) * 3);
+    }
+    if (width < 3 || height < 3) return;
+
+    auto process = [&](int yBegin, int yEnd) {
+        for (int y = yBegin; y < yEnd; ++y)
+            rowFunction(width, y, 1, width - 1, vertexMap, normalMap);
+    };
+
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    const int rows = height - 2;
+    threads = std::min(threads, rows);
+    if (threads == 1) {
+        process(1, height - 1);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    const int chunk = (rows + threads - 1) / threads;
+    for (int t = 1; t < threads; ++t) {
+        const int yBegin = 1 + t * chunk, yEnd = std::min(height - 1, yBegin + chunk);
+        if (yBegin < yEnd) workers.emplace_back(process, yBegin, yEnd);
+    }
+    process(1, std::min(height - 1, 1 + chunk));
+    for (auto &worker : workers) worker.join();
+}
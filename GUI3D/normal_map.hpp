@@ -0,0 +1,24 @@
+#pragma once
+
+namespace SC {
+    enum class NormalMapBackend { Auto, Scalar, SSE, AVX2 };
+
+    /**
+     CPU version of ComputeNormalMap in Shaders/CalNormal.cu.
+
+     The normal of a pixel is the normalized cross product of (left - right) and (upper - lower), flipped to
+     face the camera (z <= 0). Border pixels and pixels with a neighbour of z == 0 get a zero normal.
+
+     @param vertexMap width * height packed xyz floats, row-major.
+     @param normalMap width * height packed xyz floats, row-major. Must not alias vertexMap.
+     @param backend The SIMD path to use. Throws if the requested path was not compiled in.
+     @param threads Number of threads the rows are split over. 0 uses all hardware threads.
+     */
+    void ComputeNormalMap(int width, int height, const float *vertexMap, float *normalMap,
+                          NormalMapBackend backend = NormalMapBackend::Auto, int threads = 0);
+
+    /// Whether the backend was compiled in. Scalar and Auto are always available.
+    bool isAvailable(NormalMapBackend backend);
+
+    const char *toString(NormalMapBackend backend);
+}
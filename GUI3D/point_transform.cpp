@@ -0,0 +1,241 @@
+#include "point_transform.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "simd_xyz.hpp"
+
+using namespace SC;
+using namespace SC::simd;
+
+namespace {
+    PointBackend resolve(PointBackend backend) {
+        if (!isAvailable(backend))
+            throw std::runtime_error(std::string("Point kernels: backend ") + toString(backend) +
+                                     " is not compiled in.\n");
+        if (backend != PointBackend::Auto) return backend;
+#if defined(SC_SIMD_WITH_AVX2)
+        return PointBackend::AVX2;
+#elif defined(SC_SIMD_WITH_SSE)
+        return PointBackend::SSE;
+#else
+        return PointBackend::Scalar;
+#endif
+    }
+
+    void transformScalar(const float *m, const float *points, float *out, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            const float x = points[i * 3], y = points[i * 3 + 1], z = points[i * 3 + 2];
+            out[i * 3 + 0] = m[0] * x + m[4] * y + m[8] * z + m[12];
+            out[i * 3 + 1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+            out[i * 3 + 2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+        }
+    }
+
+    void boundsScalar(const float *points, size_t begin, size_t end, float *lo, float *hi) {
+        for (size_t i = begin; i < end; ++i)
+            for (int k = 0; k < 3; ++k) {
+                lo[k] = std::min(lo[k], points[i * 3 + k]);
+                hi[k] = std::max(hi[k], points[i * 3 + k]);
+            }
+    }
+
+    size_t cullScalar(const Frustum &frustum, const float *points, size_t begin, size_t end, uint32_t *indices,
+                      size_t count) {
+        for (size_t i = begin; i < end; ++i) {
+            const float *p = points + i * 3;
+            bool bInside = true;
+            for (const auto &plane : frustum.planes)
+                bInside &= plane[0] * p[0] + plane[1] * p[1] + plane[2] * p[2] + plane[3] >= 0;
+            if (bInside) indices[count++] = uint32_t(i);
+        }
+        return count;
+    }
+
+#ifdef SC_SIMD_WITH_SSE
+    size_t transformSSE(const float *m, const float *points, float *out, size_t n) {
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 x, y, z;
+            load4(points + i * 3, x, y, z);
+            const __m128 ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[0]), x), _mm_mul_ps(_mm_set1_ps(m[4]), y)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[8]), z), _mm_set1_ps(m[12])));
+            const __m128 oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[1]), x), _mm_mul_ps(_mm_set1_ps(m[5]), y)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[9]), z), _mm_set1_ps(m[13])));
+            const __m128 oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[2]), x), _mm_mul_ps(_mm_set1_ps(m[6]), y)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[10]), z), _mm_set1_ps(m[14])));
+            store4(out + i * 3, ox, oy, oz);
+        }
+        return i;
+    }
+
+    size_t boundsSSE(const float *points, size_t n, float *lo, float *hi) {
+        if (n < 4) return 0;
+        __m128 loX, loY, loZ;
+        load4(points, loX, loY, loZ);
+        __m128 hiX = loX, hiY = loY, hiZ = loZ;
+        size_t i = 4;
+        for (; i + 4 <= n; i += 4) {
+            __m128 x, y, z;
+            load4(points + i * 3, x, y, z);
+            loX = _mm_min_ps(loX, x), loY = _mm_min_ps(loY, y), loZ = _mm_min_ps(loZ, z);
+            hiX = _mm_max_ps(hiX, x), hiY = _mm_max_ps(hiY, y), hiZ = _mm_max_ps(hiZ, z);
+        }
+        alignas(16) float lanes[6][4];
+        _mm_store_ps(lanes[0], loX), _mm_store_ps(lanes[1], loY), _mm_store_ps(lanes[2], loZ);
+        _mm_store_ps(lanes[3], hiX), _mm_store_ps(lanes[4], hiY), _mm_store_ps(lanes[5], hiZ);
+        for (int k = 0; k < 3; ++k) {
+            lo[k] = std::min(std::min(lanes[k][0], lanes[k][1]), std::min(lanes[k][2], lanes[k][3]));
+            hi[k] = std::max(std::max(lanes[k + 3][0], lanes[k + 3][1]), std::max(lanes[k + 3][2], lanes[k + 3][3]));
+        }
+        return i;
+    }
+
+    size_t cullSSE(const Frustum &frustum, const float *points, size_t n, uint32_t *indices, size_t &count) {
+        const __m128 zero = _mm_setzero_ps();
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 x, y, z;
+            load4(points + i * 3, x, y, z);
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const auto &plane : frustum.planes) {
+                const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), x),
+                                                       _mm_mul_ps(_mm_set1_ps(plane[1]), y)),
+                                            _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[2]), z), _mm_set1_ps(plane[3])));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+            }
+            const int mask = _mm_movemask_ps(inside);
+            for (int lane = 0; lane < 4; ++lane)
+                if (mask & (1 << lane)) indices[count++] = uint32_t(i + lane);
+        }
+        return i;
+    }
+#endif
+
+#ifdef SC_SIMD_WITH_AVX2
+    /// a * b + c, fused where the target has FMA
+    inline __m256 madd(__m256 a, __m256 b, __m256 c) {
+#ifdef __FMA__
+        return _mm256_fmadd_ps(a, b, c);
+#else
+        return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+    }
+
+    size_t transformAVX2(const float *m, const float *points, float *out, size_t n) {
+        const __m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]);
+        const __m256 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]);
+        const __m256 m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]);
+        const __m256 m12 = _mm256_set1_ps(m[12]), m13 = _mm256_set1_ps(m[13]), m14 = _mm256_set1_ps(m[14]);
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256 x, y, z;
+            load8(points + i * 3, x, y, z);
+            const __m256 ox = madd(m0, x, madd(m4, y, madd(m8, z, m12)));
+            const __m256 oy = madd(m1, x, madd(m5, y, madd(m9, z, m13)));
+            const __m256 oz = madd(m2, x, madd(m6, y, madd(m10, z, m14)));
+            store8(out + i * 3, ox, oy, oz);
+        }
+        return i;
+    }
+
+    size_t cullAVX2(const Frustum &frustum, const float *points, size_t n, uint32_t *indices, size_t &count) {
+        __m256 planes[6][4];
+        for (int p = 0; p < 6; ++p)
+            for (int k = 0; k < 4; ++k) planes[p][k] = _mm256_set1_ps(frustum.planes[p][k]);
+        const __m256 zero = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= n; i += 8) {
+            __m256 x, y, z;
+            load8(points + i * 3, x, y, z);
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (const auto &plane : planes) {
+                const __m256 d = madd(plane[0], x, madd(plane[1], y, madd(plane[2], z, plane[3])));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(d, zero, _CMP_GE_OQ));
+            }
+            const int mask = _mm256_movemask_ps(inside);
+            for (int lane = 0; lane < 8; ++lane)
+                if (mask & (1 << lane)) indices[count++] = uint32_t(i + lane);
+        }
+        return i;
+    }
+#endif
+}
+
+void SC::TransformPoints(const float *pose, const float *points, float *out, size_t n, PointBackend backend) {
+    size_t done = 0;
+    switch (resolve(backend)) {
+#ifdef SC_SIMD_WITH_SSE
+        case PointBackend::SSE: done = transformSSE(pose, points, out, n); break;
+#endif
+#ifdef SC_SIMD_WITH_AVX2
+        case PointBackend::AVX2: done = transformAVX2(pose, points, out, n); break;
+#endif
+        default: break;
+    }
+    transformScalar(pose, points, out, done, n);
+}
+
+void SC::ComputeBounds(const float *points, size_t n, float *boundsMin, float *boundsMax, PointBackend backend) {
+    if (n == 0) throw std::runtime_error("ComputeBounds: no points.\n");
+    size_t done = 0;
+    // the min/max kernel is memory bound: AVX2 uses the SSE path
+    const PointBackend resolved = resolve(backend);
+#ifdef SC_SIMD_WITH_SSE
+    if (resolved == PointBackend::SSE || resolved == PointBackend::AVX2)
+        done = boundsSSE(points, n, boundsMin, boundsMax);
+#endif
+    if (done == 0) {
+        std::copy(points, points + 3, boundsMin);
+        std::copy(points, points + 3, boundsMax);
+        done = 1;
+    }
+    boundsScalar(points, done, n, boundsMin, boundsMax);
+}
+
+size_t SC::CullPoints(const Frustum &frustum, const float *points, size_t n, uint32_t *indices,
+                      PointBackend backend) {
+    size_t count = 0, done = 0;
+    switch (resolve(backend)) {
+#ifdef SC_SIMD_WITH_SSE
+        case PointBackend::SSE: done = cullSSE(frustum, points, n, indices, count); break;
+#endif
+#ifdef SC_SIMD_WITH_AVX2
+        case PointBackend::AVX2: done = cullAVX2(frustum, points, n, indices, count); break;
+#endif
+        default: break;
+    }
+    return cullScalar(frustum, points, done, n, indices, count);
+}
+
+bool SC::isAvailable(PointBackend backend) {
+    switch (backend) {
+        case PointBackend::Auto:
+        case PointBackend::Scalar:
+            return true;
+        case PointBackend::SSE:
+#ifdef SC_SIMD_WITH_SSE
+            return true;
+#else
+            return false;
+#endif
+        case PointBackend::AVX2:
+#ifdef SC_SIMD_WITH_AVX2
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char *SC::toString(PointBackend backend) {
+    switch (backend) {
+        case PointBackend::Auto: return "Auto";
+        case PointBackend::Scalar: return "Scalar";
+        case PointBackend::SSE: return "SSE";
+        case PointBackend::AVX2: return "AVX2";
+    }
+    return "Unknown";
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "view_culling.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SC {
+    enum class PointBackend { Auto, Scalar, SSE, AVX2 };
+
+    /**
+     Batch kernels for large point sets as packed xyz floats (e.g. std::vector<glm::vec3>, an Eigen::Matrix3Xf or
+     a PointBatch, see eigen_glm.hpp for the views). Every kernel throws if the requested backend was not
+     compiled in.
+     */
+
+    /// out = pose * (p, 1) for n points. pose is a column-major 4x4 affine transform (the last row is ignored),
+    /// e.g. glm::value_ptr(mat) or Eigen::Matrix4f::data(). out may be points for an in-place transform.
+    void TransformPoints(const float *pose, const float *points, float *out, size_t n,
+                         PointBackend backend = PointBackend::Auto);
+
+    /// Axis-aligned bounds of n > 0 points.
+    void ComputeBounds(const float *points, size_t n, float *boundsMin, float *boundsMax,
+                       PointBackend backend = PointBackend::Auto);
+
+    /// Write the indices of the points inside the frustum (on or inside all six planes) in ascending order.
+    /// @param indices Room for n indices.
+    /// @return The number of points inside.
+    size_t CullPoints(const Frustum &frustum, const float *points, size_t n, uint32_t *indices,
+                      PointBackend backend = PointBackend::Auto);
+
+    /// Whether the backend was compiled in. Scalar and Auto are always available.
+    bool isAvailable(PointBackend backend);
+
+    const char *toString(PointBackend backend);
+}
@@ -1,6 +1,8 @@
 #include "projection_control.hpp"
 
 #include <imgui.h>
+#include <algorithm>
+#include <cmath>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
@@ -33,6 +35,14 @@ glm::mat4 ProjectionControl::projection_matrix() const {
 //  return Eigen::Map<Eigen::Matrix4f>(glm::value_ptr(proj));
 }
 
+float ProjectionControl::pixels_per_unit(float distance) const {
+    if(projection_mode == 0) {
+        distance = std::max(distance, near);
+        return float(height_) / (2.f * distance * std::tan(glm::radians(fovy) / 2.f));
+    }
+    return float(width_) / width;
+}
+
 void ProjectionControl::show() {
     bShowUI = true;
 }
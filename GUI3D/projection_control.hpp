@@ -17,6 +17,17 @@ namespace SC {
 
         glm::mat4 projection_matrix() const;
 
+        float near_plane() const { return near; }
+        float far_plane() const { return far; }
+
+        /// Screen pixels covered by one world unit at the given view distance, vertically.
+        float pixels_per_unit(float distance) const;
+
+        void setPerspective(float fovyDegrees) { projection_mode = 0; fovy = fovyDegrees; }
+        /// viewWidth: world units across the viewport.
+        void setOrthographic(float viewWidth) { projection_mode = 1; width = viewWidth; }
+        bool isOrthographic() const { return projection_mode == 1; }
+
         void draw_ui();
 
         void show();
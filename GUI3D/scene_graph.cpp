@@ -0,0 +1,278 @@
+#include "scene_graph.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SCENEGRAPH_WITH_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace SC;
+
+namespace {
+    const float kIdentity[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+
+    template <typename T>
+    void gather(std::vector<T> &values, const std::vector<uint32_t> &from) {
+        std::vector<T> sorted(from.size());
+        for (size_t i = 0; i < from.size(); ++i) sorted[i] = values[from[i]];
+        values.swap(sorted);
+    }
+}
+
+const SceneGraph::NodeId SceneGraph::kNone;
+
+SceneGraph::SceneGraph() : firstRoot_(kNone), lastRoot_(kNone), numNodes_(0), bStructureDirty_(false),
+                           lastUpdateCount_(0) {}
+
+SceneGraph::NodeId SceneGraph::create(NodeId parent) {
+    if (parent != kNone && (parent >= alive_.size() || !alive_[parent]))
+        throw std::runtime_error("SceneGraph::create: parent " + std::to_string(parent) + " does not exist.");
+    NodeId id;
+    if (!freeIds_.empty()) {
+        id = freeIds_.back();
+        freeIds_.pop_back();
+    } else {
+        id = NodeId(alive_.size());
+        parent_.push_back(kNone);
+        firstChild_.push_back(kNone);
+        lastChild_.push_back(kNone);
+        nextSibling_.push_back(kNone);
+        prevSibling_.push_back(kNone);
+        index_.push_back(0);
+        alive_.push_back(0);
+    }
+    alive_[id] = 1;
+    parent_[id] = firstChild_[id] = lastChild_[id] = nextSibling_[id] = prevSibling_[id] = kNone;
+    link(id, parent);
+
+    // appended; the depth-first position is assigned by the next sort
+    index_[id] = uint32_t(ids_.size());
+    tx_.push_back(0), ty_.push_back(0), tz_.push_back(0);
+    qx_.push_back(0), qy_.push_back(0), qz_.push_back(0), qw_.push_back(1);
+    sx_.push_back(1), sy_.push_back(1), sz_.push_back(1);
+    parentIndex_.push_back(-1);
+    end_.push_back(uint32_t(ids_.size()) + 1);
+    dirty_.push_back(0);
+    ids_.push_back(id);
+    world_.insert(world_.end(), kIdentity, kIdentity + 16);
+    markDirty(index_[id]);
+    numNodes_++;
+    bStructureDirty_ = true;
+    return id;
+}
+
+void SceneGraph::destroy(NodeId id) {
+    if (id >= alive_.size() || !alive_[id]) return;
+    unlink(id);
+    std::vector<NodeId> stack(1, id);
+    while (!stack.empty()) {
+        const NodeId node = stack.back();
+        stack.pop_back();
+        for (NodeId child = firstChild_[node]; child != kNone; child = nextSibling_[child]) stack.push_back(child);
+        firstChild_[node] = lastChild_[node] = kNone;
+        alive_[node] = 0;
+        freeIds_.push_back(node);
+        numNodes_--;
+    }
+    bStructureDirty_ = true;
+}
+
+void SceneGraph::setParent(NodeId id, NodeId parent) {
+    for (NodeId ancestor = parent; ancestor != kNone; ancestor = parent_[ancestor])
+        if (ancestor == id) throw std::runtime_error("SceneGraph::setParent: the new parent is in the subtree.");
+    unlink(id);
+    link(id, parent);
+    markDirty(index_[id]);
+    bStructureDirty_ = true;
+}
+
+void SceneGraph::setTranslation(NodeId id, float x, float y, float z) {
+    const uint32_t i = index_[id];
+    tx_[i] = x, ty_[i] = y, tz_[i] = z;
+    markDirty(i);
+}
+
+void SceneGraph::setRotation(NodeId id, float x, float y, float z, float w) {
+    const uint32_t i = index_[id];
+    qx_[i] = x, qy_[i] = y, qz_[i] = z, qw_[i] = w;
+    markDirty(i);
+}
+
+void SceneGraph::setScale(NodeId id, float x, float y, float z) {
+    const uint32_t i = index_[id];
+    sx_[i] = x, sy_[i] = y, sz_[i] = z;
+    markDirty(i);
+}
+
+void SceneGraph::markDirty(uint32_t index) {
+    if (dirty_[index]) return;
+    dirty_[index] = 1;
+    dirtyList_.push_back(index);
+}
+
+void SceneGraph::link(NodeId id, NodeId parent) {
+    NodeId &first = parent == kNone ? firstRoot_ : firstChild_[parent];
+    NodeId &last = parent == kNone ? lastRoot_ : lastChild_[parent];
+    parent_[id] = parent;
+    prevSibling_[id] = last;
+    nextSibling_[id] = kNone;
+    if (last != kNone) nextSibling_[last] = id;
+    else first = id;
+    last = id;
+}
+
+void SceneGraph::unlink(NodeId id) {
+    const NodeId parent = parent_[id];
+    NodeId &first = parent == kNone ? firstRoot_ : firstChild_[parent];
+    NodeId &last = parent == kNone ? lastRoot_ : lastChild_[parent];
+    if (prevSibling_[id] != kNone) nextSibling_[prevSibling_[id]] = nextSibling_[id];
+    else first = nextSibling_[id];
+    if (nextSibling_[id] != kNone) prevSibling_[nextSibling_[id]] = prevSibling_[id];
+    else last = prevSibling_[id];
+    parent_[id] = prevSibling_[id] = nextSibling_[id] = kNone;
+}
+
+void SceneGraph::sort() {
+    // depth-first order of the live nodes, so every subtree is one contiguous range after its root
+    std::vector<uint32_t> from;
+    std::vector<NodeId> ids;
+    from.reserve(numNodes_);
+    ids.reserve(numNodes_);
+    NodeId node = firstRoot_;
+    while (node != kNone) {
+        from.push_back(index_[node]);
+        ids.push_back(node);
+        if (firstChild_[node] != kNone) {
+            node = firstChild_[node];
+            continue;
+        }
+        while (node != kNone && nextSibling_[node] == kNone) node = parent_[node];
+        if (node != kNone) node = nextSibling_[node];
+    }
+
+    gather(tx_, from), gather(ty_, from), gather(tz_, from);
+    gather(qx_, from), gather(qy_, from), gather(qz_, from), gather(qw_, from);
+    gather(sx_, from), gather(sy_, from), gather(sz_, from);
+    gather(dirty_, from);
+    std::vector<float> world(from.size() * 16);
+    for (size_t i = 0; i < from.size(); ++i)
+        std::copy(&world_[size_t(from[i]) * 16], &world_[size_t(from[i]) * 16] + 16, &world[i * 16]);
+    world_.swap(world);
+    ids_.swap(ids);
+
+    const uint32_t n = uint32_t(ids_.size());
+    for (uint32_t i = 0; i < n; ++i) index_[ids_[i]] = i;
+    parentIndex_.resize(n);
+    end_.resize(n);
+    dirtyList_.clear();
+    for (uint32_t i = 0; i < n; ++i) {
+        const NodeId parent = parent_[ids_[i]];
+        parentIndex_[i] = parent == kNone ? -1 : int32_t(index_[parent]);
+        end_[i] = i + 1;
+        if (dirty_[i]) dirtyList_.push_back(i);
+    }
+    // children follow their parent, so the subtree ends propagate up in one backwards pass
+    for (uint32_t i = n; i-- > 0;)
+        if (parentIndex_[i] >= 0) end_[parentIndex_[i]] = std::max(end_[parentIndex_[i]], end_[i]);
+    bStructureDirty_ = false;
+}
+
+void SceneGraph::update() {
+    if (bStructureDirty_) sort();
+    // ancestors sort before their descendants, so a dirty node inside an updated subtree is skipped
+    std::sort(dirtyList_.begin(), dirtyList_.end());
+    lastUpdateCount_ = 0;
+    uint32_t updatedEnd = 0;
+    for (uint32_t index : dirtyList_) {
+        dirty_[index] = 0;
+        if (index < updatedEnd) continue;
+        updatedEnd = end_[index];
+        updateRange(index, updatedEnd);
+        lastUpdateCount_ += updatedEnd - index;
+    }
+    dirtyList_.clear();
+}
+
+void SceneGraph::updateRange(uint32_t begin, uint32_t end) {
+    const uint32_t n = end - begin;
+    for (auto &column : local_)
+        if (column.size() < n) column.resize(n);
+    const float *qx = &qx_[begin], *qy = &qy_[begin], *qz = &qz_[begin], *qw = &qw_[begin];
+    const float *sx = &sx_[begin], *sy = &sy_[begin], *sz = &sz_[begin];
+
+    // Pass 1: rotation * scale of every node, columns in SoA
+    uint32_t j = 0;
+#ifdef SCENEGRAPH_WITH_SSE
+    const __m128 one = _mm_set1_ps(1.f), two = _mm_set1_ps(2.f);
+    for (; j + 4 <= n; j += 4) {
+        const __m128 x = _mm_loadu_ps(qx + j), y = _mm_loadu_ps(qy + j), z = _mm_loadu_ps(qz + j);
+        const __m128 w = _mm_loadu_ps(qw + j);
+        const __m128 x2 = _mm_mul_ps(x, two), y2 = _mm_mul_ps(y, two), z2 = _mm_mul_ps(z, two);
+        const __m128 xx = _mm_mul_ps(x, x2), yy = _mm_mul_ps(y, y2), zz = _mm_mul_ps(z, z2);
+        const __m128 xy = _mm_mul_ps(x, y2), xz = _mm_mul_ps(x, z2), yz = _mm_mul_ps(y, z2);
+        const __m128 wx = _mm_mul_ps(w, x2), wy = _mm_mul_ps(w, y2), wz = _mm_mul_ps(w, z2);
+        const __m128 scaleX = _mm_loadu_ps(sx + j), scaleY = _mm_loadu_ps(sy + j), scaleZ = _mm_loadu_ps(sz + j);
+        _mm_storeu_ps(&local_[0][j], _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), scaleX));
+        _mm_storeu_ps(&local_[1][j], _mm_mul_ps(_mm_add_ps(xy, wz), scaleX));
+        _mm_storeu_ps(&local_[2][j], _mm_mul_ps(_mm_sub_ps(xz, wy), scaleX));
+        _mm_storeu_ps(&local_[3][j], _mm_mul_ps(_mm_sub_ps(xy, wz), scaleY));
+        _mm_storeu_ps(&local_[4][j], _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), scaleY));
+        _mm_storeu_ps(&local_[5][j], _mm_mul_ps(_mm_add_ps(yz, wx), scaleY));
+        _mm_storeu_ps(&local_[6][j], _mm_mul_ps(_mm_add_ps(xz, wy), scaleZ));
+        _mm_storeu_ps(&local_[7][j], _mm_mul_ps(_mm_sub_ps(yz, wx), scaleZ));
+        _mm_storeu_ps(&local_[8][j], _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), scaleZ));
+    }
+#endif
+    for (; j < n; ++j) {
+        const float x = qx[j], y = qy[j], z = qz[j], w = qw[j];
+        const float xx = 2 * x * x, yy = 2 * y * y, zz = 2 * z * z;
+        const float xy = 2 * x * y, xz = 2 * x * z, yz = 2 * y * z;
+        const float wx = 2 * w * x, wy = 2 * w * y, wz = 2 * w * z;
+        local_[0][j] = (1 - yy - zz) * sx[j];
+        local_[1][j] = (xy + wz) * sx[j];
+        local_[2][j] = (xz - wy) * sx[j];
+        local_[3][j] = (xy - wz) * sy[j];
+        local_[4][j] = (1 - xx - zz) * sy[j];
+        local_[5][j] = (yz + wx) * sy[j];
+        local_[6][j] = (xz + wy) * sz[j];
+        local_[7][j] = (yz - wx) * sz[j];
+        local_[8][j] = (1 - xx - yy) * sz[j];
+    }
+
+    // Pass 2: world = parent world * local, parents first. The parent of begin is up to date.
+    for (uint32_t i = begin; i < end; ++i) {
+        j = i - begin;
+        const float l[12] = {local_[0][j], local_[1][j], local_[2][j], local_[3][j], local_[4][j], local_[5][j],
+                             local_[6][j], local_[7][j], local_[8][j], tx_[i], ty_[i], tz_[i]};
+        float *w = &world_[size_t(i) * 16];
+        if (parentIndex_[i] < 0) {
+            for (int c = 0; c < 4; ++c) {
+                w[c * 4 + 0] = l[c * 3 + 0];
+                w[c * 4 + 1] = l[c * 3 + 1];
+                w[c * 4 + 2] = l[c * 3 + 2];
+                w[c * 4 + 3] = c == 3 ? 1.f : 0.f;
+            }
+            continue;
+        }
+        const float *p = &world_[size_t(parentIndex_[i]) * 16];
+#ifdef SCENEGRAPH_WITH_SSE
+        const __m128 p0 = _mm_loadu_ps(p), p1 = _mm_loadu_ps(p + 4), p2 = _mm_loadu_ps(p + 8);
+        const __m128 p3 = _mm_loadu_ps(p + 12);
+        for (int c = 0; c < 4; ++c) {
+            __m128 column = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(l[c * 3 + 0])),
+                                                  _mm_mul_ps(p1, _mm_set1_ps(l[c * 3 + 1]))),
+                                       _mm_mul_ps(p2, _mm_set1_ps(l[c * 3 + 2])));
+            if (c == 3) column = _mm_add_ps(column, p3);
+            _mm_storeu_ps(w + c * 4, column);
+        }
+#else
+        for (int c = 0; c < 4; ++c)
+            for (int r = 0; r < 4; ++r)
+                w[c * 4 + r] = p[r] * l[c * 3 + 0] + p[4 + r] * l[c * 3 + 1] + p[8 + r] * l[c * 3 + 2] +
+                               (c == 3 ? p[12 + r] : 0.f);
+#endif
+    }
+}
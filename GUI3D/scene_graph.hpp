@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SC {
+    /**
+     Transform hierarchy with the node data in structure-of-arrays storage: translation, rotation (unit
+     quaternion) and scale each live in their own arrays, ordered depth first so that every subtree is one
+     contiguous range. Changing a node marks it dirty; update() recomputes the world matrices of the dirty
+     subtrees only, four local matrices at a time, so moving one keyframe among 100k nodes costs its subtree.
+
+     Nodes are addressed by stable ids. Adding, removing or reparenting nodes re-sorts the storage once, in the
+     next update().
+     */
+    class SceneGraph {
+    public:
+        typedef uint32_t NodeId;
+        static const NodeId kNone = 0xFFFFFFFFu;
+
+        SceneGraph();
+
+        /// A node with the identity transform, as the last child of parent (kNone for a root).
+        NodeId create(NodeId parent = kNone);
+        /// Remove the node and its subtree. Their ids are reused by later creates.
+        void destroy(NodeId id);
+        /// Move the node and its subtree under parent (kNone for a root). Throws if parent is in the subtree.
+        void setParent(NodeId id, NodeId parent);
+        NodeId parent(NodeId id) const { return parent_[id]; }
+
+        void setTranslation(NodeId id, float x, float y, float z);
+        /// Quaternion x, y, z, w. Expected to be normalized.
+        void setRotation(NodeId id, float x, float y, float z, float w);
+        void setScale(NodeId id, float x, float y, float z);
+
+        /// Recompute the world matrices of the dirty subtrees.
+        void update();
+        /// Column-major 4x4 local to world of the node, as of the last update().
+        const float *world(NodeId id) const { return &world_[size_t(index_[id]) * 16]; }
+
+        size_t size() const { return numNodes_; }
+        /// World matrices recomputed by the last update().
+        size_t lastUpdateCount() const { return lastUpdateCount_; }
+
+    private:
+        // per id: the hierarchy and the position in the depth-first order
+        std::vector<NodeId> parent_, firstChild_, lastChild_, nextSibling_, prevSibling_;
+        std::vector<uint32_t> index_;
+        std::vector<uint8_t> alive_;
+        std::vector<NodeId> freeIds_;
+        NodeId firstRoot_, lastRoot_;
+        size_t numNodes_;
+
+        // per position in the depth-first order. New nodes are appended until the next re-sort.
+        std::vector<float> tx_, ty_, tz_, qx_, qy_, qz_, qw_, sx_, sy_, sz_;
+        std::vector<int32_t> parentIndex_; // -1 for roots
+        std::vector<uint32_t> end_;        // one past the last node of the subtree
+        std::vector<uint8_t> dirty_;
+        std::vector<uint32_t> dirtyList_;
+        std::vector<NodeId> ids_;
+        std::vector<float> world_;         // 16 floats per node
+        bool bStructureDirty_;
+        size_t lastUpdateCount_;
+
+        // rotation and scale columns of the local matrices of the range being updated
+        std::vector<float> local_[9];
+
+        void markDirty(uint32_t index);
+        void link(NodeId id, NodeId parent);
+        void unlink(NodeId id);
+        void sort();
+        void updateRange(uint32_t begin, uint32_t end);
+    };
+}
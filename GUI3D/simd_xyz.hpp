@@ -0,0 +1,60 @@
+#pragma once
+// Packed xyz float triplets to and from SIMD registers holding the x, y and z of 4 (SSE) or 8 (AVX2) points.
+// Shared by the SIMD paths of the CPU point kernels.
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define SC_SIMD_WITH_SSE
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#define SC_SIMD_WITH_AVX2
+#include <immintrin.h>
+#endif
+
+namespace SC {
+    namespace simd {
+#ifdef SC_SIMD_WITH_SSE
+        /// 4 packed xyz (12 floats) to SoA.
+        inline void load4(const float *p, __m128 &x, __m128 &y, __m128 &z) {
+            const __m128 a = _mm_loadu_ps(p);     // x0 y0 z0 x1
+            const __m128 b = _mm_loadu_ps(p + 4); // y1 z1 x2 y2
+            const __m128 c = _mm_loadu_ps(p + 8); // z2 x3 y3 z3
+            x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+            y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+                               _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), c, _MM_SHUFFLE(3, 0, 2, 0));
+        }
+
+        /// SoA to 4 packed xyz (12 floats).
+        inline void store4(float *p, __m128 x, __m128 y, __m128 z) {
+            const __m128 a = _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)),
+                                            _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 b = _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)),
+                                            _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 c = _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)),
+                                            _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+            _mm_storeu_ps(p, a);
+            _mm_storeu_ps(p + 4, b);
+            _mm_storeu_ps(p + 8, c);
+        }
+#endif
+
+#ifdef SC_SIMD_WITH_AVX2
+        /// 8 packed xyz (24 floats) to SoA.
+        inline void load8(const float *p, __m256 &x, __m256 &y, __m256 &z) {
+            __m128 x0, y0, z0, x1, y1, z1;
+            load4(p, x0, y0, z0);
+            load4(p + 12, x1, y1, z1);
+            x = _mm256_insertf128_ps(_mm256_castps128_ps256(x0), x1, 1);
+            y = _mm256_insertf128_ps(_mm256_castps128_ps256(y0), y1, 1);
+            z = _mm256_insertf128_ps(_mm256_castps128_ps256(z0), z1, 1);
+        }
+
+        /// SoA to 8 packed xyz (24 floats).
+        inline void store8(float *p, __m256 x, __m256 y, __m256 z) {
+            store4(p, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+            store4(p + 12, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1));
+        }
+#endif
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace SC {
+    /**
+     Bounded lock-free queue for one producer thread and one consumer thread. The capacity is rounded up to a
+     power of two. push fails instead of blocking when the queue is full, so a producer never waits on the
+     consumer; what to do with the dropped item is up to the caller.
+     */
+    template <typename T>
+    class SpscQueue {
+    public:
+        explicit SpscQueue(size_t capacity = 256) : head_(0), tail_(0) {
+            size_t size = 1;
+            while (size < capacity) size <<= 1;
+            items_.resize(size);
+            mask_ = size - 1;
+        }
+
+        /// Producer thread.
+        bool push(const T &item) {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_.load(std::memory_order_acquire) > mask_) return false;
+            items_[tail & mask_] = item;
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Consumer thread.
+        bool pop(T &item) {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if (head == tail_.load(std::memory_order_acquire)) return false;
+            item = items_[head & mask_];
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Approximate when called while the other side is running.
+        size_t size() const { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+        size_t capacity() const { return mask_ + 1; }
+
+    private:
+        std::vector<T> items_;
+        size_t mask_;
+        // on separate cache lines so producer and consumer do not invalidate each other's index
+        alignas(64) std::atomic<size_t> head_;
+        alignas(64) std::atomic<size_t> tail_;
+    };
+}
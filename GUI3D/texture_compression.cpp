@@ -0,0 +1,504 @@
+#include "texture_compression.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <stdexcept>
+#include <thread>
+
+using namespace SC;
+
+namespace {
+    const int kEncoderVersion = 1; // bump when the encoder output changes, invalidates cached files
+
+    // ---------------------------------------------------------------------------------------------------------
+    // Block encoders. Input: 16 RGBA texels of one 4x4 block, row-major.
+
+    inline uint16_t pack565(const float c[3]) {
+        const int r = std::min(std::max(int(c[0] * 31.f / 255.f + 0.5f), 0), 31);
+        const int g = std::min(std::max(int(c[1] * 63.f / 255.f + 0.5f), 0), 63);
+        const int b = std::min(std::max(int(c[2] * 31.f / 255.f + 0.5f), 0), 31);
+        return uint16_t((r << 11) | (g << 5) | b);
+    }
+
+    inline void unpack565(uint16_t c, int out[3]) {
+        const int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+        out[0] = (r << 3) | (r >> 2);
+        out[1] = (g << 2) | (g >> 4);
+        out[2] = (b << 3) | (b >> 2);
+    }
+
+    /// Endpoints along the principal axis of the block colors, always in 4-color mode (c0 > c1).
+    void encodeBC1(const uint8_t *block, uint8_t *out) {
+        float mean[3] = {0, 0, 0};
+        for (int i = 0; i < 16; ++i)
+            for (int c = 0; c < 3; ++c) mean[c] += block[i * 4 + c] / 16.f;
+        float cov[6] = {0, 0, 0, 0, 0, 0};
+        for (int i = 0; i < 16; ++i) {
+            const float r = block[i * 4] - mean[0], g = block[i * 4 + 1] - mean[1], b = block[i * 4 + 2] - mean[2];
+            cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+            cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+        }
+        // power iteration for the principal axis
+        float axis[3] = {1.f, 1.f, 1.f};
+        for (int it = 0; it < 8; ++it) {
+            const float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+            const float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+            const float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+            const float norm = std::max(std::max(std::fabs(x), std::fabs(y)), std::fabs(z));
+            if (norm < 1e-6f) break;
+            axis[0] = x / norm; axis[1] = y / norm; axis[2] = z / norm;
+        }
+        const float len2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+        float tMin = 0, tMax = 0;
+        for (int i = 0; i < 16; ++i) {
+            const float t = ((block[i * 4] - mean[0]) * axis[0] + (block[i * 4 + 1] - mean[1]) * axis[1] +
+                             (block[i * 4 + 2] - mean[2]) * axis[2]) / len2;
+            tMin = std::min(tMin, t);
+            tMax = std::max(tMax, t);
+        }
+        // inset by 1/16 of the range: the interpolated colors sit closer to the data
+        const float inset = (tMax - tMin) / 16.f;
+        tMin += inset;
+        tMax -= inset;
+        float e0[3], e1[3];
+        for (int c = 0; c < 3; ++c) {
+            e0[c] = mean[c] + axis[c] * tMax;
+            e1[c] = mean[c] + axis[c] * tMin;
+        }
+        uint16_t c0 = pack565(e0), c1 = pack565(e1);
+        uint32_t indices = 0;
+        if (c0 != c1) {
+            if (c0 < c1) std::swap(c0, c1);
+            int palette[4][3];
+            unpack565(c0, palette[0]);
+            unpack565(c1, palette[1]);
+            for (int c = 0; c < 3; ++c) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            }
+            for (int i = 0; i < 16; ++i) {
+                int best = 0, bestDist = 1 << 30;
+                for (int p = 0; p < 4; ++p) {
+                    const int dr = block[i * 4] - palette[p][0], dg = block[i * 4 + 1] - palette[p][1],
+                              db = block[i * 4 + 2] - palette[p][2];
+                    const int dist = dr * dr + dg * dg + db * db;
+                    if (dist < bestDist) {
+                        bestDist = dist;
+                        best = p;
+                    }
+                }
+                indices |= uint32_t(best) << (2 * i);
+            }
+        }
+        std::memcpy(out, &c0, 2);
+        std::memcpy(out + 2, &c1, 2);
+        std::memcpy(out + 4, &indices, 4);
+    }
+
+    /// One channel in 8-value mode (a0 > a1) between the block minimum and maximum.
+    void encodeBC4(const uint8_t *block, int channel, uint8_t *out) {
+        int lo = 255, hi = 0;
+        for (int i = 0; i < 16; ++i) {
+            lo = std::min(lo, int(block[i * 4 + channel]));
+            hi = std::max(hi, int(block[i * 4 + channel]));
+        }
+        out[0] = uint8_t(hi);
+        out[1] = uint8_t(lo);
+        uint64_t indices = 0;
+        if (hi > lo) {
+            int palette[8] = {hi, lo};
+            for (int p = 1; p < 7; ++p) palette[p + 1] = ((7 - p) * hi + p * lo) / 7;
+            for (int i = 0; i < 16; ++i) {
+                const int v = block[i * 4 + channel];
+                int best = 0, bestDist = 1 << 30;
+                for (int p = 0; p < 8; ++p) {
+                    const int dist = std::abs(v - palette[p]);
+                    if (dist < bestDist) {
+                        bestDist = dist;
+                        best = p;
+                    }
+                }
+                indices |= uint64_t(best) << (3 * i);
+            }
+        }
+        for (int b = 0; b < 6; ++b) out[2 + b] = uint8_t(indices >> (8 * b));
+    }
+
+    void decodeBC1(const uint8_t *in, uint8_t *block) {
+        uint16_t c0, c1;
+        uint32_t indices;
+        std::memcpy(&c0, in, 2);
+        std::memcpy(&c1, in + 2, 2);
+        std::memcpy(&indices, in + 4, 4);
+        int palette[4][3];
+        unpack565(c0, palette[0]);
+        unpack565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        for (int i = 0; i < 16; ++i) {
+            const int p = (indices >> (2 * i)) & 3;
+            for (int c = 0; c < 3; ++c) block[i * 4 + c] = uint8_t(palette[p][c]);
+        }
+    }
+
+    void decodeBC4(const uint8_t *in, int channel, uint8_t *block) {
+        const int a0 = in[0], a1 = in[1];
+        int palette[8] = {a0, a1};
+        if (a0 > a1) {
+            for (int p = 1; p < 7; ++p) palette[p + 1] = ((7 - p) * a0 + p * a1) / 7;
+        } else {
+            for (int p = 1; p < 5; ++p) palette[p + 1] = ((5 - p) * a0 + p * a1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+        uint64_t indices = 0;
+        for (int b = 0; b < 6; ++b) indices |= uint64_t(in[2 + b]) << (8 * b);
+        for (int i = 0; i < 16; ++i) block[i * 4 + channel] = uint8_t(palette[(indices >> (3 * i)) & 7]);
+    }
+
+    // ---------------------------------------------------------------------------------------------------------
+
+    float srgbToLinear(float v) {
+        v /= 255.f;
+        return v <= 0.04045f ? v / 12.92f : std::pow((v + 0.055f) / 1.055f, 2.4f);
+    }
+
+    uint8_t linearToSrgb(float v) {
+        v = v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.f / 2.4f) - 0.055f;
+        return uint8_t(std::min(std::max(v * 255.f + 0.5f, 0.f), 255.f));
+    }
+
+    /// 2x2 box filter. Odd sizes repeat the last row/column. Alpha is always filtered linearly.
+    std::vector<uint8_t> downsample(const std::vector<uint8_t> &src, int width, int height, bool bSRGB) {
+        static const std::vector<float> lut = [] {
+            std::vector<float> table(256);
+            for (int i = 0; i < 256; ++i) table[i] = srgbToLinear(float(i));
+            return table;
+        }();
+        const int w = std::max(1, width / 2), h = std::max(1, height / 2);
+        std::vector<uint8_t> dst(size_t(w) * h * 4);
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x) {
+                const int x0 = std::min(2 * x, width - 1), x1 = std::min(2 * x + 1, width - 1);
+                const int y0 = std::min(2 * y, height - 1), y1 = std::min(2 * y + 1, height - 1);
+                const uint8_t *p[4] = {&src[(size_t(y0) * width + x0) * 4], &src[(size_t(y0) * width + x1) * 4],
+                                       &src[(size_t(y1) * width + x0) * 4], &src[(size_t(y1) * width + x1) * 4]};
+                uint8_t *d = &dst[(size_t(y) * w + x) * 4];
+                for (int c = 0; c < 4; ++c) {
+                    if (bSRGB && c < 3)
+                        d[c] = linearToSrgb(0.25f * (lut[p[0][c]] + lut[p[1][c]] + lut[p[2][c]] + lut[p[3][c]]));
+                    else
+                        d[c] = uint8_t((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4);
+                }
+            }
+        return dst;
+    }
+
+    std::vector<uint8_t> encodeLevel(const std::vector<uint8_t> &rgba, int width, int height, BlockFormat format,
+                                     int threads) {
+        const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        const size_t blockBytes = BlockBytes(format);
+        std::vector<uint8_t> out(size_t(blocksX) * blocksY * blockBytes);
+
+        auto encodeRows = [&](int rowBegin, int rowEnd) {
+            uint8_t block[64];
+            for (int by = rowBegin; by < rowEnd; ++by)
+                for (int bx = 0; bx < blocksX; ++bx) {
+                    // edge blocks repeat the last texel
+                    for (int i = 0; i < 16; ++i) {
+                        const int x = std::min(bx * 4 + i % 4, width - 1), y = std::min(by * 4 + i / 4, height - 1);
+                        std::memcpy(block + i * 4, &rgba[(size_t(y) * width + x) * 4], 4);
+                    }
+                    uint8_t *dst = &out[(size_t(by) * blocksX + bx) * blockBytes];
+                    switch (format) {
+                        case BlockFormat::BC1:
+                            encodeBC1(block, dst);
+                            break;
+                        case BlockFormat::BC3:
+                            encodeBC4(block, 3, dst);
+                            encodeBC1(block, dst + 8);
+                            break;
+                        case BlockFormat::BC5:
+                            encodeBC4(block, 0, dst);
+                            encodeBC4(block, 1, dst + 8);
+                            break;
+                    }
+                }
+        };
+
+        threads = std::min(threads, blocksY);
+        if (threads <= 1) {
+            encodeRows(0, blocksY);
+            return out;
+        }
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+            workers.emplace_back(encodeRows, blocksY * t / threads, blocksY * (t + 1) / threads);
+        for (auto &worker : workers) worker.join();
+        return out;
+    }
+
+    // ---------------------------------------------------------------------------------------------------------
+    // KTX2
+
+    const uint8_t kKTX2Identifier[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+
+    uint32_t vkFormat(BlockFormat format, bool bSRGB) {
+        switch (format) {
+            case BlockFormat::BC1: return bSRGB ? 132 : 131; // VK_FORMAT_BC1_RGB_{SRGB,UNORM}_BLOCK
+            case BlockFormat::BC3: return bSRGB ? 138 : 137; // VK_FORMAT_BC3_{SRGB,UNORM}_BLOCK
+            case BlockFormat::BC5: return 141;               // VK_FORMAT_BC5_UNORM_BLOCK
+        }
+        return 0;
+    }
+
+    /// Khronos data format descriptor: one basic block describing the 4x4 block layout.
+    std::vector<uint8_t> dataFormatDescriptor(BlockFormat format, bool bSRGB) {
+        struct Sample { uint16_t bitOffset; uint8_t channel; };
+        Sample samples[2] = {{0, 0}, {64, 0}};
+        size_t numSamples = 2;
+        uint8_t colorModel = 0;
+        switch (format) {
+            case BlockFormat::BC1: // BC1A, color
+                colorModel = 128;
+                numSamples = 1;
+                break;
+            case BlockFormat::BC3: // BC3, alpha + color
+                colorModel = 130;
+                samples[0].channel = 15;
+                break;
+            case BlockFormat::BC5: // BC5, red + green
+                colorModel = 132;
+                samples[1].channel = 1;
+                break;
+        }
+        const uint16_t blockSize = uint16_t(24 + 16 * numSamples);
+        std::vector<uint8_t> dfd(4 + blockSize, 0);
+        auto put32 = [&](size_t offset, uint32_t v) { std::memcpy(&dfd[offset], &v, 4); };
+        put32(0, uint32_t(dfd.size()));
+        put32(4, 0); // vendor Khronos, basic descriptor type
+        const uint16_t version = 2;
+        std::memcpy(&dfd[8], &version, 2);
+        std::memcpy(&dfd[10], &blockSize, 2);
+        dfd[12] = colorModel;
+        dfd[13] = 1;             // BT.709 primaries
+        dfd[14] = bSRGB ? 2 : 1; // transfer function
+        dfd[15] = 0;             // straight alpha
+        dfd[16] = 3;             // block width - 1
+        dfd[17] = 3;             // block height - 1
+        dfd[20] = uint8_t(BlockBytes(format));
+        for (size_t i = 0; i < numSamples; ++i) {
+            const size_t s = 28 + 16 * i;
+            std::memcpy(&dfd[s], &samples[i].bitOffset, 2);
+            dfd[s + 2] = 63; // bit length - 1
+            dfd[s + 3] = samples[i].channel | (bSRGB && samples[i].channel == 15 ? 0x10 : 0); // sRGB alpha is linear
+            put32(s + 8, 0);
+            put32(s + 12, 0xFFFFFFFFu);
+        }
+        return dfd;
+    }
+}
+
+size_t SC::BlockBytes(BlockFormat format) {
+    return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+const char *SC::toString(BlockFormat format) {
+    switch (format) {
+        case BlockFormat::BC1: return "BC1";
+        case BlockFormat::BC3: return "BC3";
+        case BlockFormat::BC5: return "BC5";
+    }
+    return "unknown";
+}
+
+CompressedImage SC::CompressImage(const uint8_t *rgba, int width, int height, BlockFormat format, bool bSRGB,
+                                  bool bMipmaps, int threads) {
+    if (width <= 0 || height <= 0)
+        throw std::runtime_error("CompressImage: empty image");
+    if (threads <= 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    CompressedImage image;
+    image.format = format;
+    image.bSRGB = bSRGB && format != BlockFormat::BC5;
+    image.width = width;
+    image.height = height;
+
+    std::vector<uint8_t> level(rgba, rgba + size_t(width) * height * 4);
+    int w = width, h = height;
+    while (true) {
+        image.levels.push_back(encodeLevel(level, w, h, format, threads));
+        if (!bMipmaps || (w == 1 && h == 1)) break;
+        level = downsample(level, w, h, image.bSRGB);
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+    return image;
+}
+
+std::vector<uint8_t> SC::DecompressLevel(const CompressedImage &image, int levelIndex) {
+    const int width = std::max(1, image.width >> levelIndex), height = std::max(1, image.height >> levelIndex);
+    const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+    const size_t blockBytes = BlockBytes(image.format);
+    const std::vector<uint8_t> &level = image.levels.at(levelIndex);
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    uint8_t block[64];
+    for (int by = 0; by < blocksY; ++by)
+        for (int bx = 0; bx < blocksX; ++bx) {
+            const uint8_t *src = &level[(size_t(by) * blocksX + bx) * blockBytes];
+            for (int i = 0; i < 16; ++i) {
+                block[i * 4 + 2] = 0;
+                block[i * 4 + 3] = 255;
+            }
+            switch (image.format) {
+                case BlockFormat::BC1:
+                    decodeBC1(src, block);
+                    break;
+                case BlockFormat::BC3:
+                    decodeBC4(src, 3, block);
+                    decodeBC1(src + 8, block);
+                    break;
+                case BlockFormat::BC5:
+                    decodeBC4(src, 0, block);
+                    decodeBC4(src + 8, 1, block);
+                    break;
+            }
+            for (int i = 0; i < 16; ++i) {
+                const int x = bx * 4 + i % 4, y = by * 4 + i / 4;
+                if (x < width && y < height) std::memcpy(&rgba[(size_t(y) * width + x) * 4], block + i * 4, 4);
+            }
+        }
+    return rgba;
+}
+
+void SC::WriteKTX2(const std::string &path, const CompressedImage &image) {
+    const uint32_t levelCount = uint32_t(image.levels.size());
+    const std::vector<uint8_t> dfd = dataFormatDescriptor(image.format, image.bSRGB);
+    const uint32_t dfdOffset = 80 + 24 * levelCount;
+    const size_t alignment = BlockBytes(image.format); // lcm(block size, 4)
+
+    // levels are stored smallest first
+    std::vector<uint64_t> offsets(levelCount);
+    uint64_t offset = dfdOffset + dfd.size();
+    for (int level = int(levelCount) - 1; level >= 0; --level) {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        offsets[level] = offset;
+        offset += image.levels[level].size();
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("WriteKTX2: cannot open " + path);
+    auto put32 = [&](uint32_t v) { file.write(reinterpret_cast<const char *>(&v), 4); };
+    auto put64 = [&](uint64_t v) { file.write(reinterpret_cast<const char *>(&v), 8); };
+    file.write(reinterpret_cast<const char *>(kKTX2Identifier), 12);
+    put32(vkFormat(image.format, image.bSRGB));
+    put32(1); // typeSize
+    put32(uint32_t(image.width));
+    put32(uint32_t(image.height));
+    put32(0); // pixelDepth
+    put32(0); // layerCount
+    put32(1); // faceCount
+    put32(levelCount);
+    put32(0); // no supercompression
+    put32(dfdOffset);
+    put32(uint32_t(dfd.size()));
+    put32(0); // no key/value data
+    put32(0);
+    put64(0); // no supercompression global data
+    put64(0);
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        put64(offsets[level]);
+        put64(image.levels[level].size());
+        put64(image.levels[level].size());
+    }
+    file.write(reinterpret_cast<const char *>(dfd.data()), dfd.size());
+    for (int level = int(levelCount) - 1; level >= 0; --level) {
+        while (uint64_t(file.tellp()) < offsets[level]) file.put(0);
+        file.write(reinterpret_cast<const char *>(image.levels[level].data()), image.levels[level].size());
+    }
+    if (!file.good())
+        throw std::runtime_error("WriteKTX2: failed to write " + path);
+}
+
+CompressedImage SC::ReadKTX2(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("ReadKTX2: cannot open " + path);
+    uint8_t identifier[12];
+    uint32_t header[13];
+    file.read(reinterpret_cast<char *>(identifier), 12);
+    file.read(reinterpret_cast<char *>(header), sizeof(header));
+    uint64_t sgd[2];
+    file.read(reinterpret_cast<char *>(sgd), sizeof(sgd));
+    if (!file.good() || std::memcmp(identifier, kKTX2Identifier, 12) != 0)
+        throw std::runtime_error("ReadKTX2: not a KTX2 file: " + path);
+
+    CompressedImage image;
+    switch (header[0]) {
+        case 131: image.format = BlockFormat::BC1; break;
+        case 132: image.format = BlockFormat::BC1; image.bSRGB = true; break;
+        case 137: image.format = BlockFormat::BC3; break;
+        case 138: image.format = BlockFormat::BC3; image.bSRGB = true; break;
+        case 141: image.format = BlockFormat::BC5; break;
+        default:
+            throw std::runtime_error("ReadKTX2: unsupported vkFormat " + std::to_string(header[0]) + " in " + path);
+    }
+    if (header[8] != 0)
+        throw std::runtime_error("ReadKTX2: supercompressed files are not supported: " + path);
+    image.width = int(header[2]);
+    image.height = int(header[3]);
+    const uint32_t levelCount = std::max(1u, header[7]);
+
+    std::vector<uint64_t> index(levelCount * 3);
+    file.read(reinterpret_cast<char *>(index.data()), index.size() * 8);
+    image.levels.resize(levelCount);
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        const int w = std::max(1, image.width >> level), h = std::max(1, image.height >> level);
+        const uint64_t expected = uint64_t((w + 3) / 4) * ((h + 3) / 4) * BlockBytes(image.format);
+        if (index[level * 3 + 1] != expected)
+            throw std::runtime_error("ReadKTX2: level " + std::to_string(level) + " has an unexpected size in " + path);
+        image.levels[level].resize(expected);
+        file.seekg(std::streamoff(index[level * 3]));
+        file.read(reinterpret_cast<char *>(image.levels[level].data()), expected);
+    }
+    if (!file.good())
+        throw std::runtime_error("ReadKTX2: truncated file " + path);
+    return image;
+}
+
+uint64_t SC::HashFile(const std::string &path, uint64_t hash) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("HashFile: cannot open " + path);
+    char buffer[1 << 16];
+    while (file.read(buffer, sizeof(buffer)) || file.gcount() > 0) {
+        const std::streamsize n = file.gcount();
+        for (std::streamsize i = 0; i < n; ++i) {
+            hash ^= uint8_t(buffer[i]);
+            hash *= 1099511628211ull;
+        }
+        if (!file) break;
+    }
+    return hash;
+}
+
+uint64_t SC::HashTextureSource(const std::string &path, BlockFormat format, bool bSRGB) {
+    uint64_t hash = HashFile(path);
+    for (uint8_t byte : {uint8_t(format), uint8_t(bSRGB), uint8_t(kEncoderVersion)}) {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string SC::CacheFileName(uint64_t hash) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.ktx2", static_cast<unsigned long long>(hash));
+    return name;
+}
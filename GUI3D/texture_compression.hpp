@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SC {
+    /// Block-compressed formats. All use 4x4 texel blocks.
+    enum class BlockFormat {
+        BC1, // RGB, 8 bytes per block (6:1 vs RGB8). Color maps without alpha.
+        BC3, // RGBA, 16 bytes per block (4:1 vs RGBA8). Color maps with alpha.
+        BC5  // RG, 16 bytes per block. Tangent-space normal maps, z is reconstructed in the shader.
+    };
+
+    struct CompressedImage {
+        BlockFormat format = BlockFormat::BC1;
+        bool bSRGB = false;
+        int width = 0, height = 0;
+        std::vector<std::vector<uint8_t>> levels; // mip 0 first
+    };
+
+    /**
+     Encode an RGBA8 image (row-major, top row first) with a full mip chain. Mips are box filtered, in linear
+     space if bSRGB. BC5 encodes the red and green channels.
+     @param threads Number of threads the block rows are split over. 0 uses all hardware threads.
+     */
+    CompressedImage CompressImage(const uint8_t *rgba, int width, int height, BlockFormat format, bool bSRGB,
+                                  bool bMipmaps = true, int threads = 0);
+
+    /// Decode one level back to RGBA8, e.g. to measure the error of the encoder.
+    std::vector<uint8_t> DecompressLevel(const CompressedImage &image, int level);
+
+    /// KTX2 container with the mips stored smallest first, as the specification requires. Throws on I/O errors.
+    void WriteKTX2(const std::string &path, const CompressedImage &image);
+    CompressedImage ReadKTX2(const std::string &path);
+
+    /// FNV-1a 64 of the file content, continued from hash. Throws if the file cannot be opened.
+    uint64_t HashFile(const std::string &path, uint64_t hash = 14695981039346656037ull);
+    /// FNV-1a 64 of the file content, the format and the encoder version. The name of the file in the cache.
+    uint64_t HashTextureSource(const std::string &path, BlockFormat format, bool bSRGB);
+    std::string CacheFileName(uint64_t hash);
+
+    size_t BlockBytes(BlockFormat format);
+    const char *toString(BlockFormat format);
+}
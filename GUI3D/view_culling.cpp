@@ -0,0 +1,68 @@
+#include "view_culling.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace SC;
+
+Frustum Frustum::fromMatrix(const float *m) {
+    // Gribb & Hartmann: the planes are sums and differences of the rows of the matrix
+    auto row = [m](int r, int c) { return m[c * 4 + r]; };
+    Frustum f;
+    for (int i = 0; i < 3; ++i) {
+        for (int c = 0; c < 4; ++c) {
+            f.planes[i * 2][c] = row(3, c) + row(i, c);
+            f.planes[i * 2 + 1][c] = row(3, c) - row(i, c);
+        }
+    }
+    for (auto &p : f.planes) {
+        const float length = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        if (length > 0)
+            for (float &v : p) v /= length;
+    }
+    return f;
+}
+
+CullItem CullItem::fromBounds(const float *boundsMin, const float *boundsMax, const float *m, uint32_t sortKey) {
+    float c[3], r2 = 0;
+    for (int i = 0; i < 3; ++i) {
+        c[i] = (boundsMin[i] + boundsMax[i]) * 0.5f;
+        r2 += (boundsMax[i] - c[i]) * (boundsMax[i] - c[i]);
+    }
+    CullItem item;
+    for (int i = 0; i < 3; ++i)
+        item.center[i] = m[i] * c[0] + m[4 + i] * c[1] + m[8 + i] * c[2] + m[12 + i];
+    float scale2 = 0;
+    for (int col = 0; col < 3; ++col)
+        scale2 = std::max(scale2, m[col * 4] * m[col * 4] + m[col * 4 + 1] * m[col * 4 + 1] + m[col * 4 + 2] * m[col * 4 + 2]);
+    item.radius = std::sqrt(r2 * scale2);
+    item.sortKey = sortKey;
+    return item;
+}
+
+void MultiViewCuller::setViews(const float *viewProjections, int numViews) {
+    numViews = std::min(std::max(numViews, 0), int(kMaxViews));
+    frustums_.resize(numViews);
+    for (int v = 0; v < numViews; ++v) frustums_[v] = Frustum::fromMatrix(viewProjections + v * 16);
+    lists_.resize(numViews);
+}
+
+void MultiViewCuller::cull(const CullItem *items, int numItems) {
+    const int numViews = this->numViews();
+    order_.resize(numItems);
+    for (int i = 0; i < numItems; ++i) order_[i] = uint32_t(i);
+    std::stable_sort(order_.begin(), order_.end(),
+                     [items](uint32_t a, uint32_t b) { return items[a].sortKey < items[b].sortKey; });
+
+    masks_.assign(numItems, 0);
+    for (auto &list : lists_) list.clear();
+    for (uint32_t i : order_) {
+        uint32_t mask = 0;
+        for (int v = 0; v < numViews; ++v)
+            if (frustums_[v].intersectsSphere(items[i].center, items[i].radius)) {
+                mask |= 1u << v;
+                lists_[v].push_back(i);
+            }
+        masks_[i] = mask;
+    }
+}
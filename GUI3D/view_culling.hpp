@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace SC {
+    /// Six planes (a, b, c, d) with normals pointing inside, normalized so a*x + b*y + c*z + d is a distance.
+    struct Frustum {
+        float planes[6][4];
+        /// @param viewProjection column-major 4x4 (OpenGL clip space).
+        static Frustum fromMatrix(const float *viewProjection);
+        bool intersectsSphere(const float *center, float radius) const {
+            for (const auto &p : planes)
+                if (p[0] * center[0] + p[1] * center[1] + p[2] * center[2] + p[3] < -radius) return false;
+            return true;
+        }
+    };
+
+    /// A drawable as the culler sees it: a world-space bounding sphere and a key the draw order is sorted by
+    /// (e.g. shader, then material), so state changes are grouped in every view.
+    struct CullItem {
+        float center[3];
+        float radius;
+        uint32_t sortKey;
+
+        /// Sphere around the box [boundsMin, boundsMax] after the column-major model matrix.
+        static CullItem fromBounds(const float *boundsMin, const float *boundsMax, const float *model,
+                                   uint32_t sortKey = 0);
+    };
+
+    /**
+     Culls a scene for several views (split-screen viewports, shadow cascades) in one traversal. Every item is
+     visited once and tested against all frustums, and the items are sorted by key once; the per-view draw
+     lists are filtered from that shared order, so adding a view costs one sphere test per item rather than
+     another traversal, transform and sort.
+     */
+    class MultiViewCuller {
+    public:
+        static const int kMaxViews = 32;
+
+        /// @param viewProjections numViews column-major 4x4 matrices, one after the other.
+        void setViews(const float *viewProjections, int numViews);
+        void cull(const CullItem *items, int numItems);
+
+        int numViews() const { return int(frustums_.size()); }
+        /// Indices into the items, ordered by sortKey (stable).
+        const std::vector<uint32_t> &visible(int view) const { return lists_[view]; }
+        /// Bit v is set if the item is visible in view v.
+        const std::vector<uint32_t> &masks() const { return masks_; }
+
+    private:
+        std::vector<Frustum> frustums_;
+        std::vector<uint32_t> order_, masks_;
+        std::vector<std::vector<uint32_t>> lists_;
+    };
+}
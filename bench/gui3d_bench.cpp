@@ -0,0 +1,448 @@
+// Frame times of the whole viewer on a scripted scene, for tracking regressions between commits.
+// Builds N meshes (scene objects with clustered lighting), M streamed points, K text glyphs, T trajectory
+// poses (every 20th a keyframe) and L point lights, loads them through the ingest queues, then renders a fixed
+// number of frames on a hidden window while the camera orbits the scene, one revolution per run. Reports CPU
+// ms per frame (drawUI + drawGL), frame ms (including the swap) and GPU ms (timestamp queries around the
+// frame) at p50/p95/p99, GL draws per frame (multi-draws by sub-draw) and memory, as JSON.
+// --replay takes the camera from a recording (GUI3D::startRecording, control+R in the viewer) instead,
+// frame-locked at 60 Hz, for as many frames as it lasts.
+// --software asks Mesa for its software rasterizer. Without a display, run it under e.g. xvfb-run.
+// Usage: gui3d_bench [--scene small|medium|large] [--meshes N] [--points M] [--glyphs K] [--trajectory T]
+//                    [--lights L] [--frames F] [--warmup W] [--size WxH] [--replay file] [--software]
+//                    [--output file.json]
+#include "../GUI3D/GUI3D.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace {
+    struct Scene {
+        std::string name = "medium";
+        int meshes = 1000, glyphs = 2000, trajectory = 10000, lights = 64;
+        size_t points = 1000000;
+    };
+
+    Scene preset(const std::string &name) {
+        Scene scene;
+        scene.name = name;
+        if (name == "small") {
+            scene.meshes = 100;
+            scene.points = 100000;
+            scene.glyphs = 500;
+            scene.trajectory = 1000;
+            scene.lights = 16;
+        } else if (name == "large") {
+            scene.meshes = 10000;
+            scene.points = 4000000;
+            scene.glyphs = 8000;
+            scene.trajectory = 50000;
+            scene.lights = 256;
+        } else if (name != "medium") {
+            throw std::runtime_error("Unknown scene \"" + name + "\", use small, medium or large.");
+        }
+        return scene;
+    }
+
+    // Every draw call of the process goes through the gl3w function table, ImGui's included. Counting wrappers
+    // are swapped in once the context exists. A multi-draw counts once per sub-draw (drawcount), as in the
+    // GeometryArena statistics, so the number is the same with and without merged geometry; the CPU time shows
+    // what the batching saves.
+    size_t drawCalls = 0;
+    PFNGLDRAWARRAYSPROC drawArrays;
+    PFNGLDRAWELEMENTSPROC drawElements;
+    PFNGLDRAWARRAYSINSTANCEDPROC drawArraysInstanced;
+    PFNGLDRAWELEMENTSINSTANCEDPROC drawElementsInstanced;
+    PFNGLDRAWELEMENTSBASEVERTEXPROC drawElementsBaseVertex;
+    PFNGLMULTIDRAWELEMENTSBASEVERTEXPROC multiDrawElementsBaseVertex;
+    PFNGLMULTIDRAWELEMENTSINDIRECTPROC multiDrawElementsIndirect;
+
+    void APIENTRY countDrawArrays(GLenum mode, GLint first, GLsizei count) {
+        drawCalls++;
+        drawArrays(mode, first, count);
+    }
+    void APIENTRY countDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices) {
+        drawCalls++;
+        drawElements(mode, count, type, indices);
+    }
+    void APIENTRY countDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+        drawCalls++;
+        drawArraysInstanced(mode, first, count, instances);
+    }
+    void APIENTRY countDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void *indices,
+                                             GLsizei instances) {
+        drawCalls++;
+        drawElementsInstanced(mode, count, type, indices, instances);
+    }
+    void APIENTRY countDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void *indices,
+                                              GLint baseVertex) {
+        drawCalls++;
+        drawElementsBaseVertex(mode, count, type, indices, baseVertex);
+    }
+    void APIENTRY countMultiDrawElementsBaseVertex(GLenum mode, const GLsizei *count, GLenum type,
+                                                   const void *const *indices, GLsizei drawCount,
+                                                   const GLint *baseVertex) {
+        drawCalls += size_t(drawCount);
+        multiDrawElementsBaseVertex(mode, count, type, indices, drawCount, baseVertex);
+    }
+    void APIENTRY countMultiDrawElementsIndirect(GLenum mode, GLenum type, const void *indirect, GLsizei drawCount,
+                                                 GLsizei stride) {
+        drawCalls += size_t(drawCount);
+        multiDrawElementsIndirect(mode, type, indirect, drawCount, stride);
+    }
+
+    void hookDrawCalls() {
+        drawArrays = gl3wProcs.gl.DrawArrays;
+        drawElements = gl3wProcs.gl.DrawElements;
+        drawArraysInstanced = gl3wProcs.gl.DrawArraysInstanced;
+        drawElementsInstanced = gl3wProcs.gl.DrawElementsInstanced;
+        drawElementsBaseVertex = gl3wProcs.gl.DrawElementsBaseVertex;
+        multiDrawElementsBaseVertex = gl3wProcs.gl.MultiDrawElementsBaseVertex;
+        multiDrawElementsIndirect = gl3wProcs.gl.MultiDrawElementsIndirect;
+        gl3wProcs.gl.DrawArrays = countDrawArrays;
+        gl3wProcs.gl.DrawElements = countDrawElements;
+        gl3wProcs.gl.DrawArraysInstanced = countDrawArraysInstanced;
+        gl3wProcs.gl.DrawElementsInstanced = countDrawElementsInstanced;
+        gl3wProcs.gl.DrawElementsBaseVertex = countDrawElementsBaseVertex;
+        gl3wProcs.gl.MultiDrawElementsBaseVertex = countMultiDrawElementsBaseVertex;
+        if (multiDrawElementsIndirect) // GL 4.3 or ARB_multi_draw_indirect
+            gl3wProcs.gl.MultiDrawElementsIndirect = countMultiDrawElementsIndirect;
+    }
+
+    struct Summary {
+        double mean = 0, p50 = 0, p95 = 0, p99 = 0, max = 0;
+    };
+
+    /// Nearest-rank percentiles.
+    Summary summarize(std::vector<double> samples) {
+        Summary summary;
+        if (samples.empty()) return summary;
+        std::sort(samples.begin(), samples.end());
+        auto percentile = [&](double p) {
+            const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * samples.size()));
+            return samples[std::max<size_t>(rank, 1) - 1];
+        };
+        for (double sample : samples) summary.mean += sample;
+        summary.mean /= samples.size();
+        summary.p50 = percentile(50);
+        summary.p95 = percentile(95);
+        summary.p99 = percentile(99);
+        summary.max = samples.back();
+        return summary;
+    }
+
+    long peakResidentKB() {
+#ifdef _WIN32
+        return -1;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024; // bytes
+#else
+        return usage.ru_maxrss;
+#endif
+#endif
+    }
+
+    /// Free video memory in KB if the driver reports it (GL_NVX_gpu_memory_info), otherwise -1.
+    long availableVideoMemoryKB() {
+        if (!glfwExtensionSupported("GL_NVX_gpu_memory_info")) return -1;
+        GLint kb = 0;
+        glGetIntegerv(0x9049, &kb); // GL_GPU_MEMORY_INFO_CURRENT_AVAILABLE_VIDMEM_NVX
+        return kb;
+    }
+
+    std::string jsonString(const char *text) {
+        std::string out = "\"";
+        for (const char *c = text ? text : ""; *c; ++c) {
+            if (*c == '"' || *c == '\\') out += '\\';
+            if (static_cast<unsigned char>(*c) >= 0x20) out += *c;
+        }
+        return out + "\"";
+    }
+
+    void writeSummary(FILE *file, const char *name, const Summary &summary, const char *suffix) {
+        fprintf(file, "  \"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+                name, summary.mean, summary.p50, summary.p95, summary.p99, summary.max, suffix);
+    }
+
+    class BenchGUI : public SC::GUI3D {
+    public:
+        BenchGUI(const Scene &scene, int width, int height)
+                : GUI3D("gui3d_bench", width, height), scene_(scene), cpuMs_(0) {}
+
+        /// Meshes, lights and the glyph text are set up directly; points and poses are queued on ingest().
+        void build() {
+            std::mt19937 rng(7);
+            std::uniform_real_distribution<float> unit(0.f, 1.f);
+            const int side = std::max(1, static_cast<int>(std::ceil(std::sqrt(double(scene_.meshes)))));
+            const float spacing = 3.f;
+            extent_ = std::max(10.f, side * spacing * 0.5f);
+
+            enableClusteredLights();
+            auto &lights = getClusteredLights()->lights();
+            for (int i = 0; i < scene_.lights; ++i) {
+                SC::ClusterLight light{};
+                light.position[0] = (unit(rng) * 2 - 1) * extent_;
+                light.position[1] = 0.5f + unit(rng) * 3.f;
+                light.position[2] = (unit(rng) * 2 - 1) * extent_;
+                light.radius = spacing * 4;
+                for (float &channel : light.color) channel = 0.3f + 0.7f * unit(rng);
+                light.intensity = 1.f;
+                lights.push_back(light);
+            }
+
+            glObjests["BenchCube"] = makeCube();
+            for (int i = 0; i < scene_.meshes; ++i) {
+                const glm::vec3 position((i % side - side * 0.5f) * spacing, 0.f, (i / side - side * 0.5f) * spacing);
+                const float height = 0.5f + unit(rng);
+                glm::mat4 transform = glm::translate(glm::mat4(1.f), position + glm::vec3(0.f, height, 0.f));
+                transform = glm::scale(transform, glm::vec3(1.f, height, 1.f));
+                addSceneObject("BenchCube", "ClusteredLighting", glm::vec3(-1.f), glm::vec3(1.f), transform);
+            }
+
+            const std::string line = "The quick brown fox jumps over the lazy dog 0123456789. ";
+            for (int i = 0; i < scene_.glyphs; ++i) text_ += line[i % line.size()];
+
+            setMaxStreamedPoints(std::max<size_t>(scene_.points, 1));
+            points_ = 0;
+            poses_ = 0;
+        }
+
+        /// Render unmeasured frames until the queued points and poses are on the GPU.
+        void load(int warmup) {
+            std::mt19937 rng(11);
+            std::uniform_real_distribution<float> unit(0.f, 1.f);
+            setUploadBudget(64 << 20);
+            const int posesPerFrame = 8192, batchesPerFrame = 32;
+            const size_t pointsPerBatch = 16384;
+            while (points_ < scene_.points || poses_ < scene_.trajectory ||
+                   ingest().statistics().points < scene_.points ||
+                   ingest().statistics().poses < static_cast<size_t>(scene_.trajectory)) {
+                for (int i = 0; i < posesPerFrame && poses_ < scene_.trajectory; ++i, ++poses_) {
+                    const float t = float(poses_) / std::max(1, scene_.trajectory);
+                    SC::PoseSample pose;
+                    pose.position[0] = std::cos(t * 12.566f) * extent_ * 0.8f;
+                    pose.position[1] = 1.f + 4.f * t;
+                    pose.position[2] = std::sin(t * 12.566f) * extent_ * 0.8f;
+                    pose.time = t;
+                    pose.keyframeId = poses_ % 20 == 0 ? poses_ / 20 : -1;
+                    ingest().pushPose(pose);
+                }
+                for (int i = 0; i < batchesPerFrame && points_ < scene_.points; ++i) {
+                    const size_t count = std::min(pointsPerBatch, scene_.points - points_);
+                    auto batch = ingest().acquireBatch();
+                    batch->positions.resize(count * 3);
+                    batch->colors.resize(count);
+                    for (size_t p = 0; p < count; ++p) {
+                        batch->positions[p * 3 + 0] = (unit(rng) * 2 - 1) * extent_;
+                        batch->positions[p * 3 + 1] = unit(rng) * 8.f;
+                        batch->positions[p * 3 + 2] = (unit(rng) * 2 - 1) * extent_;
+                        batch->colors[p] = 0xFF000000u | static_cast<uint32_t>(rng() & 0xFFFFFFu);
+                    }
+                    ingest().submitBatch(std::move(batch));
+                    points_ += count;
+                }
+                orbit(0.f);
+                renderFrame();
+                const SC::DataIngest::Statistics statistics = ingest().statistics();
+                if (statistics.posesDropped || statistics.batchesDropped)
+                    throw std::runtime_error("The ingest queues overflowed while loading the scene.");
+            }
+            setUploadBudget(4 << 20);
+            for (int i = 0; i < warmup; ++i) {
+                orbit(0.f);
+                renderFrame();
+            }
+        }
+
+        void measure(int frames, std::vector<double> &cpuMs, std::vector<double> &frameMs, std::vector<double> &gpuMs,
+                     std::vector<double> &draws, std::vector<double> &sceneDraws) {
+            std::vector<GLuint> queries(2 * frames);
+            glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+            glFinish();
+            for (int i = 0; i < frames; ++i) {
+                if (!isPlaying()) orbit(float(i) / frames);
+                cpuMs_ = 0;
+                drawCalls = 0;
+                const auto start = std::chrono::steady_clock::now();
+                glQueryCounter(queries[2 * i], GL_TIMESTAMP);
+                renderFrame();
+                glQueryCounter(queries[2 * i + 1], GL_TIMESTAMP);
+                frameMs.push_back(
+                        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+                cpuMs.push_back(cpuMs_);
+                draws.push_back(double(drawCalls));
+                sceneDraws.push_back(double(sceneDrawCount()));
+            }
+            glFinish();
+            for (int i = 0; i < frames; ++i) {
+                GLuint64 begin = 0, end = 0;
+                glGetQueryObjectui64v(queries[2 * i], GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(queries[2 * i + 1], GL_QUERY_RESULT, &end);
+                gpuMs.push_back((end - begin) * 1e-6);
+            }
+            glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+        }
+
+    protected:
+        void drawUI() override {
+            const auto start = std::chrono::steady_clock::now();
+            GUI3D::drawUI();
+            cpuMs_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        void drawGL() override {
+            const auto start = std::chrono::steady_clock::now();
+            GUI3D::drawGL();
+            cpuMs_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        void drawOverlay() override {
+            GUI3D::drawOverlay();
+            if (text_.empty()) return;
+            // rows of 80 glyphs from the top of the window
+            glDisable(GL_DEPTH_TEST);
+            const size_t perRow = 80;
+            for (size_t begin = 0, row = 0; begin < text_.size(); begin += perRow, ++row)
+                RenderText(glVertexArrays["textVAO"], glBuffers["textVBO"], glShaders["Text"],
+                           text_.substr(begin, perRow), 10.f, window_->runtimeHeight - 20.f - 12.f * (row % 60),
+                           0.3f, glm::vec3(0.9f));
+            glEnable(GL_DEPTH_TEST);
+        }
+
+    private:
+        Scene scene_;
+        float extent_ = 10.f;
+        std::string text_;
+        size_t points_;
+        int poses_;
+        double cpuMs_;
+
+        /// Camera on a circle around the scene, looking at its center. t in [0, 1) is one revolution.
+        void orbit(float t) {
+            auto *camera = dynamic_cast<SC::CameraControl *>(glCam->camera_control_.get());
+            if (!camera) return;
+            const float yaw = t * 360.f, pitch = -30.f, distance = extent_ * 1.5f + 10.f;
+            const glm::vec3 front(std::cos(glm::radians(yaw)) * std::cos(glm::radians(pitch)),
+                                  std::sin(glm::radians(pitch)),
+                                  std::sin(glm::radians(yaw)) * std::cos(glm::radians(pitch)));
+            const glm::vec3 position = -front * distance;
+            camera->setCamPose(0.f, yaw, pitch, position.x, position.y, position.z);
+        }
+
+        static glUtil::Mesh *makeCube() {
+            std::vector<glUtil::Vertex> vertices;
+            std::vector<unsigned int> indices;
+            for (int axis = 0; axis < 3; ++axis)
+                for (float sign : {-1.f, 1.f}) {
+                    glm::vec3 normal(0.f), u(0.f), v(0.f);
+                    normal[axis] = sign;
+                    u[(axis + 1) % 3] = 1.f;
+                    v[(axis + 2) % 3] = sign;
+                    const auto base = static_cast<unsigned int>(vertices.size());
+                    for (int corner = 0; corner < 4; ++corner) {
+                        const float a = corner & 1 ? 1.f : -1.f, b = corner & 2 ? 1.f : -1.f;
+                        vertices.emplace_back(normal + u * a + v * b, normal);
+                    }
+                    for (unsigned int index : {0u, 1u, 3u, 0u, 3u, 2u}) indices.push_back(base + index);
+                }
+            return new glUtil::Mesh(vertices, indices, {});
+        }
+    };
+}
+
+int main(int argc, char **argv) {
+    Scene scene;
+    int frames = 300, warmup = 30, width = 1280, height = 720;
+    bool bSoftware = false;
+    std::string output, replay;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::runtime_error(arg + " needs a value.");
+                return argv[++i];
+            };
+            if (arg == "--scene") scene = preset(value());
+            else if (arg == "--meshes") scene.meshes = std::stoi(value());
+            else if (arg == "--points") scene.points = std::stoull(value());
+            else if (arg == "--glyphs") scene.glyphs = std::stoi(value());
+            else if (arg == "--trajectory") scene.trajectory = std::stoi(value());
+            else if (arg == "--lights") scene.lights = std::stoi(value());
+            else if (arg == "--frames") frames = std::max(1, std::stoi(value()));
+            else if (arg == "--warmup") warmup = std::stoi(value());
+            else if (arg == "--size") {
+                if (sscanf(value().c_str(), "%dx%d", &width, &height) != 2)
+                    throw std::runtime_error("--size expects WxH, e.g. 1280x720.");
+            }
+            else if (arg == "--replay") replay = value();
+            else if (arg == "--software") bSoftware = true;
+            else if (arg == "--output") output = value();
+            else throw std::runtime_error("Unknown argument " + arg);
+        }
+    } catch (const std::exception &e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+#ifndef _WIN32
+    if (bSoftware) setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+#endif
+
+    SC::GUI_base::setHeadless(true);
+    BenchGUI gui(scene, width, height);
+    hookDrawCalls();
+    const long videoMemoryBefore = availableVideoMemoryKB();
+    const auto loadStart = std::chrono::steady_clock::now();
+    gui.build();
+    gui.load(warmup);
+    const double loadMs =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+
+    if (!replay.empty()) {
+        try {
+            frames = static_cast<int>(gui.playRecording(replay));
+        } catch (const std::exception &e) {
+            fprintf(stderr, "%s\n", e.what());
+            return 1;
+        }
+    }
+
+    std::vector<double> cpuMs, frameMs, gpuMs, draws, sceneDraws;
+    gui.measure(frames, cpuMs, frameMs, gpuMs, draws, sceneDraws);
+    const long videoMemoryAfter = availableVideoMemoryKB();
+
+    FILE *file = output.empty() ? stdout : fopen(output.c_str(), "w");
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", output.c_str());
+        return 1;
+    }
+    fprintf(file, "{\n");
+    fprintf(file, "  \"scene\": {\"name\": %s, \"meshes\": %d, \"points\": %zu, \"glyphs\": %d, \"trajectory\": %d, "
+                  "\"lights\": %d},\n", jsonString(scene.name.c_str()).c_str(), scene.meshes, scene.points,
+            scene.glyphs, scene.trajectory, scene.lights);
+    fprintf(file, "  \"frames\": %d, \"warmup\": %d, \"width\": %d, \"height\": %d, \"software\": %s, \"replay\": %s,\n",
+            frames, warmup, width, height, bSoftware ? "true" : "false", jsonString(replay.c_str()).c_str());
+    fprintf(file, "  \"renderer\": %s, \"version\": %s,\n",
+            jsonString(reinterpret_cast<const char *>(glGetString(GL_RENDERER))).c_str(),
+            jsonString(reinterpret_cast<const char *>(glGetString(GL_VERSION))).c_str());
+    fprintf(file, "  \"load_ms\": %.3f,\n", loadMs);
+    writeSummary(file, "cpu_ms", summarize(cpuMs), ",");
+    writeSummary(file, "frame_ms", summarize(frameMs), ",");
+    writeSummary(file, "gpu_ms", summarize(gpuMs), ",");
+    writeSummary(file, "draw_calls", summarize(draws), ",");
+    writeSummary(file, "scene_draws", summarize(sceneDraws), ",");
+    fprintf(file, "  \"memory\": {\"peak_resident_kb\": %ld, \"video_used_kb\": %ld}\n", peakResidentKB(),
+            videoMemoryBefore >= 0 && videoMemoryAfter >= 0 ? videoMemoryBefore - videoMemoryAfter : -1L);
+    fprintf(file, "}\n");
+    if (file != stdout) fclose(file);
+    return 0;
+}
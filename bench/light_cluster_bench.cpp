@@ -0,0 +1,110 @@
+// Cost of clustered light culling vs. evaluating every light per fragment.
+// Bins N random point lights with SC::LightClusters and shades a 320x180 grid of fragments on the CPU, once
+// looping over all lights (the NR_POINT_LIGHTS approach) and once over the fragment's cluster only.
+// Usage: light_cluster_bench [iterations]
+#include "../GUI3D/light_clusters.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace SC;
+
+namespace {
+    const float kNear = 0.1f, kFar = 200.f, kScaleX = 1.f / (16.f / 9.f), kScaleY = 1.f; // 90 deg fovy, 16:9
+    const int kWidth = 320, kHeight = 180;
+
+    struct Fragment { float x, y, z, depth; int cluster; };
+
+    std::vector<ClusterLight> makeLights(int count) {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> x(-60.f, 60.f), y(-2.f, 10.f), z(-150.f, -1.f), c(0.2f, 1.f);
+        std::vector<ClusterLight> lights(count);
+        for (auto &light : lights)
+            light = {{x(rng), y(rng), z(rng)}, 4.f, {c(rng), c(rng), c(rng)}, 1.f};
+        return lights;
+    }
+
+    /// A ground plane at y = -1.5 seen from the origin; the upper rows hit a wall at the far plane.
+    std::vector<Fragment> makeFragments(const LightClusters &clusters) {
+        std::vector<Fragment> fragments;
+        const float sliceScale = clusters.depthSlices() / std::log(kFar / kNear);
+        for (int py = 0; py < kHeight; ++py)
+            for (int px = 0; px < kWidth; ++px) {
+                const float ndcX = (px + 0.5f) / kWidth * 2.f - 1.f, ndcY = (py + 0.5f) / kHeight * 2.f - 1.f;
+                const float dx = ndcX / kScaleX, dy = ndcY / kScaleY; // ray at depth 1
+                float depth = dy < -1e-3f ? std::min(1.5f / -dy, 150.f) : 150.f;
+                const int tx = px * clusters.tilesX() / kWidth, ty = py * clusters.tilesY() / kHeight;
+                int tz = int(std::floor(std::log(depth / kNear) * sliceScale));
+                tz = std::min(std::max(tz, 0), clusters.depthSlices() - 1);
+                fragments.push_back({dx * depth, dy * depth, -depth, depth,
+                                     (tz * clusters.tilesY() + ty) * clusters.tilesX() + tx});
+            }
+        return fragments;
+    }
+
+    inline float shade(const ClusterLight &light, const Fragment &f) {
+        const float dx = light.position[0] - f.x, dy = light.position[1] - f.y, dz = light.position[2] - f.z;
+        const float d2 = dx * dx + dy * dy + dz * dz;
+        if (d2 >= light.radius * light.radius) return 0.f;
+        const float w = 1.f - d2 * d2 / (light.radius * light.radius * light.radius * light.radius);
+        return light.intensity * w * w / (d2 + 1.f);
+    }
+
+    template<typename F>
+    double timeMs(int iterations, F &&f) {
+        f(); // warm up
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+    }
+}
+
+int main(int argc, char **argv) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 5;
+    const float view[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+    const int counts[] = {4, 64, 256, 1024, 4096, 16384};
+
+    LightClusters clusters(16, 9, 24);
+    const std::vector<Fragment> fragments = makeFragments(clusters);
+
+    printf("%8s %10s %12s %12s %14s %14s %10s\n", "lights", "bin ms", "avg/frag", "max/cluster",
+           "brute ms", "clustered ms", "max diff");
+    for (int count : counts) {
+        const std::vector<ClusterLight> lights = makeLights(count);
+        const double binMs = timeMs(iterations, [&] {
+            clusters.build(lights.data(), count, view, kScaleX, kScaleY, kNear, kFar);
+        });
+
+        std::vector<float> brute(fragments.size()), clustered(fragments.size());
+        const double bruteMs = timeMs(iterations, [&] {
+            for (size_t i = 0; i < fragments.size(); ++i) {
+                float sum = 0;
+                for (const auto &light : lights) sum += shade(light, fragments[i]);
+                brute[i] = sum;
+            }
+        });
+        size_t evaluated = 0;
+        const double clusteredMs = timeMs(iterations, [&] {
+            evaluated = 0;
+            const auto &ranges = clusters.clusterRanges();
+            const auto &indices = clusters.lightIndices();
+            for (size_t i = 0; i < fragments.size(); ++i) {
+                const uint32_t offset = ranges[fragments[i].cluster * 2], n = ranges[fragments[i].cluster * 2 + 1];
+                float sum = 0;
+                for (uint32_t k = 0; k < n; ++k) sum += shade(lights[indices[offset + k]], fragments[i]);
+                clustered[i] = sum;
+                evaluated += n;
+            }
+        });
+
+        float diff = 0;
+        for (size_t i = 0; i < brute.size(); ++i) diff = std::max(diff, std::abs(brute[i] - clustered[i]));
+        printf("%8d %10.3f %12.2f %12d %14.3f %14.3f %10.2e\n", count, binMs, double(evaluated) / fragments.size(),
+               clusters.maxLightsPerCluster(), bruteMs, clusteredMs, diff);
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+// LOD generation and selection on a multi-million triangle scene.
+// Builds a grid of lumpy spheres (one welded, optimized mesh each), generates a LOD chain per mesh with
+// SC::SimplifyMesh and flies a camera through the scene, selecting a level per object every frame from the
+// projected error, like glUtil::Model::selectLod. Reports simplification time and error per level, triangles
+// submitted per frame and the number of level switches with and without hysteresis.
+// Usage: lod_bench [objects] [rings]
+#include "../GUI3D/mesh_optimizer.hpp"
+#include "../GUI3D/mesh_simplifier.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace SC;
+
+namespace {
+    struct Vertex { float position[3], normal[3], uv[2]; };
+
+    struct Lod { size_t indexCount; float error; };
+
+    struct Object {
+        float center[3];
+        float radius;
+        std::vector<Lod> lods;
+        int lod = 0, lodNoHysteresis = 0;
+    };
+
+    void makeSphere(int rings, float lumps, std::vector<Vertex> &vertices, std::vector<uint32_t> &indices) {
+        const int segments = rings * 2;
+        vertices.clear();
+        indices.clear();
+        for (int i = 0; i <= rings; ++i)
+            for (int j = 0; j <= segments; ++j) {
+                const float theta = float(M_PI) * i / rings, phi = 2.f * float(M_PI) * j / segments;
+                const float r = 1.f + 0.2f * std::sin(lumps * theta) * std::sin(lumps * phi);
+                const float n[3] = {std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+                vertices.push_back({{r * n[0], r * n[1], r * n[2]}, {n[0], n[1], n[2]},
+                                    {float(j) / segments, float(i) / rings}});
+            }
+        for (int i = 0; i < rings; ++i)
+            for (int j = 0; j < segments; ++j) {
+                const uint32_t a = i * (segments + 1) + j, b = a + segments + 1;
+                indices.insert(indices.end(), {a, b, b + 1, a, b + 1, a + 1});
+            }
+        std::vector<uint32_t> remap(vertices.size());
+        const size_t unique = GenerateVertexRemap(remap.data(), indices.data(), indices.size(), vertices.data(),
+                                                  vertices.size(), sizeof(Vertex));
+        std::vector<Vertex> welded(unique);
+        RemapVertices(welded.data(), vertices.data(), vertices.size(), sizeof(Vertex), remap.data());
+        RemapIndices(indices.data(), indices.data(), indices.size(), remap.data());
+        vertices.swap(welded);
+    }
+
+    double nowMs() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+int main(int argc, char **argv) {
+    const int numObjects = argc > 1 ? std::atoi(argv[1]) : 400;
+    const int rings = argc > 2 ? std::atoi(argv[2]) : 100;
+    const int levels = 6;
+    const float kThresholdPixels = 1.f, kHysteresis = 0.25f;
+    const float kFovy = 45.f * float(M_PI) / 180.f, kHeight = 1080.f;
+
+    // One mesh, instanced: simplification is per mesh, selection per object
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    makeSphere(rings, 7.f, vertices, indices);
+    std::vector<Lod> chain{{indices.size(), 0.f}};
+    printf("level %9s %10s %10s\n", "triangles", "error", "time[ms]");
+    printf("%5d %9zu %10.5f %10s\n", 0, indices.size() / 3, 0.f, "-");
+    std::vector<uint32_t> previous = indices, lodIndices(indices.size());
+    for (int level = 1; level < levels; ++level) {
+        float error = 0;
+        const double start = nowMs();
+        const size_t count = SimplifyMesh(lodIndices.data(), previous.data(), previous.size(), vertices.data(),
+                                          vertices.size(), sizeof(Vertex), previous.size() / 2, 1e30f, &error);
+        const double ms = nowMs() - start;
+        if (count >= previous.size() * 9 / 10) break;
+        error = std::max(error, chain.back().error); // each level is simplified from the previous one
+        chain.push_back({count, error});
+        printf("%5d %9zu %10.5f %10.1f\n", level, count / 3, error, ms);
+        previous.assign(lodIndices.begin(), lodIndices.begin() + count);
+    }
+
+    // Objects on a grid in the xz plane, 4 units apart
+    std::vector<Object> objects(numObjects);
+    const int side = int(std::ceil(std::sqrt(double(numObjects))));
+    for (int i = 0; i < numObjects; ++i) {
+        objects[i].center[0] = float(i % side) * 4.f;
+        objects[i].center[1] = 0.f;
+        objects[i].center[2] = -float(i / side) * 4.f;
+        objects[i].radius = 1.2f;
+        objects[i].lods = chain;
+    }
+    size_t fullTriangles = size_t(numObjects) * chain[0].indexCount / 3;
+    printf("scene: %d objects, %zu triangles at full detail\n", numObjects, fullTriangles);
+
+    // Walk along the grid diagonal at eye height, swaying back and forth by a meter so distances keep changing
+    const int frames = 1200;
+    size_t submitted = 0, minSubmitted = ~size_t(0), maxSubmitted = 0, switches = 0, switchesNoHysteresis = 0;
+    double selectMs = 0;
+    std::vector<float> errors(chain.size());
+    for (size_t l = 0; l < chain.size(); ++l) errors[l] = chain[l].error;
+    for (int f = 0; f < frames; ++f) {
+        const float t = float(f) / frames * side * 4.f + 0.7f * std::sin(f * 0.2f);
+        const float eye[3] = {t, 2.f, -t};
+        const double start = nowMs();
+        size_t frameTriangles = 0;
+        for (Object &object : objects) {
+            const float dx = object.center[0] - eye[0], dy = object.center[1] - eye[1], dz = object.center[2] - eye[2];
+            const float distance = std::max(std::sqrt(dx * dx + dy * dy + dz * dz) - object.radius, 0.1f);
+            const float pixelsPerUnit = kHeight / (2.f * distance * std::tan(kFovy / 2.f));
+            const int lod = SelectLod(errors.data(), int(errors.size()), pixelsPerUnit, object.lod, kThresholdPixels,
+                                      kHysteresis);
+            const int lodNoHysteresis = SelectLod(errors.data(), int(errors.size()), pixelsPerUnit,
+                                                  object.lodNoHysteresis, kThresholdPixels, 0.f);
+            switches += lod != object.lod;
+            switchesNoHysteresis += lodNoHysteresis != object.lodNoHysteresis;
+            object.lod = lod;
+            object.lodNoHysteresis = lodNoHysteresis;
+            frameTriangles += object.lods[lod].indexCount / 3;
+        }
+        selectMs += nowMs() - start;
+        submitted += frameTriangles;
+        minSubmitted = std::min(minSubmitted, frameTriangles);
+        maxSubmitted = std::max(maxSubmitted, frameTriangles);
+    }
+    printf("submitted per frame: avg %zu (%.1f%% of full), min %zu, max %zu\n", submitted / frames,
+           100.0 * submitted / frames / fullTriangles, minSubmitted, maxSubmitted);
+    printf("selection: %.3f ms per frame for %d objects\n", selectMs / frames, numObjects);
+    printf("level switches over %d frames: %zu with hysteresis %.2f, %zu without\n", frames, switches, kHysteresis,
+           switchesNoHysteresis);
+    return 0;
+}
@@ -0,0 +1,100 @@
+// CPU cost of submitting a many-mesh model: one VAO bind and glDrawElements per mesh (Mesh::Draw) against one
+// multi-draw from a glUtil::GeometryArena, with glMultiDrawElementsBaseVertex and, if the driver supports it,
+// glMultiDrawElementsIndirect. Needs a GL context; opens a hidden GLFW window.
+// Usage: merged_draw_bench [meshes] [frames]
+#include <GL/gl3w.h>
+#include <GLFW/glfw3.h>
+#include "../GUI3D/glGeometryArena.hpp"
+#include "../GUI3D/glUtils.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace glUtil;
+
+namespace {
+    const char *kVertexShader = "#version 330 core\n"
+                                "layout (location = 0) in vec3 aPos;\n"
+                                "void main(){ gl_Position = vec4(aPos * 0.01, 1.0); }\n";
+    const char *kFragmentShader = "#version 330 core\n"
+                                  "out vec4 FragColor;\n"
+                                  "void main(){ FragColor = vec4(1.0); }\n";
+
+    /// CPU time of the submission and, after glFinish, of the whole frame.
+    template<typename F>
+    void measure(const char *name, int frames, F &&submit) {
+        submit(); // warm up
+        glFinish();
+        double cpuMs = 0, frameMs = 0;
+        for (int f = 0; f < frames; ++f) {
+            const auto start = std::chrono::steady_clock::now();
+            submit();
+            const auto submitted = std::chrono::steady_clock::now();
+            glFinish();
+            const auto finished = std::chrono::steady_clock::now();
+            cpuMs += std::chrono::duration<double, std::milli>(submitted - start).count();
+            frameMs += std::chrono::duration<double, std::milli>(finished - start).count();
+        }
+        printf("%-28s submit %8.3f ms   frame %8.3f ms\n", name, cpuMs / frames, frameMs / frames);
+    }
+}
+
+int main(int argc, char **argv) {
+    const int numMeshes = argc > 1 ? std::atoi(argv[1]) : 2000;
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 200;
+
+    if (!glfwInit()) return 1;
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    GLFWwindow *window = glfwCreateWindow(256, 256, "merged_draw_bench", nullptr, nullptr);
+    if (!window) {
+        // a 3.3 request may be served with a higher compatible version; without a window there is nothing to do
+        printf("cannot create a GL context\n");
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    if (gl3wInit() != 0) return 1;
+    printf("GL %s, %d meshes (cube, 12 triangles each), %d frames\n", glGetString(GL_VERSION), numMeshes, frames);
+
+    Shader shader;
+    shader.compileShader(kVertexShader, kFragmentShader);
+    std::vector<std::unique_ptr<Mesh>> meshes;
+    for (int i = 0; i < numMeshes; ++i) {
+        meshes.emplace_back(new Mesh(ShapeVertices::cube));
+        meshes.back()->setShader(&shader);
+    }
+    GeometryArena arena;
+    std::vector<int> handles;
+    for (const auto &mesh : meshes) handles.push_back(arena.add(*mesh));
+
+    shader.use();
+    measure("per-mesh Mesh::Draw", frames, [&] {
+        for (const auto &mesh : meshes) mesh->Draw();
+    });
+    arena.setIndirect(false);
+    measure("MultiDrawElementsBaseVertex", frames, [&] {
+        for (size_t i = 0; i < meshes.size(); ++i) arena.queue(handles[i]);
+        arena.flush();
+    });
+    if (arena.isIndirectSupported()) {
+        arena.setIndirect(true);
+        measure("MultiDrawElementsIndirect", frames, [&] {
+            for (size_t i = 0; i < meshes.size(); ++i) arena.queue(handles[i]);
+            arena.flush();
+        });
+    } else {
+        printf("%-28s not supported by this context\n", "MultiDrawElementsIndirect");
+    }
+
+    meshes.clear();
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return 0;
+}
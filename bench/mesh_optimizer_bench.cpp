@@ -0,0 +1,175 @@
+// Effect of the load-time mesh optimization on vertex shading, vertex fetch and overdraw.
+// Builds a lumpy UV sphere as a shuffled triangle soup (an import without welding or reordering), runs the
+// SC::mesh_optimizer stages one by one and reports after each:
+//   ACMR  vertex shader invocations per triangle with a FIFO cache of 16 / 32 entries
+//   fetch average distance in bytes between consecutively fetched vertices
+//   overdraw  shaded fragments per covered pixel, software rasterized from 6 directions with depth test
+// Usage: mesh_optimizer_bench [rings]
+#include "../GUI3D/mesh_optimizer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace SC;
+
+namespace {
+    struct Vertex { float position[3], normal[3], uv[2], tangent[3], bitangent[3]; }; // glUtil::Vertex layout
+
+    Vertex sphereVertex(int ring, int segment, int rings, int segments) {
+        const float theta = float(M_PI) * ring / rings, phi = 2.f * float(M_PI) * segment / segments;
+        const float r = 1.f + 0.45f * std::sin(6 * theta) * std::sin(6 * phi);
+        Vertex v{};
+        const float n[3] = {std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)};
+        for (int k = 0; k < 3; ++k) {
+            v.position[k] = r * n[k];
+            v.normal[k] = n[k];
+        }
+        v.uv[0] = float(segment) / segments;
+        v.uv[1] = float(ring) / rings;
+        return v;
+    }
+
+    std::vector<Vertex> makeSoup(int rings) {
+        const int segments = rings * 2;
+        std::vector<Vertex> soup;
+        for (int i = 0; i < rings; ++i)
+            for (int j = 0; j < segments; ++j) {
+                const Vertex a = sphereVertex(i, j, rings, segments), b = sphereVertex(i + 1, j, rings, segments);
+                const Vertex c = sphereVertex(i + 1, j + 1, rings, segments), d = sphereVertex(i, j + 1, rings, segments);
+                soup.insert(soup.end(), {a, b, c, a, c, d});
+            }
+        // shuffle whole triangles
+        std::mt19937 rng(7);
+        for (size_t t = soup.size() / 3 - 1; t > 0; --t) {
+            const size_t u = std::uniform_int_distribution<size_t>(0, t)(rng);
+            std::swap_ranges(soup.begin() + t * 3, soup.begin() + t * 3 + 3, soup.begin() + u * 3);
+        }
+        return soup;
+    }
+
+    double fetchDistance(const std::vector<uint32_t> &indices) {
+        double sum = 0;
+        for (size_t i = 1; i < indices.size(); ++i)
+            sum += std::abs(double(indices[i]) - double(indices[i - 1])) * sizeof(Vertex);
+        return sum / (indices.size() - 1);
+    }
+
+    /// Orthographic rasterization along +-x, +-y, +-z with back-face culling and a LESS depth test, in
+    /// submission order. Returns shaded fragments / covered pixels.
+    double overdraw(const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices, int size = 256) {
+        size_t shaded = 0, covered = 0;
+        std::vector<float> depth(size * size);
+        for (int view = 0; view < 6; ++view) {
+            const int axis = view / 2;
+            const float sign = view % 2 ? -1.f : 1.f;
+            const int ax = (axis + 1) % 3, ay = (axis + 2) % 3;
+            std::fill(depth.begin(), depth.end(), 1e30f);
+            auto project = [&](const Vertex &v, float &x, float &y, float &z) {
+                x = (v.position[ax] / 2.6f + 0.5f) * size;
+                y = (v.position[ay] / 2.6f + 0.5f) * size;
+                z = -sign * v.position[axis];
+            };
+            for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+                float x[3], y[3], z[3];
+                for (int k = 0; k < 3; ++k) project(vertices[indices[t + k]], x[k], y[k], z[k]);
+                float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+                if (sign < 0) area = -area;
+                if (area <= 0) continue; // back facing
+                const int x0 = std::max(0, int(std::floor(std::min({x[0], x[1], x[2]}))));
+                const int x1 = std::min(size - 1, int(std::ceil(std::max({x[0], x[1], x[2]}))));
+                const int y0 = std::max(0, int(std::floor(std::min({y[0], y[1], y[2]}))));
+                const int y1 = std::min(size - 1, int(std::ceil(std::max({y[0], y[1], y[2]}))));
+                const float signedArea = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+                for (int py = y0; py <= y1; ++py)
+                    for (int px = x0; px <= x1; ++px) {
+                        const float cx = px + 0.5f, cy = py + 0.5f;
+                        const float w0 = ((x[1] - cx) * (y[2] - cy) - (x[2] - cx) * (y[1] - cy)) / signedArea;
+                        const float w1 = ((x[2] - cx) * (y[0] - cy) - (x[0] - cx) * (y[2] - cy)) / signedArea;
+                        const float w2 = 1.f - w0 - w1;
+                        if (w0 < 0 || w1 < 0 || w2 < 0) continue;
+                        const float d = w0 * z[0] + w1 * z[1] + w2 * z[2];
+                        float &stored = depth[py * size + px];
+                        if (d < stored) {
+                            if (stored == 1e30f) covered++;
+                            stored = d;
+                            shaded++;
+                        }
+                    }
+            }
+        }
+        return covered ? double(shaded) / covered : 0;
+    }
+
+    void report(const char *stage, const std::vector<Vertex> &vertices, const std::vector<uint32_t> &indices,
+                double ms) {
+        const auto c16 = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size(), 16);
+        const auto c32 = AnalyzeVertexCache(indices.data(), indices.size(), vertices.size(), 32);
+        printf("%-14s %9zu %9zu %8.3f %8.3f %7.3f %11.0f %8.3f %9.1f\n", stage, vertices.size(), indices.size() / 3,
+               c16.acmr, c32.acmr, c16.atvr, fetchDistance(indices), overdraw(vertices, indices), ms);
+    }
+
+    template<typename F>
+    double timeMs(F &&f) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char **argv) {
+    const int rings = argc > 1 ? std::atoi(argv[1]) : 160;
+    std::vector<Vertex> vertices = makeSoup(rings);
+    std::vector<uint32_t> indices(vertices.size());
+    for (size_t i = 0; i < indices.size(); ++i) indices[i] = uint32_t(i);
+
+    printf("%-14s %9s %9s %8s %8s %7s %11s %8s %9s\n", "stage", "vertices", "triangles", "ACMR16", "ACMR32",
+           "ATVR16", "fetch[B]", "overdraw", "time[ms]");
+    report("soup", vertices, indices, 0);
+
+    std::vector<uint32_t> remap(vertices.size());
+    size_t unique = 0;
+    std::vector<Vertex> welded;
+    const double weldMs = timeMs([&] {
+        unique = GenerateVertexRemap(remap.data(), nullptr, indices.size(), vertices.data(), vertices.size(),
+                                     sizeof(Vertex));
+        welded.resize(unique);
+        RemapVertices(welded.data(), vertices.data(), vertices.size(), sizeof(Vertex), remap.data());
+        RemapIndices(indices.data(), nullptr, indices.size(), remap.data());
+    });
+    vertices.swap(welded);
+    report("weld", vertices, indices, weldMs);
+
+    std::vector<uint32_t> reordered(indices.size());
+    const double cacheMs = timeMs([&] {
+        OptimizeVertexCache(reordered.data(), indices.data(), indices.size(), vertices.size());
+    });
+    indices.swap(reordered);
+    report("vertex cache", vertices, indices, cacheMs);
+
+    const double overdrawMs = timeMs([&] {
+        OptimizeOverdraw(reordered.data(), indices.data(), indices.size(), vertices.data(), vertices.size(),
+                         sizeof(Vertex), 1.05f);
+    });
+    indices.swap(reordered);
+    report("overdraw", vertices, indices, overdrawMs);
+
+    std::vector<Vertex> fetched(vertices.size());
+    size_t used = 0;
+    const double fetchMs = timeMs([&] {
+        used = OptimizeVertexFetch(fetched.data(), indices.data(), indices.size(), vertices.data(),
+                                   vertices.size(), sizeof(Vertex));
+    });
+    fetched.resize(used);
+    vertices.swap(fetched);
+    report("vertex fetch", vertices, indices, fetchMs);
+
+    printf("index buffer: %zu bytes as 32-bit, %s\n", indices.size() * 4,
+           FitsIndex16(vertices.size()) ? (std::to_string(indices.size() * 2) + " bytes as 16-bit").c_str()
+                                         : "too many vertices for 16-bit");
+    return 0;
+}
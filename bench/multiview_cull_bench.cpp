@@ -0,0 +1,137 @@
+// Culling and draw-list building for split-screen views.
+// Scatters objects with random transforms and shader keys through a city-sized volume and builds the sorted
+// draw lists of a perspective view plus top, front and side orthographic views, like GUI3D::renderScene
+// with enableQuadView. Compares one culling pass per view (transform the bounds, test, sort the visible
+// objects, per view) with SC::MultiViewCuller, which transforms, sorts and traverses once for all views.
+// Usage: multiview_cull_bench [objects] [frames]
+#include "../GUI3D/view_culling.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace SC;
+
+namespace {
+    struct Mat4 { float m[16]; };
+
+    Mat4 multiply(const Mat4 &a, const Mat4 &b) {
+        Mat4 r;
+        for (int c = 0; c < 4; ++c)
+            for (int row = 0; row < 4; ++row) {
+                float sum = 0;
+                for (int k = 0; k < 4; ++k) sum += a.m[k * 4 + row] * b.m[c * 4 + k];
+                r.m[c * 4 + row] = sum;
+            }
+        return r;
+    }
+
+    Mat4 perspective(float fovy, float aspect, float n, float f) {
+        const float t = 1.f / std::tan(fovy / 2.f);
+        return {{t / aspect, 0, 0, 0, 0, t, 0, 0, 0, 0, -(f + n) / (f - n), -1, 0, 0, -2 * f * n / (f - n), 0}};
+    }
+
+    Mat4 ortho(float halfWidth, float halfHeight, float n, float f) {
+        return {{1 / halfWidth, 0, 0, 0, 0, 1 / halfHeight, 0, 0, 0, 0, -2 / (f - n), 0, 0, 0, -(f + n) / (f - n), 1}};
+    }
+
+    // right-handed look-at with the eye at e looking along the unit vector d, up u
+    Mat4 lookAlong(const float *e, const float *d, const float *u) {
+        float s[3] = {d[1] * u[2] - d[2] * u[1], d[2] * u[0] - d[0] * u[2], d[0] * u[1] - d[1] * u[0]};
+        const float l = std::sqrt(s[0] * s[0] + s[1] * s[1] + s[2] * s[2]);
+        for (float &v : s) v /= l;
+        const float up[3] = {s[1] * d[2] - s[2] * d[1], s[2] * d[0] - s[0] * d[2], s[0] * d[1] - s[1] * d[0]};
+        auto dot = [](const float *a, const float *b) { return a[0] * b[0] + a[1] * b[1] + a[2] * b[2]; };
+        return {{s[0], up[0], -d[0], 0, s[1], up[1], -d[1], 0, s[2], up[2], -d[2], 0,
+                 -dot(s, e), -dot(up, e), dot(d, e), 1}};
+    }
+
+    double nowMs() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+int main(int argc, char **argv) {
+    const int numObjects = argc > 1 ? std::atoi(argv[1]) : 100000;
+    const int frames = argc > 2 ? std::atoi(argv[2]) : 100;
+    const float extent = 500.f;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-extent, extent), scale(0.5f, 3.f);
+    std::uniform_int_distribution<uint32_t> shader(0, 15);
+    const float boundsMin[3] = {-1, -1, -1}, boundsMax[3] = {1, 1, 1};
+    std::vector<Mat4> transforms(numObjects);
+    std::vector<uint32_t> keys(numObjects);
+    for (int i = 0; i < numObjects; ++i) {
+        const float s = scale(rng);
+        transforms[i] = {{s, 0, 0, 0, 0, s, 0, 0, 0, 0, s, 0, position(rng), position(rng) * 0.05f, position(rng), 1}};
+        keys[i] = shader(rng);
+    }
+
+    const float up[3] = {0, 1, 0}, north[3] = {0, 0, -1};
+    const float down[3] = {0, -1, 0}, alongZ[3] = {0, 0, 1}, alongX[3] = {1, 0, 0};
+    const float top[3] = {0, extent, 0}, front[3] = {0, 0, -extent}, side[3] = {-extent, 0, 0};
+    const float halfView = extent * 0.25f;
+    std::vector<float> viewProjections(4 * 16);
+    auto setViews = [&](float t) {
+        const float eye[3] = {extent * 0.5f * std::cos(t), 20.f, extent * 0.5f * std::sin(t)};
+        const float dir[3] = {-std::sin(t), 0, std::cos(t)};
+        const Mat4 views[4] = {
+                multiply(perspective(0.8f, 16.f / 9.f, 0.1f, 1000.f), lookAlong(eye, dir, up)),
+                multiply(ortho(halfView, halfView, 0.1f, 2 * extent), lookAlong(top, down, north)),
+                multiply(ortho(halfView, halfView, 0.1f, 2 * extent), lookAlong(front, alongZ, up)),
+                multiply(ortho(halfView, halfView, 0.1f, 2 * extent), lookAlong(side, alongX, up))};
+        for (int v = 0; v < 4; ++v) std::copy(views[v].m, views[v].m + 16, viewProjections.begin() + v * 16);
+    };
+
+    // one independent pass per view, as rendering the scene once per viewport does
+    std::vector<CullItem> items(numObjects);
+    std::vector<uint32_t> visible;
+    size_t separateDraws = 0;
+    double start = nowMs();
+    for (int f = 0; f < frames; ++f) {
+        setViews(f * 0.01f);
+        for (int v = 0; v < 4; ++v) {
+            const Frustum frustum = Frustum::fromMatrix(&viewProjections[v * 16]);
+            visible.clear();
+            for (int i = 0; i < numObjects; ++i) {
+                items[i] = CullItem::fromBounds(boundsMin, boundsMax, transforms[i].m, keys[i]);
+                if (frustum.intersectsSphere(items[i].center, items[i].radius)) visible.push_back(uint32_t(i));
+            }
+            std::stable_sort(visible.begin(), visible.end(),
+                             [&](uint32_t a, uint32_t b) { return items[a].sortKey < items[b].sortKey; });
+            separateDraws += visible.size();
+        }
+    }
+    const double separateMs = (nowMs() - start) / frames;
+
+    // shared traversal, and the single view for reference
+    MultiViewCuller culler;
+    size_t sharedDraws = 0;
+    double singleMs = 0, sharedMs = 0;
+    for (int views : {1, 4}) {
+        start = nowMs();
+        for (int f = 0; f < frames; ++f) {
+            setViews(f * 0.01f);
+            for (int i = 0; i < numObjects; ++i)
+                items[i] = CullItem::fromBounds(boundsMin, boundsMax, transforms[i].m, keys[i]);
+            culler.setViews(viewProjections.data(), views);
+            culler.cull(items.data(), numObjects);
+            if (views == 4)
+                for (int v = 0; v < 4; ++v) sharedDraws += culler.visible(v).size();
+        }
+        (views == 1 ? singleMs : sharedMs) = (nowMs() - start) / frames;
+    }
+
+    printf("%d objects, 4 views, %d frames\n", numObjects, frames);
+    printf("visible per frame: %.0f (separate) %.0f (shared)\n", double(separateDraws) / frames,
+           double(sharedDraws) / frames);
+    printf("1 view:                 %.2f ms\n", singleMs);
+    printf("4 views, separate:      %.2f ms (%.2fx one view)\n", separateMs, separateMs / singleMs);
+    printf("4 views, shared:        %.2f ms (%.2fx one view)\n", sharedMs, sharedMs / singleMs);
+    return 0;
+}
@@ -0,0 +1,80 @@
+// Throughput of SC::ComputeNormalMap for the scalar reference and the SIMD/multi-threaded paths.
+// Usage: normal_map_bench [iterations]
+#include "../GUI3D/normal_map.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace SC;
+
+namespace {
+    /// A wavy surface in front of a pinhole camera with a few holes of invalid depth.
+    void makeVertexMap(int width, int height, std::vector<float> &vertexMap) {
+        vertexMap.resize(size_t(width) * height * 3);
+        const float fx = 0.8f * width, fy = fx, cx = 0.5f * width, cy = 0.5f * height;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                float *v = &vertexMap[(size_t(y) * width + x) * 3];
+                float z = 2.f + 0.2f * std::sin(x * 0.02f) * std::cos(y * 0.03f);
+                if ((x / 32 + y / 32) % 17 == 0) z = 0; // holes
+                v[0] = (x - cx) / fx * z;
+                v[1] = (y - cy) / fy * z;
+                v[2] = z;
+            }
+        }
+    }
+
+    double run(int width, int height, const std::vector<float> &vertexMap, std::vector<float> &normalMap,
+               NormalMapBackend backend, int threads, int iterations) {
+        ComputeNormalMap(width, height, vertexMap.data(), normalMap.data(), backend, threads); // warm up
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+            ComputeNormalMap(width, height, vertexMap.data(), normalMap.data(), backend, threads);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return double(width) * height * iterations / elapsed.count() * 1e-6;
+    }
+
+    float maxDifference(const std::vector<float> &a, const std::vector<float> &b) {
+        float diff = 0;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (std::isnan(a[i]) && std::isnan(b[i])) continue;
+            diff = std::max(diff, std::abs(a[i] - b[i]));
+        }
+        return diff;
+    }
+}
+
+int main(int argc, char **argv) {
+    const int iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+    const int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    const int sizes[][2] = {{640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}};
+    const NormalMapBackend backends[] = {NormalMapBackend::Scalar, NormalMapBackend::SSE, NormalMapBackend::AVX2};
+
+    printf("%-10s %-8s %8s %12s %8s %10s\n", "size", "backend", "threads", "MPixel/s", "speedup", "max diff");
+    for (const auto &size : sizes) {
+        const int width = size[0], height = size[1];
+        std::vector<float> vertexMap, reference(size_t(width) * height * 3), normalMap(reference.size());
+        makeVertexMap(width, height, vertexMap);
+        const double scalar = run(width, height, vertexMap, reference, NormalMapBackend::Scalar, 1, iterations);
+
+        char name[32];
+        snprintf(name, sizeof(name), "%dx%d", width, height);
+        std::vector<int> threadCounts = {1};
+        if (hardwareThreads > 1) threadCounts.push_back(hardwareThreads);
+        for (auto backend : backends) {
+            if (!isAvailable(backend)) continue;
+            for (int threads : threadCounts) {
+                const bool isReference = backend == NormalMapBackend::Scalar && threads == 1;
+                const double mps = isReference ? scalar :
+                                   run(width, height, vertexMap, normalMap, backend, threads, iterations);
+                printf("%-10s %-8s %8d %12.1f %8.2f %10.2e\n", name, toString(backend), threads, mps, mps / scalar,
+                       isReference ? 0.f : maxDifference(reference, normalMap));
+            }
+        }
+    }
+    return 0;
+}
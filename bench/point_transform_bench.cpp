@@ -0,0 +1,113 @@
+// Transforming, bounding and frustum-testing a large point cloud by a pose on the CPU: naive glm loops and
+// Eigen on the same memory (through the zero-copy views of eigen_glm.hpp) against the SC::TransformPoints,
+// SC::ComputeBounds and SC::CullPoints kernels per backend.
+// Usage: point_transform_bench [points] [iterations]
+#include "../GUI3D/point_transform.hpp"
+#include "../GUI3D/eigen_glm.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace SC;
+
+namespace {
+    template <typename F>
+    double timeMs(int iterations, F &&f) {
+        f(); // warm up
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i) f();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+    }
+
+    float maxDifference(const std::vector<glm::vec3> &a, const std::vector<glm::vec3> &b) {
+        float diff = 0;
+        for (size_t i = 0; i < a.size(); ++i)
+            for (int k = 0; k < 3; ++k) diff = std::max(diff, std::abs(a[i][k] - b[i][k]));
+        return diff;
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t numPoints = argc > 1 ? size_t(std::atoll(argv[1])) : 4000000;
+    const int iterations = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-20.f, 20.f);
+    std::vector<glm::vec3> points(numPoints), reference(numPoints), out(numPoints);
+    for (auto &p : points) p = glm::vec3(position(rng), position(rng), position(rng));
+    glm::mat4 pose = glm::rotate(glm::mat4(1.f), 0.3f, glm::vec3(0.f, 1.f, 0.f));
+    pose[3] = glm::vec4(1.f, 2.f, 3.f, 1.f);
+    glm::mat4 viewProjection = glm::perspective(0.8f, 16.f / 9.f, 0.1f, 100.f) *
+                               glm::lookAt(glm::vec3(0.f, 0.f, 30.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+    const Frustum frustum = Frustum::fromMatrix(&viewProjection[0][0]);
+    const float *in = &points[0][0];
+    std::vector<uint32_t> indices(numPoints);
+
+    printf("%zu points, %d iterations, ms per call\n", numPoints, iterations);
+    printf("%-12s %10s %10s %10s %10s\n", "path", "transform", "bounds", "cull", "max diff");
+
+    // naive glm: a mat4 * vec4 per point, min/max and a plane loop per point
+    const double glmTransform = timeMs(iterations, [&] {
+        for (size_t i = 0; i < numPoints; ++i) reference[i] = glm::vec3(pose * glm::vec4(points[i], 1.f));
+    });
+    glm::vec3 lo, hi;
+    const double glmBounds = timeMs(iterations, [&] {
+        lo = hi = points[0];
+        for (const auto &p : points) {
+            lo = glm::min(lo, p);
+            hi = glm::max(hi, p);
+        }
+    });
+    size_t glmCount = 0;
+    const double glmCull = timeMs(iterations, [&] {
+        glmCount = 0;
+        for (size_t i = 0; i < numPoints; ++i) {
+            bool bInside = true;
+            for (const auto &plane : frustum.planes)
+                bInside &= glm::dot(glm::vec3(plane[0], plane[1], plane[2]), points[i]) + plane[3] >= 0;
+            if (bInside) indices[glmCount++] = uint32_t(i);
+        }
+    });
+    printf("%-12s %10.3f %10.3f %10.3f %10s\n", "glm", glmTransform, glmBounds, glmCull, "-");
+
+    // Eigen on the glm memory, no copies
+    const auto eigenIn = asEigen(points);
+    auto eigenOut = asEigen(out);
+    const Eigen::Map<const Eigen::Matrix4f> eigenPose = asEigen(static_cast<const glm::mat4 &>(pose));
+    const double eigenTransform = timeMs(iterations, [&] {
+        eigenOut.noalias() = (eigenPose.topLeftCorner<3, 3>() * eigenIn).colwise() + eigenPose.topRightCorner<3, 1>();
+    });
+    Eigen::Vector3f eigenLo, eigenHi;
+    const double eigenBounds = timeMs(iterations, [&] {
+        eigenLo = eigenIn.rowwise().minCoeff();
+        eigenHi = eigenIn.rowwise().maxCoeff();
+    });
+    printf("%-12s %10.3f %10.3f %10s %10.2e\n", "Eigen", eigenTransform, eigenBounds, "-",
+           maxDifference(reference, out));
+
+    for (PointBackend backend : {PointBackend::Scalar, PointBackend::SSE, PointBackend::AVX2}) {
+        if (!isAvailable(backend)) continue;
+        const double transform = timeMs(iterations, [&] {
+            TransformPoints(&pose[0][0], in, &out[0][0], numPoints, backend);
+        });
+        float boundsMin[3], boundsMax[3];
+        const double bounds = timeMs(iterations, [&] { ComputeBounds(in, numPoints, boundsMin, boundsMax, backend); });
+        size_t count = 0;
+        const double cull = timeMs(iterations, [&] {
+            count = CullPoints(frustum, in, numPoints, indices.data(), backend);
+        });
+        if (count != glmCount) printf("%s: %zu points inside instead of %zu\n", toString(backend), count, glmCount);
+        for (int k = 0; k < 3; ++k)
+            if (boundsMin[k] != lo[k] || boundsMax[k] != hi[k]) printf("%s: bounds differ\n", toString(backend));
+        printf("%-12s %10.3f %10.3f %10.3f %10.2e\n", toString(backend), transform, bounds, cull,
+               maxDifference(reference, out));
+    }
+    return 0;
+}
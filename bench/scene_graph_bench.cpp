@@ -0,0 +1,133 @@
+// World matrix updates of a keyframe map: K keyframes as roots with C child nodes each (observations,
+// meshes), 100k nodes by default. Compares recomputing every world matrix each frame from per-node 4x4
+// locals (what per-object model matrices amount to) with SC::SceneGraph updating only the dirty subtrees,
+// for one moved keyframe and for every keyframe moved (e.g. after a loop closure).
+// Usage: scene_graph_bench [keyframes] [children] [frames]
+#include "../GUI3D/scene_graph.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace SC;
+
+namespace {
+    struct Mat4 { float m[16]; };
+
+    Mat4 multiply(const Mat4 &a, const Mat4 &b) {
+        Mat4 r;
+        for (int c = 0; c < 4; ++c)
+            for (int row = 0; row < 4; ++row) {
+                float sum = 0;
+                for (int k = 0; k < 4; ++k) sum += a.m[k * 4 + row] * b.m[c * 4 + k];
+                r.m[c * 4 + row] = sum;
+            }
+        return r;
+    }
+
+    Mat4 fromTRS(const float *t, const float *q, float s) {
+        const float x = q[0], y = q[1], z = q[2], w = q[3];
+        return {{(1 - 2 * (y * y + z * z)) * s, 2 * (x * y + w * z) * s, 2 * (x * z - w * y) * s, 0,
+                 2 * (x * y - w * z) * s, (1 - 2 * (x * x + z * z)) * s, 2 * (y * z + w * x) * s, 0,
+                 2 * (x * z + w * y) * s, 2 * (y * z - w * x) * s, (1 - 2 * (x * x + y * y)) * s, 0,
+                 t[0], t[1], t[2], 1}};
+    }
+
+    double nowMs() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+int main(int argc, char **argv) {
+    const int numKeyframes = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const int numChildren = argc > 2 ? std::atoi(argv[2]) : 99;
+    const int frames = argc > 3 ? std::atoi(argv[3]) : 100;
+    const int numNodes = numKeyframes * (numChildren + 1);
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> position(-50.f, 50.f), unit(-1.f, 1.f);
+    struct Node { float t[3], q[4]; int parent; };
+    std::vector<Node> nodes;
+    nodes.reserve(numNodes);
+    auto randomNode = [&](int parent) {
+        Node node;
+        for (float &v : node.t) v = parent < 0 ? position(rng) : unit(rng);
+        float length = 0;
+        for (float &v : node.q) {
+            v = unit(rng);
+            length += v * v;
+        }
+        for (float &v : node.q) v /= std::sqrt(length);
+        node.parent = parent;
+        return node;
+    };
+    for (int k = 0; k < numKeyframes; ++k) {
+        const int root = int(nodes.size());
+        nodes.push_back(randomNode(-1));
+        for (int c = 0; c < numChildren; ++c) nodes.push_back(randomNode(root));
+    }
+
+    // baseline: locals rebuilt and every world matrix recomputed each frame, parents first
+    std::vector<Mat4> world(numNodes);
+    double start = nowMs();
+    for (int f = 0; f < frames; ++f) {
+        nodes[(f * 37) % numNodes].t[0] += 0.01f;
+        for (int i = 0; i < numNodes; ++i) {
+            const Node &node = nodes[i];
+            const Mat4 local = fromTRS(node.t, node.q, 1.f);
+            world[i] = node.parent < 0 ? local : multiply(world[node.parent], local);
+        }
+    }
+    const double fullMs = (nowMs() - start) / frames;
+
+    SceneGraph graph;
+    std::vector<SceneGraph::NodeId> ids(numNodes), keyframes;
+    for (int i = 0; i < numNodes; ++i) {
+        const Node &node = nodes[i];
+        ids[i] = graph.create(node.parent < 0 ? SceneGraph::kNone : ids[node.parent]);
+        graph.setTranslation(ids[i], node.t[0], node.t[1], node.t[2]);
+        graph.setRotation(ids[i], node.q[0], node.q[1], node.q[2], node.q[3]);
+        if (node.parent < 0) keyframes.push_back(ids[i]);
+    }
+    start = nowMs();
+    graph.update();
+    const double buildMs = nowMs() - start;
+
+    // check against the baseline
+    double maxError = 0;
+    for (int i = 0; i < numNodes; ++i)
+        for (int k = 0; k < 16; ++k)
+            maxError = std::max(maxError, double(std::fabs(graph.world(ids[i])[k] - world[i].m[k])));
+
+    size_t oneCount = 0, allCount = 0;
+    start = nowMs();
+    for (int f = 0; f < frames; ++f) {
+        const Node &node = nodes[size_t(f % numKeyframes) * (numChildren + 1)];
+        graph.setTranslation(keyframes[f % numKeyframes], node.t[0], node.t[1] + 0.01f * f, node.t[2]);
+        graph.update();
+        oneCount += graph.lastUpdateCount();
+    }
+    const double oneMs = (nowMs() - start) / frames;
+
+    start = nowMs();
+    for (int f = 0; f < frames; ++f) {
+        for (int k = 0; k < numKeyframes; ++k) {
+            const Node &node = nodes[size_t(k) * (numChildren + 1)];
+            graph.setTranslation(keyframes[k], node.t[0], node.t[1] + 0.01f * f, node.t[2]);
+        }
+        graph.update();
+        allCount += graph.lastUpdateCount();
+    }
+    const double allMs = (nowMs() - start) / frames;
+
+    printf("%d nodes (%d keyframes x %d children), %d frames, max error vs baseline %g\n", numNodes, numKeyframes,
+           numChildren + 1, frames, maxError);
+    printf("baseline, all nodes every frame:  %8.3f ms\n", fullMs);
+    printf("scene graph, first update:        %8.3f ms\n", buildMs);
+    printf("scene graph, one keyframe moved:  %8.3f ms (%zu nodes)\n", oneMs, oneCount / frames);
+    printf("scene graph, all keyframes moved: %8.3f ms (%zu nodes)\n", allMs, allCount / frames);
+    return 0;
+}
@@ -0,0 +1,55 @@
+// SC::KeyBindings and SC::InputQueue without a window. Exits non-zero on the first failed check.
+#include "../GUI3D/input_events.hpp"
+
+#include <cstdio>
+
+namespace {
+    int failures = 0;
+
+    void check(bool condition, const char *what) {
+        if (condition) return;
+        std::fprintf(stderr, "FAILED: %s\n", what);
+        failures++;
+    }
+
+    SC::InputEvent key(int code, int action, int mods = 0) {
+        SC::InputEvent event;
+        event.type = SC::InputEvent::Key;
+        event.code = code;
+        event.action = action;
+        event.mods = mods;
+        return event;
+    }
+}
+
+int main() {
+    {
+        // nothing bound yet: the lookup table has not been built
+        SC::KeyBindings bindings;
+        check(bindings.dispatch(key(65, 1)) == 0, "dispatch on an empty table calls nothing");
+        check(bindings.isDown(65), "dispatch on an empty table tracks the key");
+        check(bindings.dispatch(key(65, 0)) == 0 && !bindings.isDown(65), "release on an empty table");
+    }
+    {
+        SC::KeyBindings bindings;
+        int any = 0, chord = 0;
+        bindings.bind(83, SC::KeyBindings::kAnyMods, [&] { any++; });
+        bindings.bind(83, 2, [&] { chord++; }); // control
+        check(bindings.dispatch(key(83, 1)) == 1 && any == 1, "any-modifier binding fires");
+        check(bindings.dispatch(key(83, 1, 2)) == 1 && chord == 1 && any == 1, "chord wins over any-modifier");
+        check(bindings.dispatch(key(83, 2)) == 0, "no repeat unless asked");
+        bindings.clear();
+        check(bindings.dispatch(key(83, 1)) == 0, "dispatch after clear calls nothing");
+    }
+    {
+        SC::KeyBindings bindings;
+        SC::InputQueue queue(4);
+        int handled = 0;
+        queue.record(key(70, 1));
+        queue.record(key(70, 0));
+        check(queue.process(bindings, [&](const SC::InputEvent &) { handled++; }) == 2 && handled == 2,
+              "queued events reach the handler in order");
+    }
+    if (failures == 0) std::printf("input_events_test: all passed\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+// Offline BCn/KTX2 conversion into the texture cache used by glUtil::CompressedTextureCache.
+//
+//  ktx2_convert [--format bc1|bc3|bc5] [--srgb] [--no-mips] [--threads n] --cache <dir> <images...>
+//
+// Each input is written to <dir>/<content hash>.ktx2, so the application finds it without a manifest.
+// Already converted inputs are skipped.
+
+#include <stb_image.h> // implemented in GUI3D
+
+#include "texture_compression.hpp"
+#include <sys/stat.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+static void usage() {
+    std::cout << "usage: ktx2_convert [--format bc1|bc3|bc5] [--srgb] [--no-mips] [--threads n] --cache <dir> <images...>"
+              << std::endl;
+}
+
+int main(int argc, char **argv) {
+    SC::BlockFormat format = SC::BlockFormat::BC1;
+    bool bSRGB = false, bMipmaps = true;
+    int threads = 0;
+    std::string cacheDir;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--format" && i + 1 < argc) {
+            const std::string f = argv[++i];
+            if (f == "bc1") format = SC::BlockFormat::BC1;
+            else if (f == "bc3") format = SC::BlockFormat::BC3;
+            else if (f == "bc5") format = SC::BlockFormat::BC5;
+            else { usage(); return 1; }
+        } else if (arg == "--srgb") bSRGB = true;
+        else if (arg == "--no-mips") bMipmaps = false;
+        else if (arg == "--threads" && i + 1 < argc) threads = std::atoi(argv[++i]);
+        else if (arg == "--cache" && i + 1 < argc) cacheDir = argv[++i];
+        else if (arg.size() > 1 && arg[0] == '-') { usage(); return 1; }
+        else inputs.push_back(arg);
+    }
+    if (cacheDir.empty() || inputs.empty()) {
+        usage();
+        return 1;
+    }
+    if (cacheDir.back() != '/') cacheDir += '/';
+    mkdir(cacheDir.c_str(), 0755);
+
+    int failed = 0;
+    for (const auto &input : inputs) {
+        try {
+            const std::string output = cacheDir + SC::CacheFileName(SC::HashTextureSource(input, format, bSRGB));
+            struct stat info;
+            if (stat(output.c_str(), &info) == 0) {
+                std::cout << input << ": cached " << output << std::endl;
+                continue;
+            }
+            int width, height, channels;
+            unsigned char *data = stbi_load(input.c_str(), &width, &height, &channels, 4);
+            if (!data) throw std::runtime_error("cannot decode " + input);
+            const auto start = std::chrono::steady_clock::now();
+            SC::CompressedImage image = SC::CompressImage(data, width, height, format, bSRGB, bMipmaps, threads);
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            stbi_image_free(data);
+            SC::WriteKTX2(output, image);
+
+            size_t bytes = 0;
+            for (const auto &level : image.levels) bytes += level.size();
+            std::cout << input << ": " << width << "x" << height << " " << SC::toString(format)
+                      << (bSRGB ? " sRGB" : "") << ", " << image.levels.size() << " levels, " << bytes << " bytes ("
+                      << double(size_t(width) * height * 4) / bytes << ":1 vs RGBA8 level 0), " << ms << " ms -> "
+                      << output << std::endl;
+        } catch (const std::exception &e) {
+            std::cout << "ERROR::KTX2CONVERT::" << e.what() << std::endl;
+            failed++;
+        }
+    }
+    return failed ? 1 : 0;
+}